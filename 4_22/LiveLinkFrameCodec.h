@@ -0,0 +1,454 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LiveLinkTypes.h"
+#include "Math/Float16.h"
+
+#include <cmath>
+
+/**
+* Compact frame encoding for links that can't take full precision transforms.
+*
+* Rotations use smallest-three packing: the largest quaternion component is dropped (2 bit index, made positive) and
+* the other three are quantized over [-1/sqrt(2), 1/sqrt(2)]. Translations are fixed point over the subject's bounding
+* range, which only grows, so a still joint keeps the same quantized value from frame to frame. An axis that would need
+* more than 24 bits goes out as a raw float instead. Scale costs one bit when it is 1 and full floats otherwise. Curve
+* values are half floats, or full floats when half precision can't hold the configured curve error. Bit counts are
+* derived from the configured maximum errors.
+*
+*	uint16 NumTransforms, uint16 NumCurves, uint8 RotationBits (top bit set for full float curves),
+*	uint8 PositionBits[3] (32 for raw floats), float PositionMin[3], float PositionExtent[3], then the bit packed
+*	transforms and curve values
+*
+* Every frame carries its range so it decodes on its own, e.g. when seeking in a take.
+*/
+namespace LiveLinkFrameCodec
+{
+	enum class EEncoding : uint8
+	{
+		Full,
+		Compact,
+	};
+
+	struct FSettings
+	{
+		EEncoding Encoding = EEncoding::Full;
+
+		// In cm and degrees, curve errors are absolute
+		float MaxPositionError = 0.01f;
+		float MaxRotationError = 0.01f;
+		float MaxCurveError = 0.001f;
+		float ScaleTolerance = 0.0001f;
+	};
+
+	const int32 HeaderSize = sizeof(uint16) * 2 + sizeof(uint8) * 4 + sizeof(float) * 6;
+	const double SmallestThreeRange = 0.70710678118654752;
+	const int32 MaxQuantizedBits = 24;
+	const int32 RawFloatBits = 32;
+	const uint8 FloatCurvesFlag = 0x80;
+
+	/**
+	* Bounding range of a subject's translations, kept by the encoder between frames. It grows with some headroom
+	* whenever a frame leaves it, so the quantization grid only moves when it has to.
+	*/
+	struct FPositionRange
+	{
+		FVector Min = FVector::ZeroVector;
+		FVector Max = FVector::ZeroVector;
+		bool bValid = false;
+
+		/** Returns true when the range had to grow */
+		bool Include(const TArray<FTransform>& Transforms)
+		{
+			if (Transforms.Num() == 0)
+			{
+				return false;
+			}
+
+			FVector FrameMin = Transforms[0].GetTranslation();
+			FVector FrameMax = FrameMin;
+			for (int32 Idx = 1; Idx < Transforms.Num(); ++Idx)
+			{
+				const FVector Translation = Transforms[Idx].GetTranslation();
+				FrameMin = FrameMin.ComponentMin(Translation);
+				FrameMax = FrameMax.ComponentMax(Translation);
+			}
+
+			bool bGrew = false;
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				if (bValid && FrameMin[Axis] >= Min[Axis] && FrameMax[Axis] <= Max[Axis])
+				{
+					continue;
+				}
+
+				const float NewMin = bValid ? FMath::Min(FrameMin[Axis], Min[Axis]) : FrameMin[Axis];
+				const float NewMax = bValid ? FMath::Max(FrameMax[Axis], Max[Axis]) : FrameMax[Axis];
+				const float Headroom = FMath::Max(0.25f * (NewMax - NewMin), 1.0f);
+				Min[Axis] = NewMin - Headroom;
+				Max[Axis] = NewMax + Headroom;
+				bGrew = true;
+			}
+			bValid = true;
+			return bGrew;
+		}
+	};
+
+	/** Little endian bit stream appended to a byte array */
+	class FBitPacker
+	{
+	public:
+		explicit FBitPacker(TArray<uint8>& InBuffer)
+			: Buffer(InBuffer)
+			, Scratch(0)
+			, ScratchBits(0)
+		{}
+
+		void Write(uint32 Value, int32 NumBits)
+		{
+			Scratch |= (uint64)(Value & (NumBits == 32 ? MAX_uint32 : ((1u << NumBits) - 1))) << ScratchBits;
+			ScratchBits += NumBits;
+			while (ScratchBits >= 8)
+			{
+				Buffer.Add((uint8)Scratch);
+				Scratch >>= 8;
+				ScratchBits -= 8;
+			}
+		}
+
+		void Flush()
+		{
+			if (ScratchBits > 0)
+			{
+				Buffer.Add((uint8)Scratch);
+				Scratch = 0;
+				ScratchBits = 0;
+			}
+		}
+
+	private:
+		TArray<uint8>& Buffer;
+		uint64 Scratch;
+		int32 ScratchBits;
+	};
+
+	class FBitUnpacker
+	{
+	public:
+		FBitUnpacker(const uint8* InData, int32 InNumBytes)
+			: Data(InData)
+			, NumBytes(InNumBytes)
+			, BytePos(0)
+			, Scratch(0)
+			, ScratchBits(0)
+			, bError(false)
+		{}
+
+		uint32 Read(int32 NumBits)
+		{
+			while (ScratchBits < NumBits)
+			{
+				if (BytePos >= NumBytes)
+				{
+					bError = true;
+					return 0;
+				}
+				Scratch |= (uint64)Data[BytePos++] << ScratchBits;
+				ScratchBits += 8;
+			}
+
+			const uint32 Value = (uint32)(Scratch & (NumBits == 32 ? MAX_uint32 : ((1ull << NumBits) - 1)));
+			Scratch >>= NumBits;
+			ScratchBits -= NumBits;
+			return Value;
+		}
+
+		bool HasError() const { return bError; }
+
+	private:
+		const uint8* Data;
+		int32 NumBytes;
+		int32 BytePos;
+		uint64 Scratch;
+		int32 ScratchBits;
+		bool bError;
+	};
+
+	inline uint32 Quantize(double Value, double Min, double Extent, int32 NumBits)
+	{
+		const double MaxValue = (double)((1ull << NumBits) - 1);
+		const double Alpha = FMath::Clamp((Value - Min) / Extent, 0.0, 1.0);
+		return (uint32)FMath::RoundToDouble(Alpha * MaxValue);
+	}
+
+	inline double Dequantize(uint32 Value, double Min, double Extent, int32 NumBits)
+	{
+		const double MaxValue = (double)((1ull << NumBits) - 1);
+		return Min + Extent * (Value / MaxValue);
+	}
+
+	/**
+	* The dropped component is at least 1/2, which bounds the quaternion error to about 4.73 quantization steps and
+	* the angular error to twice that.
+	*/
+	inline int32 GetRotationBits(float MaxRotationError)
+	{
+		const double MaxErrorRadians = FMath::Max(FMath::DegreesToRadians((double)MaxRotationError), 1e-7);
+		const double NumSteps = 2.0 * 4.73 * 2.0 * SmallestThreeRange / MaxErrorRadians;
+		return FMath::Clamp((int32)std::ceil(std::log2(NumSteps + 1.0)), 4, 24);
+	}
+
+	/** RawFloatBits when fixed point would need more than MaxQuantizedBits, floats are exact to the source then */
+	inline int32 GetPositionBits(double Extent, float MaxPositionError)
+	{
+		if (Extent <= 0.0)
+		{
+			return 0;
+		}
+		// Per axis error is half a step, spread over three axes
+		const double NumSteps = Extent * 1.7320508 / (2.0 * FMath::Max((double)MaxPositionError, 1e-6));
+		const int32 NumBits = FMath::Max((int32)std::ceil(std::log2(NumSteps + 1.0)), 1);
+		return NumBits <= MaxQuantizedBits ? NumBits : RawFloatBits;
+	}
+
+	/**
+	* Half floats keep 10 mantissa bits and the conversion truncates, so the error stays below one step at the largest
+	* value. Full floats are used when that step is larger than MaxCurveError or the values don't fit in a half.
+	*/
+	inline bool NeedsFloatCurves(const TArray<FLiveLinkCurveElement>& Curves, float MaxCurveError)
+	{
+		if (Curves.Num() == 0)
+		{
+			return false;
+		}
+		if (MaxCurveError <= 0.f)
+		{
+			return true;
+		}
+
+		float MaxAbsValue = 0.f;
+		for (const FLiveLinkCurveElement& Curve : Curves)
+		{
+			const float AbsValue = FMath::Abs(Curve.CurveValue);
+			if (!(AbsValue < 65504.f))
+			{
+				return true;
+			}
+			MaxAbsValue = FMath::Max(MaxAbsValue, AbsValue);
+		}
+
+		const double Exponent = FMath::Max(std::floor(std::log2(FMath::Max((double)MaxAbsValue, 1e-30))), -14.0);
+		return std::exp2(Exponent - 10.0) > MaxCurveError;
+	}
+
+	inline void WriteFloat(FBitPacker& Packer, float Value)
+	{
+		uint32 Bits;
+		FMemory::Memcpy(&Bits, &Value, sizeof(float));
+		Packer.Write(Bits, 32);
+	}
+
+	inline float ReadFloat(FBitUnpacker& Unpacker)
+	{
+		const uint32 Bits = Unpacker.Read(32);
+		float Value;
+		FMemory::Memcpy(&Value, &Bits, sizeof(float));
+		return Value;
+	}
+
+	/** The header stores both counts as uint16, larger frames have to go out with the Full encoding */
+	inline bool CanEncode(int32 NumTransforms, int32 NumCurves)
+	{
+		return NumTransforms <= MAX_uint16 && NumCurves <= MAX_uint16;
+	}
+
+	/**
+	* Appends the compact encoding of a frame's transforms and curve values to Out. Range is the subject's position
+	* range, grown to fit the frame first. Returns false and leaves Out and Range untouched when CanEncode fails.
+	*/
+	inline bool Encode(const TArray<FTransform>& Transforms, const TArray<FLiveLinkCurveElement>& Curves, const FSettings& Settings, FPositionRange& Range, TArray<uint8>& Out)
+	{
+		if (!CanEncode(Transforms.Num(), Curves.Num()))
+		{
+			return false;
+		}
+
+		Range.Include(Transforms);
+		const FVector PositionMin = Range.Min;
+		const FVector PositionExtent = Range.Max - Range.Min;
+
+		const int32 RotationBits = GetRotationBits(Settings.MaxRotationError);
+		int32 PositionBits[3];
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			PositionBits[Axis] = GetPositionBits(PositionExtent[Axis], Settings.MaxPositionError);
+		}
+		const bool bFloatCurves = NeedsFloatCurves(Curves, Settings.MaxCurveError);
+
+		const uint16 Counts[2] = { (uint16)Transforms.Num(), (uint16)Curves.Num() };
+		const uint8 Bits[4] = { (uint8)(RotationBits | (bFloatCurves ? FloatCurvesFlag : 0)), (uint8)PositionBits[0], (uint8)PositionBits[1], (uint8)PositionBits[2] };
+		Out.Append(reinterpret_cast<const uint8*>(Counts), sizeof(Counts));
+		Out.Append(Bits, sizeof(Bits));
+		Out.Append(reinterpret_cast<const uint8*>(&PositionMin.X), sizeof(float) * 3);
+		Out.Append(reinterpret_cast<const uint8*>(&PositionExtent.X), sizeof(float) * 3);
+
+		FBitPacker Packer(Out);
+		for (const FTransform& Transform : Transforms)
+		{
+			const FQuat Rotation = Transform.GetRotation().GetNormalized();
+			double Components[4] = { Rotation.X, Rotation.Y, Rotation.Z, Rotation.W };
+
+			int32 Largest = 0;
+			for (int32 Idx = 1; Idx < 4; ++Idx)
+			{
+				if (FMath::Abs(Components[Idx]) > FMath::Abs(Components[Largest]))
+				{
+					Largest = Idx;
+				}
+			}
+			const double Sign = Components[Largest] < 0.0 ? -1.0 : 1.0;
+
+			Packer.Write(Largest, 2);
+			for (int32 Idx = 0; Idx < 4; ++Idx)
+			{
+				if (Idx != Largest)
+				{
+					Packer.Write(Quantize(Components[Idx] * Sign, -SmallestThreeRange, 2.0 * SmallestThreeRange, RotationBits), RotationBits);
+				}
+			}
+
+			const FVector Translation = Transform.GetTranslation();
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				if (PositionBits[Axis] == RawFloatBits)
+				{
+					WriteFloat(Packer, Translation[Axis]);
+				}
+				else if (PositionBits[Axis] > 0)
+				{
+					Packer.Write(Quantize(Translation[Axis], PositionMin[Axis], PositionExtent[Axis], PositionBits[Axis]), PositionBits[Axis]);
+				}
+			}
+
+			const FVector Scale = Transform.GetScale3D();
+			const bool bUnitScale = Scale.Equals(FVector::OneVector, Settings.ScaleTolerance);
+			Packer.Write(bUnitScale ? 1 : 0, 1);
+			if (!bUnitScale)
+			{
+				WriteFloat(Packer, Scale.X);
+				WriteFloat(Packer, Scale.Y);
+				WriteFloat(Packer, Scale.Z);
+			}
+		}
+
+		for (const FLiveLinkCurveElement& Curve : Curves)
+		{
+			if (bFloatCurves)
+			{
+				WriteFloat(Packer, Curve.CurveValue);
+			}
+			else
+			{
+				const FFloat16 HalfValue(Curve.CurveValue);
+				Packer.Write(HalfValue.Encoded, 16);
+			}
+		}
+		Packer.Flush();
+		return true;
+	}
+
+	/** Decodes transforms and curve values, curve names are left for the caller to fill in */
+	inline bool Decode(const uint8* Data, int32 NumBytes, TArray<FTransform>& OutTransforms, TArray<FLiveLinkCurveElement>& OutCurves)
+	{
+		if (NumBytes < HeaderSize)
+		{
+			return false;
+		}
+
+		uint16 Counts[2];
+		uint8 Bits[4];
+		FVector PositionMin;
+		FVector PositionExtent;
+		FMemory::Memcpy(Counts, Data, sizeof(Counts));
+		FMemory::Memcpy(Bits, Data + sizeof(Counts), sizeof(Bits));
+		FMemory::Memcpy(&PositionMin.X, Data + sizeof(Counts) + sizeof(Bits), sizeof(float) * 3);
+		FMemory::Memcpy(&PositionExtent.X, Data + sizeof(Counts) + sizeof(Bits) + sizeof(float) * 3, sizeof(float) * 3);
+
+		const int32 RotationBits = Bits[0] & ~FloatCurvesFlag;
+		const bool bFloatCurves = (Bits[0] & FloatCurvesFlag) != 0;
+		if (RotationBits > MaxQuantizedBits)
+		{
+			return false;
+		}
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			if (Bits[1 + Axis] > MaxQuantizedBits && Bits[1 + Axis] != RawFloatBits)
+			{
+				return false;
+			}
+		}
+
+		FBitUnpacker Unpacker(Data + HeaderSize, NumBytes - HeaderSize);
+
+		OutTransforms.SetNum(Counts[0], false);
+		for (FTransform& Transform : OutTransforms)
+		{
+			const int32 Largest = Unpacker.Read(2);
+
+			double Components[4];
+			double SumSquares = 0.0;
+			for (int32 Idx = 0; Idx < 4; ++Idx)
+			{
+				if (Idx != Largest)
+				{
+					Components[Idx] = Dequantize(Unpacker.Read(RotationBits), -SmallestThreeRange, 2.0 * SmallestThreeRange, RotationBits);
+					SumSquares += Components[Idx] * Components[Idx];
+				}
+			}
+			Components[Largest] = FMath::Sqrt(FMath::Max(1.0 - SumSquares, 0.0));
+
+			FVector Translation;
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				const int32 AxisBits = Bits[1 + Axis];
+				if (AxisBits == RawFloatBits)
+				{
+					Translation[Axis] = ReadFloat(Unpacker);
+				}
+				else
+				{
+					Translation[Axis] = (AxisBits > 0) ? (float)Dequantize(Unpacker.Read(AxisBits), PositionMin[Axis], PositionExtent[Axis], AxisBits) : PositionMin[Axis];
+				}
+			}
+
+			FVector Scale = FVector::OneVector;
+			if (Unpacker.Read(1) == 0)
+			{
+				Scale.X = ReadFloat(Unpacker);
+				Scale.Y = ReadFloat(Unpacker);
+				Scale.Z = ReadFloat(Unpacker);
+			}
+
+			Transform.SetComponents(FQuat((float)Components[0], (float)Components[1], (float)Components[2], (float)Components[3]).GetNormalized(), Translation, Scale);
+		}
+
+		OutCurves.SetNum(Counts[1], false);
+		for (FLiveLinkCurveElement& Curve : OutCurves)
+		{
+			if (bFloatCurves)
+			{
+				Curve.CurveValue = ReadFloat(Unpacker);
+			}
+			else
+			{
+				FFloat16 HalfValue;
+				HalfValue.Encoded = (uint16)Unpacker.Read(16);
+				Curve.CurveValue = HalfValue;
+			}
+		}
+
+		return !Unpacker.HasError();
+	}
+}
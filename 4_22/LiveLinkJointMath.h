@@ -0,0 +1,152 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <cmath>
+
+/**
+* Host-independent math for building UE-space joint transforms straight from Maya joint channels.
+* Nothing in here touches the Maya API so it can be exercised outside of a Maya session, MayaLiveLinkTests checks it
+* against MTransformationMatrix.
+*/
+namespace LiveLinkJointMath
+{
+	/** Euler rotation orders, in the same order as MTransformationMatrix::RotationOrder (minus kInvalid) */
+	enum class ERotationOrder : uint8
+	{
+		XYZ,
+		YZX,
+		ZXY,
+		XZY,
+		YXZ,
+		ZYX,
+	};
+
+	/** Raw joint channel values as read from Maya. Angles are in radians. */
+	struct FJointChannels
+	{
+		double Scale[3];
+		double ScaleOrientation[3];
+		double Rotation[3];
+		double JointOrientation[3];
+		double Translation[3];
+		double ParentScale[3];
+		ERotationOrder ScaleOrientationOrder;
+		ERotationOrder RotationOrder;
+		ERotationOrder JointOrientationOrder;
+	};
+
+	/** Double precision quaternion, multiplication follows FQuat (A * B applies B first) */
+	struct FQuatDouble
+	{
+		double X, Y, Z, W;
+	};
+
+	inline FQuatDouble Multiply(const FQuatDouble& A, const FQuatDouble& B)
+	{
+		FQuatDouble Result;
+		Result.X = A.W * B.X + A.X * B.W + A.Y * B.Z - A.Z * B.Y;
+		Result.Y = A.W * B.Y - A.X * B.Z + A.Y * B.W + A.Z * B.X;
+		Result.Z = A.W * B.Z + A.X * B.Y - A.Y * B.X + A.Z * B.W;
+		Result.W = A.W * B.W - A.X * B.X - A.Y * B.Y - A.Z * B.Z;
+		return Result;
+	}
+
+	template<int32 Axis>
+	FORCEINLINE FQuatDouble AxisRotation(double Angle)
+	{
+		const double HalfAngle = Angle * 0.5;
+		FQuatDouble Result = { 0.0, 0.0, 0.0, std::cos(HalfAngle) };
+		(&Result.X)[Axis] = std::sin(HalfAngle);
+		return Result;
+	}
+
+	/** Axis application order for each rotation order, first axis is applied first */
+	template<ERotationOrder Order> struct TRotationOrderAxes;
+	template<> struct TRotationOrderAxes<ERotationOrder::XYZ> { enum { First = 0, Second = 1, Third = 2 }; };
+	template<> struct TRotationOrderAxes<ERotationOrder::YZX> { enum { First = 1, Second = 2, Third = 0 }; };
+	template<> struct TRotationOrderAxes<ERotationOrder::ZXY> { enum { First = 2, Second = 0, Third = 1 }; };
+	template<> struct TRotationOrderAxes<ERotationOrder::XZY> { enum { First = 0, Second = 2, Third = 1 }; };
+	template<> struct TRotationOrderAxes<ERotationOrder::YXZ> { enum { First = 1, Second = 0, Third = 2 }; };
+	template<> struct TRotationOrderAxes<ERotationOrder::ZYX> { enum { First = 2, Second = 1, Third = 0 }; };
+
+	template<ERotationOrder Order>
+	FORCEINLINE FQuatDouble EulerToQuat(const double Angles[3])
+	{
+		typedef TRotationOrderAxes<Order> FAxes;
+		return Multiply(AxisRotation<FAxes::Third>(Angles[FAxes::Third]),
+			Multiply(AxisRotation<FAxes::Second>(Angles[FAxes::Second]), AxisRotation<FAxes::First>(Angles[FAxes::First])));
+	}
+
+	inline FQuatDouble EulerToQuat(ERotationOrder Order, const double Angles[3])
+	{
+		switch (Order)
+		{
+		case ERotationOrder::YZX: return EulerToQuat<ERotationOrder::YZX>(Angles);
+		case ERotationOrder::ZXY: return EulerToQuat<ERotationOrder::ZXY>(Angles);
+		case ERotationOrder::XZY: return EulerToQuat<ERotationOrder::XZY>(Angles);
+		case ERotationOrder::YXZ: return EulerToQuat<ERotationOrder::YXZ>(Angles);
+		case ERotationOrder::ZYX: return EulerToQuat<ERotationOrder::ZYX>(Angles);
+		default: return EulerToQuat<ERotationOrder::XYZ>(Angles);
+		}
+	}
+
+	/**
+	* Builds the UE-space transform of a joint without going through any intermediate matrix.
+	*
+	* Equivalent to decomposing S * SO * R * JO * ParentS^-1 * T after the FBX axis flip. This is only exact when the
+	* composite has no shear, so joints with non-positive scale or a non-uniform parent scale are rejected and must go
+	* through the matrix path. Accepted joints match the matrix path to within float precision (1e-5).
+	*
+	* @return false if the channels are outside of what the fused kernel can represent
+	*/
+	template<ERotationOrder Order>
+	bool BuildUETransform(const FJointChannels& Channels, FTransform& OutTransform)
+	{
+		const double* Scale = Channels.Scale;
+		const double* ParentScale = Channels.ParentScale;
+
+		const double MinScale = 1.e-8;
+		if (Scale[0] <= MinScale || Scale[1] <= MinScale || Scale[2] <= MinScale || ParentScale[0] <= MinScale)
+		{
+			return false;
+		}
+
+		const double UniformTolerance = 1.e-6 * ParentScale[0];
+		if (std::abs(ParentScale[1] - ParentScale[0]) > UniformTolerance || std::abs(ParentScale[2] - ParentScale[0]) > UniformTolerance)
+		{
+			return false;
+		}
+
+		// Scale orientation is applied first and joint orientation last
+		const FQuatDouble Rotation = Multiply(EulerToQuat(Channels.JointOrientationOrder, Channels.JointOrientation),
+			Multiply(EulerToQuat<Order>(Channels.Rotation), EulerToQuat(Channels.ScaleOrientationOrder, Channels.ScaleOrientation)));
+
+		// Mirroring the Y axis (FFbxDataConverter::ConvertMatrix) flips the X and Z components of the rotation axis
+		OutTransform.SetRotation(FQuat(-Rotation.X, Rotation.Y, -Rotation.Z, Rotation.W));
+
+		const double* Translation = Channels.Translation;
+		OutTransform.SetTranslation(FVector(Translation[0], -Translation[1], Translation[2]));
+
+		const double InvParentScale = 1.0 / ParentScale[0];
+		OutTransform.SetScale3D(FVector(Scale[0] * InvParentScale, Scale[1] * InvParentScale, Scale[2] * InvParentScale));
+		return true;
+	}
+
+	inline bool BuildUETransform(const FJointChannels& Channels, FTransform& OutTransform)
+	{
+		typedef bool(*FKernel)(const FJointChannels&, FTransform&);
+		static const FKernel Kernels[] =
+		{
+			&BuildUETransform<ERotationOrder::XYZ>,
+			&BuildUETransform<ERotationOrder::YZX>,
+			&BuildUETransform<ERotationOrder::ZXY>,
+			&BuildUETransform<ERotationOrder::XZY>,
+			&BuildUETransform<ERotationOrder::YXZ>,
+			&BuildUETransform<ERotationOrder::ZYX>,
+		};
+		return Kernels[(uint8)Channels.RotationOrder](Channels, OutTransform);
+	}
+}
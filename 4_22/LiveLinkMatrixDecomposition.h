@@ -0,0 +1,290 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LiveLinkJointMath.h"
+
+// Joint matrices and Maya matrix to UE transform decomposition, shared with MayaLiveLinkTests which checks the fused
+// joint kernel against this matrix path and benchmarks the batched decomposition against the scalar one. Includers
+// take care of Maya's DWORD clash first, see MayaLiveLinkPlugin.cpp
+#include <maya/MMatrix.h>
+#include <maya/MTransformationMatrix.h>
+#include <maya/MVector.h>
+
+inline MTransformationMatrix::RotationOrder ToMayaRotationOrder(LiveLinkJointMath::ERotationOrder RotOrder)
+{
+	return (MTransformationMatrix::RotationOrder)(MTransformationMatrix::kXYZ + (int)RotOrder);
+}
+
+inline MMatrix GetRotationMatrix(const double Rotation[3], LiveLinkJointMath::ERotationOrder RotOrder)
+{
+	MTransformationMatrix M;
+	M.setRotation(Rotation, ToMayaRotationOrder(RotOrder));
+	return M.asMatrix();
+}
+
+/** Reference matrix path for a joint, S * SO * R * JO * ParentS^-1 * T, used whenever the fused kernel rejects the channels */
+inline MMatrix BuildMayaJointMatrix(const LiveLinkJointMath::FJointChannels& Channels)
+{
+	MTransformationMatrix ScaleTM;
+	ScaleTM.setScale(Channels.Scale, MSpace::kTransform);
+
+	MTransformationMatrix ParentScaleTM;
+	ParentScaleTM.setScale(Channels.ParentScale, MSpace::kTransform);
+
+	MTransformationMatrix TranslationTM;
+	TranslationTM.setTranslation(MVector(Channels.Translation), MSpace::kTransform);
+
+	return ScaleTM.asMatrix() *
+		GetRotationMatrix(Channels.ScaleOrientation, Channels.ScaleOrientationOrder) *
+		GetRotationMatrix(Channels.Rotation, Channels.RotationOrder) *
+		GetRotationMatrix(Channels.JointOrientation, Channels.JointOrientationOrder) *
+		ParentScaleTM.asMatrix().inverse() *
+		TranslationTM.asMatrix();
+}
+
+/** Scalar matrix path, FFbxDataConverter's axis flip followed by MTransformationMatrix's decomposition */
+inline FTransform BuildUETransformFromMayaTransform(const MMatrix& InMatrix)
+{
+	MMatrix UnrealSpaceJointMatrix;
+
+	// from FFbxDataConverter::ConvertMatrix
+	for (int i = 0; i < 4; ++i)
+	{
+		const double* Row = InMatrix[i];
+		if (i == 1)
+		{
+			UnrealSpaceJointMatrix[i][0] = -Row[0];
+			UnrealSpaceJointMatrix[i][1] = Row[1];
+			UnrealSpaceJointMatrix[i][2] = -Row[2];
+			UnrealSpaceJointMatrix[i][3] = -Row[3];
+		}
+		else
+		{
+			UnrealSpaceJointMatrix[i][0] = Row[0];
+			UnrealSpaceJointMatrix[i][1] = -Row[1];
+			UnrealSpaceJointMatrix[i][2] = Row[2];
+			UnrealSpaceJointMatrix[i][3] = Row[3];
+		}
+	}
+
+	MTransformationMatrix UnrealSpaceJointTransform(UnrealSpaceJointMatrix);
+
+
+	// getRotation is MSpace::kTransform
+	double tx, ty, tz, tw;
+	UnrealSpaceJointTransform.getRotationQuaternion(tx, ty, tz, tw, MSpace::kWorld);
+
+	FTransform UETrans;
+	UETrans.SetRotation(FQuat(tx, ty, tz, tw));
+
+	MVector Translation = UnrealSpaceJointTransform.getTranslation(MSpace::kWorld);
+	UETrans.SetTranslation(FVector(Translation.x, Translation.y, Translation.z));
+
+	double Scale[3];
+	UnrealSpaceJointTransform.getScale(Scale, MSpace::kWorld);
+	UETrans.SetScale3D(FVector((float)Scale[0], (float)Scale[1], (float)Scale[2]));
+	return UETrans;
+}
+
+namespace LiveLinkBatchedDecomposition
+{
+	/** Matrices decomposed together, one per VectorRegister lane */
+	const int32 BatchSize = 4;
+
+	FORCEINLINE VectorRegister Dot3(const VectorRegister A[3], const VectorRegister B[3])
+	{
+		return VectorMultiplyAdd(A[2], B[2], VectorMultiplyAdd(A[1], B[1], VectorMultiply(A[0], B[0])));
+	}
+
+	/** Normalizes Row in place and returns its length, flags lanes that are too short to normalize */
+	FORCEINLINE VectorRegister NormalizeRow(VectorRegister Row[3], VectorRegister& InOutDegenerateMask)
+	{
+		const VectorRegister MinLengthSquared = VectorSetFloat1(1.e-12f);
+
+		const VectorRegister LengthSquared = Dot3(Row, Row);
+		InOutDegenerateMask = VectorBitwiseOr(InOutDegenerateMask, VectorCompareGT(MinLengthSquared, LengthSquared));
+
+		const VectorRegister InvLength = VectorReciprocalSqrtAccurate(VectorMax(LengthSquared, MinLengthSquared));
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			Row[Axis] = VectorMultiply(Row[Axis], InvLength);
+		}
+		return VectorMultiply(LengthSquared, InvLength);
+	}
+
+	/** Row -= dot(Row, Basis) * Basis */
+	FORCEINLINE void RemoveProjection(VectorRegister Row[3], const VectorRegister Basis[3])
+	{
+		const VectorRegister Projection = Dot3(Row, Basis);
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			Row[Axis] = VectorSubtract(Row[Axis], VectorMultiply(Projection, Basis[Axis]));
+		}
+	}
+
+	/**
+	* Decomposes BatchSize Maya-space matrices into UE transforms.
+	* Scale and shear are removed the same way MTransformationMatrix does (S * Sh * R), by orthogonalizing the rows in order.
+	*
+	* @return Bit mask of the lanes that are mirrored or degenerate and were not written
+	*/
+	inline int32 DecomposeBatch(const MMatrix* InMatrices, FTransform* OutTransforms)
+	{
+		MS_ALIGN(16) float Elements[9][BatchSize] GCC_ALIGN(16);
+		for (int32 Lane = 0; Lane < BatchSize; ++Lane)
+		{
+			const MMatrix& Matrix = InMatrices[Lane];
+			for (int32 Row = 0; Row < 3; ++Row)
+			{
+				for (int32 Col = 0; Col < 3; ++Col)
+				{
+					// FFbxDataConverter::ConvertMatrix, negates the off-diagonal Y row and column entries
+					const bool bFlip = (Row == 1) != (Col == 1);
+					Elements[Row * 3 + Col][Lane] = (float)(bFlip ? -Matrix(Row, Col) : Matrix(Row, Col));
+				}
+			}
+		}
+
+		VectorRegister Rows[3][3];
+		for (int32 Row = 0; Row < 3; ++Row)
+		{
+			for (int32 Col = 0; Col < 3; ++Col)
+			{
+				Rows[Row][Col] = VectorLoadAligned(Elements[Row * 3 + Col]);
+			}
+		}
+
+		VectorRegister DegenerateMask = VectorZero();
+
+		const VectorRegister ScaleX = NormalizeRow(Rows[0], DegenerateMask);
+		RemoveProjection(Rows[1], Rows[0]);
+		const VectorRegister ScaleY = NormalizeRow(Rows[1], DegenerateMask);
+		RemoveProjection(Rows[2], Rows[0]);
+		RemoveProjection(Rows[2], Rows[1]);
+		const VectorRegister ScaleZ = NormalizeRow(Rows[2], DegenerateMask);
+
+		// Mirrored matrices leave a left handed basis, those are left to MTransformationMatrix
+		const VectorRegister CrossXY[3] =
+		{
+			VectorSubtract(VectorMultiply(Rows[0][1], Rows[1][2]), VectorMultiply(Rows[0][2], Rows[1][1])),
+			VectorSubtract(VectorMultiply(Rows[0][2], Rows[1][0]), VectorMultiply(Rows[0][0], Rows[1][2])),
+			VectorSubtract(VectorMultiply(Rows[0][0], Rows[1][1]), VectorMultiply(Rows[0][1], Rows[1][0])),
+		};
+		DegenerateMask = VectorBitwiseOr(DegenerateMask, VectorCompareGT(VectorZero(), Dot3(CrossXY, Rows[2])));
+
+		// Rotation matrix to quaternion, every branch of FQuat(FMatrix) is evaluated and the most stable one selected
+		const VectorRegister One = VectorOne();
+		const VectorRegister Half = VectorSetFloat1(0.5f);
+		const VectorRegister M00 = Rows[0][0], M11 = Rows[1][1], M22 = Rows[2][2];
+
+		const VectorRegister TraceW = VectorAdd(One, VectorAdd(M00, VectorAdd(M11, M22)));
+		const VectorRegister TraceX = VectorAdd(One, VectorSubtract(M00, VectorAdd(M11, M22)));
+		const VectorRegister TraceY = VectorAdd(One, VectorSubtract(M11, VectorAdd(M00, M22)));
+		const VectorRegister TraceZ = VectorAdd(One, VectorSubtract(M22, VectorAdd(M00, M11)));
+
+		const VectorRegister Diff12 = VectorSubtract(Rows[1][2], Rows[2][1]);
+		const VectorRegister Diff20 = VectorSubtract(Rows[2][0], Rows[0][2]);
+		const VectorRegister Diff01 = VectorSubtract(Rows[0][1], Rows[1][0]);
+		const VectorRegister Sum12 = VectorAdd(Rows[1][2], Rows[2][1]);
+		const VectorRegister Sum20 = VectorAdd(Rows[2][0], Rows[0][2]);
+		const VectorRegister Sum01 = VectorAdd(Rows[0][1], Rows[1][0]);
+
+		const VectorRegister MinTrace = VectorSetFloat1(1.e-12f);
+		auto HalfInvSqrt = [&](const VectorRegister& Trace)
+		{
+			return VectorMultiply(Half, VectorReciprocalSqrtAccurate(VectorMax(Trace, MinTrace)));
+		};
+
+		VectorRegister Scale = HalfInvSqrt(TraceW);
+		VectorRegister QX = VectorMultiply(Diff12, Scale);
+		VectorRegister QY = VectorMultiply(Diff20, Scale);
+		VectorRegister QZ = VectorMultiply(Diff01, Scale);
+		VectorRegister QW = VectorMultiply(TraceW, Scale);
+		VectorRegister BestTrace = TraceW;
+
+		auto SelectBranch = [&](const VectorRegister& Trace, const VectorRegister& X, const VectorRegister& Y, const VectorRegister& Z, const VectorRegister& W)
+		{
+			const VectorRegister Mask = VectorCompareGT(Trace, BestTrace);
+			const VectorRegister BranchScale = HalfInvSqrt(Trace);
+			QX = VectorSelect(Mask, VectorMultiply(X, BranchScale), QX);
+			QY = VectorSelect(Mask, VectorMultiply(Y, BranchScale), QY);
+			QZ = VectorSelect(Mask, VectorMultiply(Z, BranchScale), QZ);
+			QW = VectorSelect(Mask, VectorMultiply(W, BranchScale), QW);
+			BestTrace = VectorMax(Trace, BestTrace);
+		};
+
+		SelectBranch(TraceX, TraceX, Sum01, Sum20, Diff12);
+		SelectBranch(TraceY, Sum01, TraceY, Sum12, Diff20);
+		SelectBranch(TraceZ, Sum20, Sum12, TraceZ, Diff01);
+
+		const VectorRegister QuatInvLength = VectorReciprocalSqrtAccurate(
+			VectorMultiplyAdd(QW, QW, VectorMultiplyAdd(QZ, QZ, VectorMultiplyAdd(QY, QY, VectorMultiply(QX, QX)))));
+
+		MS_ALIGN(16) float Results[7][BatchSize] GCC_ALIGN(16);
+		VectorStoreAligned(VectorMultiply(QX, QuatInvLength), Results[0]);
+		VectorStoreAligned(VectorMultiply(QY, QuatInvLength), Results[1]);
+		VectorStoreAligned(VectorMultiply(QZ, QuatInvLength), Results[2]);
+		VectorStoreAligned(VectorMultiply(QW, QuatInvLength), Results[3]);
+		VectorStoreAligned(ScaleX, Results[4]);
+		VectorStoreAligned(ScaleY, Results[5]);
+		VectorStoreAligned(ScaleZ, Results[6]);
+
+		const int32 FallbackLanes = VectorMaskBits(DegenerateMask);
+		for (int32 Lane = 0; Lane < BatchSize; ++Lane)
+		{
+			if ((FallbackLanes & (1 << Lane)) == 0)
+			{
+				const MMatrix& Matrix = InMatrices[Lane];
+				FTransform& UETrans = OutTransforms[Lane];
+				UETrans.SetRotation(FQuat(Results[0][Lane], Results[1][Lane], Results[2][Lane], Results[3][Lane]));
+				UETrans.SetTranslation(FVector(Matrix(3, 0), -Matrix(3, 1), Matrix(3, 2)));
+				UETrans.SetScale3D(FVector(Results[4][Lane], Results[5][Lane], Results[6][Lane]));
+			}
+		}
+
+		return FallbackLanes;
+	}
+}
+
+/**
+* Batched version of BuildUETransformFromMayaTransform.
+* Matrices are decomposed with VectorRegister math (SSE, NEON or the FPU fallback depending on the platform), only
+* mirrored or degenerate matrices go through the scalar path. The tail is padded to a full batch with copies of the
+* last matrix, so a matrix gives the same bits wherever it falls in the batches and splitting the input across
+* threads can't change the result.
+*/
+inline void BuildUETransformsFromMayaTransforms(const MMatrix* InMatrices, FTransform* OutTransforms, int32 Count)
+{
+	using LiveLinkBatchedDecomposition::BatchSize;
+
+	int32 Index = 0;
+	for (; Index + BatchSize <= Count; Index += BatchSize)
+	{
+		const int32 FallbackLanes = LiveLinkBatchedDecomposition::DecomposeBatch(&InMatrices[Index], &OutTransforms[Index]);
+		for (int32 Lane = 0; FallbackLanes != 0 && Lane < BatchSize; ++Lane)
+		{
+			if (FallbackLanes & (1 << Lane))
+			{
+				OutTransforms[Index + Lane] = BuildUETransformFromMayaTransform(InMatrices[Index + Lane]);
+			}
+		}
+	}
+
+	if (Index < Count)
+	{
+		MMatrix TailMatrices[BatchSize];
+		FTransform TailTransforms[BatchSize];
+		for (int32 Lane = 0; Lane < BatchSize; ++Lane)
+		{
+			TailMatrices[Lane] = InMatrices[FMath::Min(Index + Lane, Count - 1)];
+		}
+
+		const int32 FallbackLanes = LiveLinkBatchedDecomposition::DecomposeBatch(TailMatrices, TailTransforms);
+		for (int32 Lane = 0; Index + Lane < Count; ++Lane)
+		{
+			OutTransforms[Index + Lane] = (FallbackLanes & (1 << Lane)) ? BuildUETransformFromMayaTransform(TailMatrices[Lane]) : TailTransforms[Lane];
+		}
+	}
+}
@@ -0,0 +1,403 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LiveLinkTypes.h"
+#include "LiveLinkFrameCodec.h"
+
+#include <atomic>
+
+/**
+* Same machine transport that skips the message bus: a single writer ring of fixed size slots in a named shared memory
+* region (POSIX shared memory on Linux and Mac, a page file mapping on Windows) that local readers consume in place.
+*
+* Layout: FHeader, then SlotCount slots of SlotSize bytes, each an FSlotHeader followed by one record.
+*	Subject:	FSubjectRecord, NumBones * int32 BoneParent, then the subject, bone and curve names as uint16 byte length
+*				plus UTF-8
+*	Frame:		FFrameRecord, NumTransforms * 10 floats (rotation xyzw, translation, scale), NumCurves * float
+*	CompactFrame: FFrameRecord, then the LiveLinkFrameCodec encoding of the transforms and curve values, written for
+*				subjects set to the compact encoding
+*
+* Frames only carry values, the names come from the last subject record with the same SubjectId. A subject record is
+* written when the static data or the subject's curve names change, and for every subject whenever a reader bumps
+* ResyncRequests on attaching.
+*
+* Every slot is a seqlock. The writer makes the slot's Sequence odd while writing record N and stores 2 * N + 2 when
+* it is done, so it never waits for readers. A reader only trusts record N while the Sequence still reads 2 * N + 2,
+* and one that falls more than SlotCount records behind skips ahead.
+*/
+namespace LiveLinkSharedMemory
+{
+	const uint32 Magic = 0x4D534C4C; // "LLSM"
+	const uint32 Version = 2;
+	const uint32 FloatsPerTransform = 10;
+
+	enum class ERecordType : uint32
+	{
+		Subject = 1,
+		Frame = 2,
+		CompactFrame = 3,
+	};
+
+	// The atomics are lock free 32 and 64 bit words, which is what makes them usable across processes
+	struct alignas(64) FHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 SlotCount;
+		uint32 SlotSize;
+		std::atomic<uint64> WriteIndex;
+		std::atomic<uint32> ResyncRequests;
+	};
+
+	struct alignas(16) FSlotHeader
+	{
+		std::atomic<uint64> Sequence;
+		ERecordType Type;
+		uint32 PayloadSize;
+	};
+
+	struct FSubjectRecord
+	{
+		uint32 SubjectId;
+		uint32 NumBones;
+		uint32 NumCurves;
+		uint32 NamesSize;
+	};
+
+	struct FFrameRecord
+	{
+		uint32 SubjectId;
+		uint32 NumTransforms;
+		uint32 NumCurves;
+		uint32 Reserved;
+		double StreamTime;
+		// FPlatformTime::Seconds() when the record was written, comparable between processes on the same machine
+		double PublishTime;
+	};
+
+	inline FSlotHeader* GetSlot(void* RegionAddress, const FHeader& Header, uint64 RecordIndex)
+	{
+		return reinterpret_cast<FSlotHeader*>(static_cast<uint8*>(RegionAddress) + sizeof(FHeader) + (RecordIndex % Header.SlotCount) * Header.SlotSize);
+	}
+
+	inline uint32 GetMaxPayloadSize(const FHeader& Header)
+	{
+		return Header.SlotSize - sizeof(FSlotHeader);
+	}
+
+	const uint32 AccessReadWrite = (uint32)(FPlatformMemory::ESharedMemoryAccess::Read | FPlatformMemory::ESharedMemoryAccess::Write);
+
+	/**
+	* Stand-in for an engine side reader, used by the benchmark, the LiveLinkSharedMemory command and the standalone
+	* MayaLiveLinkSharedMemoryReader program. Frames are handed out as views into the region. A view can be overwritten
+	* while it is looked at when the reader falls a whole ring behind, IsIntact tells whether everything read from it so
+	* far is good. Full frames can be read in place, Decode turns either kind of frame into transforms and named curves.
+	*
+	* The slot and record headers are copied out once, and only the copies are validated and used: a writer lapping the
+	* slot could otherwise change a count between the check and the use, and send the reader past the slot.
+	*/
+	class FReader
+	{
+	public:
+		struct FSubject
+		{
+			FName SubjectName;
+			TArray<FName> BoneNames;
+			TArray<int32> BoneParents;
+			TArray<FName> CurveNames;
+		};
+
+		struct FFrameView
+		{
+			const FSubject* Subject;
+			// Copied out of the slot, only valid once IsIntact says so
+			FFrameRecord Record;
+
+			// Full frames, nullptr for compact ones
+			const float* Transforms;
+			const float* CurveValues;
+
+			// Compact frames, nullptr for full ones
+			const uint8* EncodedFrame;
+			uint32 EncodedSize;
+
+			bool IsCompact() const { return EncodedFrame != nullptr; }
+
+			bool IsIntact() const
+			{
+				std::atomic_thread_fence(std::memory_order_acquire);
+				return Slot->Sequence.load(std::memory_order_relaxed) == ExpectedSequence;
+			}
+
+			/** False when the frame doesn't decode or was overwritten while it was copied out */
+			bool Decode(TArray<FTransform>& OutTransforms, TArray<FLiveLinkCurveElement>& OutCurves) const
+			{
+				if (IsCompact())
+				{
+					if (!LiveLinkFrameCodec::Decode(EncodedFrame, EncodedSize, OutTransforms, OutCurves) || OutCurves.Num() != Subject->CurveNames.Num())
+					{
+						return false;
+					}
+				}
+				else
+				{
+					OutTransforms.SetNum(Record.NumTransforms, false);
+					const float* Values = Transforms;
+					for (FTransform& Transform : OutTransforms)
+					{
+						Transform.SetComponents(FQuat(Values[0], Values[1], Values[2], Values[3]), FVector(Values[4], Values[5], Values[6]), FVector(Values[7], Values[8], Values[9]));
+						Values += FloatsPerTransform;
+					}
+
+					OutCurves.SetNum(Record.NumCurves, false);
+					for (uint32 Idx = 0; Idx < Record.NumCurves; ++Idx)
+					{
+						OutCurves[Idx].CurveValue = CurveValues[Idx];
+					}
+				}
+
+				for (int32 Idx = 0; Idx < OutCurves.Num(); ++Idx)
+				{
+					OutCurves[Idx].CurveName = Subject->CurveNames[Idx];
+				}
+				return IsIntact();
+			}
+
+			const FSlotHeader* Slot;
+			uint64 ExpectedSequence;
+		};
+
+		FReader()
+			: Region(nullptr)
+			, Header(nullptr)
+			, ReadIndex(0)
+			, FramesRead(0)
+			, SubjectsRead(0)
+			, RecordsLost(0)
+			, RecordsTorn(0)
+		{}
+
+		~FReader()
+		{
+			Close();
+		}
+
+		bool Open(const FString& Name)
+		{
+			Close();
+
+			// The ring's size is only known from the header
+			FPlatformMemory::FSharedMemoryRegion* HeaderRegion = FPlatformMemory::MapNamedSharedMemoryRegion(Name, false, AccessReadWrite, sizeof(FHeader));
+			if (HeaderRegion == nullptr)
+			{
+				return false;
+			}
+
+			const FHeader* MappedHeader = static_cast<const FHeader*>(HeaderRegion->GetAddress());
+			const bool bValid = MappedHeader->Magic == Magic && MappedHeader->Version == Version && MappedHeader->SlotCount > 0;
+			std::atomic_thread_fence(std::memory_order_acquire);
+			const SIZE_T RegionSize = sizeof(FHeader) + (SIZE_T)MappedHeader->SlotCount * MappedHeader->SlotSize;
+			FPlatformMemory::UnmapNamedSharedMemoryRegion(HeaderRegion);
+			if (!bValid)
+			{
+				return false;
+			}
+
+			Region = FPlatformMemory::MapNamedSharedMemoryRegion(Name, false, AccessReadWrite, RegionSize);
+			if (Region == nullptr)
+			{
+				return false;
+			}
+
+			// Only new records are read, the writer resends every subject's names for us
+			Header = static_cast<FHeader*>(Region->GetAddress());
+			ReadIndex = Header->WriteIndex.load(std::memory_order_acquire);
+			Header->ResyncRequests.fetch_add(1, std::memory_order_release);
+			return true;
+		}
+
+		void Close()
+		{
+			if (Region != nullptr)
+			{
+				FPlatformMemory::UnmapNamedSharedMemoryRegion(Region);
+				Region = nullptr;
+				Header = nullptr;
+			}
+			Subjects.Reset();
+		}
+
+		bool IsOpen() const { return Region != nullptr; }
+
+		/** Reads every record written since the last poll, returns the number of frames handed to OnFrame */
+		int32 Poll(TFunctionRef<void(const FFrameView&)> OnFrame)
+		{
+			if (Header == nullptr)
+			{
+				return 0;
+			}
+
+			const uint64 WriteIndex = Header->WriteIndex.load(std::memory_order_acquire);
+			if (WriteIndex - ReadIndex > Header->SlotCount)
+			{
+				RecordsLost += WriteIndex - Header->SlotCount - ReadIndex;
+				ReadIndex = WriteIndex - Header->SlotCount;
+			}
+
+			int32 NumFrames = 0;
+			for (; ReadIndex < WriteIndex; ++ReadIndex)
+			{
+				FFrameView View;
+				View.Slot = GetSlot(Region->GetAddress(), *Header, ReadIndex);
+				View.ExpectedSequence = 2 * ReadIndex + 2;
+				if (View.Slot->Sequence.load(std::memory_order_acquire) != View.ExpectedSequence)
+				{
+					++RecordsLost;
+					continue;
+				}
+
+				const ERecordType Type = View.Slot->Type;
+				const uint32 PayloadSize = View.Slot->PayloadSize;
+				if (PayloadSize > GetMaxPayloadSize(*Header))
+				{
+					++RecordsTorn;
+					continue;
+				}
+
+				const uint8* Payload = reinterpret_cast<const uint8*>(View.Slot + 1);
+				if (Type == ERecordType::Subject)
+				{
+					ReadSubject(Payload, PayloadSize, View);
+				}
+				else if ((Type == ERecordType::Frame || Type == ERecordType::CompactFrame) && PayloadSize >= sizeof(FFrameRecord))
+				{
+					FMemory::Memcpy(&View.Record, Payload, sizeof(FFrameRecord));
+					View.Subject = Subjects.Find(View.Record.SubjectId);
+
+					bool bSizeMatches;
+					if (Type == ERecordType::CompactFrame)
+					{
+						View.Transforms = nullptr;
+						View.CurveValues = nullptr;
+						View.EncodedFrame = Payload + sizeof(FFrameRecord);
+						View.EncodedSize = PayloadSize - sizeof(FFrameRecord);
+						bSizeMatches = View.EncodedSize >= (uint32)LiveLinkFrameCodec::HeaderSize;
+					}
+					else
+					{
+						View.Transforms = reinterpret_cast<const float*>(Payload + sizeof(FFrameRecord));
+						View.CurveValues = View.Transforms + (uint64)View.Record.NumTransforms * FloatsPerTransform;
+						View.EncodedFrame = nullptr;
+						View.EncodedSize = 0;
+						// In 64 bits so no torn count can wrap around to a matching size
+						bSizeMatches = PayloadSize == sizeof(FFrameRecord) + ((uint64)View.Record.NumTransforms * FloatsPerTransform + View.Record.NumCurves) * sizeof(float);
+					}
+
+					// Frames of subjects whose names haven't arrived yet are skipped
+					if (bSizeMatches && View.Subject != nullptr && (uint32)View.Subject->CurveNames.Num() == View.Record.NumCurves)
+					{
+						OnFrame(View);
+						if (View.IsIntact())
+						{
+							++FramesRead;
+							++NumFrames;
+							continue;
+						}
+					}
+
+					if (!View.IsIntact())
+					{
+						++RecordsTorn;
+					}
+				}
+			}
+			return NumFrames;
+		}
+
+		uint64 GetFramesRead() const { return FramesRead; }
+		uint64 GetSubjectsRead() const { return SubjectsRead; }
+		uint64 GetRecordsLost() const { return RecordsLost; }
+		uint64 GetRecordsTorn() const { return RecordsTorn; }
+
+	private:
+		static bool ReadName(const uint8*& Cursor, const uint8* End, FName& OutName)
+		{
+			uint16 Length;
+			if (Cursor + sizeof(Length) > End)
+			{
+				return false;
+			}
+			FMemory::Memcpy(&Length, Cursor, sizeof(Length));
+			Cursor += sizeof(Length);
+			if (Cursor + Length > End)
+			{
+				return false;
+			}
+
+			FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Cursor), Length);
+			OutName = FName(*FString(Converter.Length(), Converter.Get()));
+			Cursor += Length;
+			return true;
+		}
+
+		void ReadSubject(const uint8* Payload, uint32 PayloadSize, const FFrameView& View)
+		{
+			FSubjectRecord Record;
+			if (PayloadSize < sizeof(FSubjectRecord))
+			{
+				++RecordsTorn;
+				return;
+			}
+			FMemory::Memcpy(&Record, Payload, sizeof(FSubjectRecord));
+
+			// Every name takes at least its length, which also bounds the curve count by the payload
+			const uint64 MinNamesSize = (1 + (uint64)Record.NumBones + Record.NumCurves) * sizeof(uint16);
+			if (PayloadSize != sizeof(FSubjectRecord) + (uint64)Record.NumBones * sizeof(int32) + Record.NamesSize || Record.NamesSize < MinNamesSize)
+			{
+				++RecordsTorn;
+				return;
+			}
+
+			// Names are copied out, they outlive the slot
+			FSubject Subject;
+			const int32* Parents = reinterpret_cast<const int32*>(Payload + sizeof(FSubjectRecord));
+			Subject.BoneParents.Append(Parents, Record.NumBones);
+
+			const uint8* Cursor = reinterpret_cast<const uint8*>(Parents + Record.NumBones);
+			const uint8* End = Cursor + Record.NamesSize;
+			bool bNamesValid = ReadName(Cursor, End, Subject.SubjectName);
+			Subject.BoneNames.SetNum(Record.NumBones);
+			for (uint32 Idx = 0; Idx < Record.NumBones && bNamesValid; ++Idx)
+			{
+				bNamesValid = ReadName(Cursor, End, Subject.BoneNames[Idx]);
+			}
+			Subject.CurveNames.SetNum(Record.NumCurves);
+			for (uint32 Idx = 0; Idx < Record.NumCurves && bNamesValid; ++Idx)
+			{
+				bNamesValid = ReadName(Cursor, End, Subject.CurveNames[Idx]);
+			}
+
+			const uint32 SubjectId = Record.SubjectId;
+			if (!bNamesValid || !View.IsIntact())
+			{
+				++RecordsTorn;
+				return;
+			}
+
+			Subjects.Add(SubjectId, MoveTemp(Subject));
+			++SubjectsRead;
+		}
+
+		FPlatformMemory::FSharedMemoryRegion* Region;
+		FHeader* Header;
+		uint64 ReadIndex;
+		TMap<uint32, FSubject> Subjects;
+
+		uint64 FramesRead;
+		uint64 SubjectsRead;
+		uint64 RecordsLost;
+		uint64 RecordsTorn;
+	};
+}
@@ -0,0 +1,455 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LiveLinkTypes.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformProcess.h"
+#include "Async/MappedFileHandle.h"
+#include "LiveLinkFrameCodec.h"
+
+#include <atomic>
+
+/**
+* Take files hold everything sent to the provider so a session can be replayed without Maya's scene.
+*
+* Layout (little endian):
+*	Header: uint32 Magic, uint32 Version, uint64 FooterOffset (0 until the take is closed)
+*	Records, appended as they are sent: uint8 Type, uint32 PayloadSize, payload
+*		Name:		uint32 NameIndex, string
+*		Subject:	uint32 SubjectNameIndex, uint32 NumBones, NumBones * uint32 BoneNameIndex, NumBones * int32 BoneParent
+*		Frame:		uint32 SubjectNameIndex, double StreamTime, uint32 NumTransforms, NumTransforms * 10 floats
+*					(rotation xyzw, translation, scale), uint32 NumCurves, NumCurves * (uint32 CurveNameIndex, float Value)
+*		CompactFrame: uint32 SubjectNameIndex, double StreamTime, uint32 NumCurves, NumCurves * uint32 CurveNameIndex,
+*					uint32 EncodedSize, LiveLinkFrameCodec encoding of the transforms and curve values
+*	Footer: uint32 NumNames, strings, uint32 NumSubjects, uint64 offsets, uint32 NumFrames, uint64 offsets
+*
+* Frames use the compact encoding when it is selected for their subject, see LiveLinkFrameCodec. Version 3 compact
+* frames can hold raw float translation axes and full float curves, earlier versions never do.
+*
+* Strings are uint32 byte length plus UTF-8. The footer makes seeking to any frame O(1) once the file is mapped,
+* a take without one (Maya went down while recording) is indexed by scanning its records instead.
+*/
+namespace LiveLinkTake
+{
+	const uint32 Magic = 0x544C4C4D; // "MLLT"
+	const uint32 Version = 3;
+	const uint32 MinVersion = 1;
+	const int64 HeaderSize = sizeof(uint32) * 2 + sizeof(uint64);
+	const int64 RecordHeaderSize = sizeof(uint8) + sizeof(uint32);
+	const int32 FloatsPerTransform = 10;
+
+	enum class ERecordType : uint8
+	{
+		Name = 1,
+		Subject = 2,
+		Frame = 3,
+		CompactFrame = 4,
+	};
+
+	template<typename T>
+	void Append(TArray<uint8>& Buffer, const T& Value)
+	{
+		Buffer.Append(reinterpret_cast<const uint8*>(&Value), sizeof(T));
+	}
+
+	inline void AppendString(TArray<uint8>& Buffer, const FString& Value)
+	{
+		FTCHARToUTF8 Converted(*Value);
+		Append(Buffer, (uint32)Converted.Length());
+		Buffer.Append(reinterpret_cast<const uint8*>(Converted.Get()), Converted.Length());
+	}
+
+	/** Bounds checked reads from a mapped take */
+	struct FReader
+	{
+		FReader(const uint8* InData, int64 InSize, int64 InOffset)
+			: Data(InData)
+			, Size(InSize)
+			, Offset(InOffset)
+			, bError(false)
+		{}
+
+		template<typename T>
+		T Read()
+		{
+			T Value = T();
+			if (Offset + (int64)sizeof(T) <= Size)
+			{
+				FMemory::Memcpy(&Value, Data + Offset, sizeof(T));
+				Offset += sizeof(T);
+			}
+			else
+			{
+				bError = true;
+			}
+			return Value;
+		}
+
+		FString ReadString()
+		{
+			const uint32 Length = Read<uint32>();
+			if (bError || Offset + Length > Size)
+			{
+				bError = true;
+				return FString();
+			}
+
+			const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Data + Offset), Length);
+			Offset += Length;
+			return FString(Converted.Length(), Converted.Get());
+		}
+
+		const uint8* Data;
+		int64 Size;
+		int64 Offset;
+		bool bError;
+	};
+}
+
+/** Memory maps a take file and indexes its records for random access */
+class FLiveLinkTakeReader
+{
+public:
+	bool Open(const FString& Filename, FString& OutError)
+	{
+		MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+		if (MappedFile.IsValid())
+		{
+			MappedRegion.Reset(MappedFile->MapRegion());
+		}
+		if (!MappedRegion.IsValid())
+		{
+			OutError = FString::Printf(TEXT("Unable to map %s"), *Filename);
+			return false;
+		}
+
+		Data = MappedRegion->GetMappedPtr();
+		Size = MappedRegion->GetMappedSize();
+
+		LiveLinkTake::FReader Reader(Data, Size, 0);
+		const uint32 FileMagic = Reader.Read<uint32>();
+		const uint32 FileVersion = Reader.Read<uint32>();
+		const uint64 FooterOffset = Reader.Read<uint64>();
+		if (Reader.bError || FileMagic != LiveLinkTake::Magic || FileVersion < LiveLinkTake::MinVersion || FileVersion > LiveLinkTake::Version)
+		{
+			OutError = FString::Printf(TEXT("%s is not a version %u to %u take"), *Filename, LiveLinkTake::MinVersion, LiveLinkTake::Version);
+			return false;
+		}
+
+		const bool bIndexed = (FooterOffset != 0) ? ReadFooter(FooterOffset) : ScanRecords(Size);
+		if (!bIndexed)
+		{
+			OutError = FString::Printf(TEXT("%s is corrupt"), *Filename);
+			return false;
+		}
+		return true;
+	}
+
+	int32 GetNumFrames() const { return FrameOffsets.Num(); }
+	int64 GetFrameOffset(int32 FrameIndex) const { return FrameOffsets[FrameIndex]; }
+	int64 GetRecordsEnd() const { return RecordsEnd; }
+	const TArray<int64>& GetSubjectOffsets() const { return SubjectOffsets; }
+
+	/** Reads the record header at Offset, returns false past the last record */
+	bool PeekRecord(int64 Offset, LiveLinkTake::ERecordType& OutType, int64& OutNextOffset) const
+	{
+		LiveLinkTake::FReader Reader(Data, RecordsEnd, Offset);
+		OutType = Reader.Read<LiveLinkTake::ERecordType>();
+		const uint32 PayloadSize = Reader.Read<uint32>();
+		OutNextOffset = Reader.Offset + PayloadSize;
+		return !Reader.bError && OutNextOffset <= RecordsEnd;
+	}
+
+	bool ReadSubject(int64 Offset, FName& OutSubjectName, TArray<FName>& OutBoneNames, TArray<int32>& OutBoneParents) const
+	{
+		LiveLinkTake::FReader Reader(Data, RecordsEnd, Offset + LiveLinkTake::RecordHeaderSize);
+		OutSubjectName = GetName(Reader.Read<uint32>());
+
+		const uint32 NumBones = Reader.Read<uint32>();
+		OutBoneNames.Reset();
+		OutBoneParents.Reset();
+		for (uint32 Idx = 0; Idx < NumBones && !Reader.bError; ++Idx)
+		{
+			OutBoneNames.Add(GetName(Reader.Read<uint32>()));
+		}
+		for (uint32 Idx = 0; Idx < NumBones && !Reader.bError; ++Idx)
+		{
+			OutBoneParents.Add(Reader.Read<int32>());
+		}
+		return !Reader.bError;
+	}
+
+	bool ReadFrame(int64 Offset, FName& OutSubjectName, TArray<FTransform>& OutTransforms, TArray<FLiveLinkCurveElement>& OutCurves, double& OutStreamTime) const
+	{
+		LiveLinkTake::FReader Reader(Data, RecordsEnd, Offset);
+		const LiveLinkTake::ERecordType Type = Reader.Read<LiveLinkTake::ERecordType>();
+		Reader.Read<uint32>();
+
+		OutSubjectName = GetName(Reader.Read<uint32>());
+		OutStreamTime = Reader.Read<double>();
+
+		if (Type == LiveLinkTake::ERecordType::CompactFrame)
+		{
+			const uint32 NumCurves = Reader.Read<uint32>();
+			if (Reader.bError || Reader.Offset + (int64)NumCurves * sizeof(uint32) > RecordsEnd)
+			{
+				return false;
+			}
+
+			const int64 CurveNamesOffset = Reader.Offset;
+			Reader.Offset += NumCurves * sizeof(uint32);
+
+			const uint32 EncodedSize = Reader.Read<uint32>();
+			if (Reader.bError || Reader.Offset + EncodedSize > RecordsEnd ||
+				!LiveLinkFrameCodec::Decode(Data + Reader.Offset, EncodedSize, OutTransforms, OutCurves) || OutCurves.Num() != NumCurves)
+			{
+				return false;
+			}
+
+			LiveLinkTake::FReader CurveNameReader(Data, RecordsEnd, CurveNamesOffset);
+			for (FLiveLinkCurveElement& Curve : OutCurves)
+			{
+				Curve.CurveName = GetName(CurveNameReader.Read<uint32>());
+			}
+			return true;
+		}
+
+		const uint32 NumTransforms = Reader.Read<uint32>();
+		if (Reader.bError || Reader.Offset + (int64)NumTransforms * LiveLinkTake::FloatsPerTransform * sizeof(float) > RecordsEnd)
+		{
+			return false;
+		}
+
+		OutTransforms.SetNum(NumTransforms, false);
+		for (FTransform& Transform : OutTransforms)
+		{
+			float Values[LiveLinkTake::FloatsPerTransform];
+			FMemory::Memcpy(Values, Data + Reader.Offset, sizeof(Values));
+			Reader.Offset += sizeof(Values);
+
+			Transform.SetComponents(FQuat(Values[0], Values[1], Values[2], Values[3]), FVector(Values[4], Values[5], Values[6]), FVector(Values[7], Values[8], Values[9]));
+		}
+
+		const uint32 NumCurves = Reader.Read<uint32>();
+		OutCurves.SetNum(Reader.bError ? 0 : NumCurves, false);
+		for (FLiveLinkCurveElement& Curve : OutCurves)
+		{
+			Curve.CurveName = GetName(Reader.Read<uint32>());
+			Curve.CurveValue = Reader.Read<float>();
+		}
+		return !Reader.bError;
+	}
+
+private:
+	FName GetName(uint32 NameIndex) const
+	{
+		return Names.IsValidIndex(NameIndex) ? Names[NameIndex] : NAME_None;
+	}
+
+	bool ReadFooter(uint64 FooterOffset)
+	{
+		RecordsEnd = FooterOffset;
+
+		LiveLinkTake::FReader Reader(Data, Size, FooterOffset);
+		const uint32 NumNames = Reader.Read<uint32>();
+		for (uint32 Idx = 0; Idx < NumNames && !Reader.bError; ++Idx)
+		{
+			Names.Add(FName(*Reader.ReadString()));
+		}
+
+		const uint32 NumSubjects = Reader.Read<uint32>();
+		for (uint32 Idx = 0; Idx < NumSubjects && !Reader.bError; ++Idx)
+		{
+			SubjectOffsets.Add(Reader.Read<uint64>());
+		}
+
+		const uint32 NumFrames = Reader.Read<uint32>();
+		for (uint32 Idx = 0; Idx < NumFrames && !Reader.bError; ++Idx)
+		{
+			FrameOffsets.Add(Reader.Read<uint64>());
+		}
+		return !Reader.bError;
+	}
+
+	/** Rebuilds the index of a take that was never closed, a partially written last record is ignored */
+	bool ScanRecords(int64 End)
+	{
+		RecordsEnd = End;
+
+		int64 Offset = LiveLinkTake::HeaderSize;
+		LiveLinkTake::ERecordType Type;
+		int64 NextOffset;
+		while (PeekRecord(Offset, Type, NextOffset))
+		{
+			switch (Type)
+			{
+			case LiveLinkTake::ERecordType::Name:
+			{
+				LiveLinkTake::FReader Reader(Data, NextOffset, Offset + LiveLinkTake::RecordHeaderSize);
+				const uint32 NameIndex = Reader.Read<uint32>();
+				const FString Name = Reader.ReadString();
+				if (Reader.bError || NameIndex != (uint32)Names.Num())
+				{
+					return false;
+				}
+				Names.Add(FName(*Name));
+				break;
+			}
+			case LiveLinkTake::ERecordType::Subject:
+				SubjectOffsets.Add(Offset);
+				break;
+			case LiveLinkTake::ERecordType::Frame:
+			case LiveLinkTake::ERecordType::CompactFrame:
+				FrameOffsets.Add(Offset);
+				break;
+			default:
+				return false;
+			}
+			Offset = NextOffset;
+		}
+
+		RecordsEnd = Offset;
+		return true;
+	}
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	const uint8* Data = nullptr;
+	int64 Size = 0;
+	int64 RecordsEnd = 0;
+
+	TArray<FName> Names;
+	TArray<int64> SubjectOffsets;
+	TArray<int64> FrameOffsets;
+};
+
+/**
+* Replays a frame range of a take at its recorded pace scaled by Speed, or as fast as possible with Speed 0. The static
+* data in effect at the first frame goes out first, the latest record of each subject before it. Used by the
+* LiveLinkReplayTake command and the standalone MayaLiveLinkReplay program, which supply where the data goes.
+*/
+class FLiveLinkTakeReplay
+{
+public:
+	FLiveLinkTakeReplay()
+		: FramesReplayed(0)
+		, bCancelRequested(false)
+	{}
+
+	/** Clears the progress and any earlier cancel, before a run is started */
+	void Reset()
+	{
+		FramesReplayed = 0;
+		bCancelRequested = false;
+	}
+
+	/** Safe from any thread, a run waiting for its next frame notices within 50ms */
+	void Cancel() { bCancelRequested = true; }
+	bool IsCancelRequested() const { return bCancelRequested.load(); }
+
+	/** Progress of the current or last run, safe from any thread */
+	int32 GetFramesReplayed() const { return FramesReplayed.load(); }
+
+	/** Returns the number of frames replayed, OnFrame gets the frame's replay time in FPlatformTime::Seconds */
+	int32 Run(const FLiveLinkTakeReader& Reader, int32 StartFrame, int32 EndFrame, double Speed,
+		TFunctionRef<void(FName, const TArray<FName>&, const TArray<int32>&)> OnSubject,
+		TFunctionRef<void(FName, const TArray<FTransform>&, const TArray<FLiveLinkCurveElement>&, double)> OnFrame)
+	{
+		StartFrame = FMath::Max(StartFrame, 0);
+		EndFrame = FMath::Min(EndFrame, Reader.GetNumFrames() - 1);
+		if (StartFrame > EndFrame)
+		{
+			return 0;
+		}
+
+		FName SubjectName;
+		TArray<FName> BoneNames;
+		TArray<int32> BoneParents;
+		TArray<FTransform> Transforms;
+		TArray<FLiveLinkCurveElement> Curves;
+
+		const int64 StartOffset = Reader.GetFrameOffset(StartFrame);
+		TMap<FName, int64> SubjectsAtStart;
+		for (int64 SubjectOffset : Reader.GetSubjectOffsets())
+		{
+			if (SubjectOffset < StartOffset && Reader.ReadSubject(SubjectOffset, SubjectName, BoneNames, BoneParents))
+			{
+				SubjectsAtStart.Add(SubjectName, SubjectOffset);
+			}
+		}
+		for (const TPair<FName, int64>& Subject : SubjectsAtStart)
+		{
+			Reader.ReadSubject(Subject.Value, SubjectName, BoneNames, BoneParents);
+			OnSubject(SubjectName, BoneNames, BoneParents);
+		}
+
+		const double ReplayStartTime = FPlatformTime::Seconds();
+		const double TimeScale = Speed > 0.0 ? 1.0 / Speed : 1.0;
+		double FirstStreamTime = 0.0;
+		int32 NumReplayed = 0;
+		const int32 FramesToReplay = EndFrame - StartFrame + 1;
+
+		int64 Offset = StartOffset;
+		LiveLinkTake::ERecordType Type;
+		int64 NextOffset;
+		while (NumReplayed < FramesToReplay && !bCancelRequested && Reader.PeekRecord(Offset, Type, NextOffset))
+		{
+			if (Type == LiveLinkTake::ERecordType::Subject)
+			{
+				if (Reader.ReadSubject(Offset, SubjectName, BoneNames, BoneParents))
+				{
+					OnSubject(SubjectName, BoneNames, BoneParents);
+				}
+			}
+			else if (Type == LiveLinkTake::ERecordType::Frame || Type == LiveLinkTake::ERecordType::CompactFrame)
+			{
+				double StreamTime;
+				if (Reader.ReadFrame(Offset, SubjectName, Transforms, Curves, StreamTime))
+				{
+					if (NumReplayed == 0)
+					{
+						FirstStreamTime = StreamTime;
+					}
+
+					const double ReplayTime = ReplayStartTime + (StreamTime - FirstStreamTime) * TimeScale;
+					if (Speed > 0.0 && !WaitUntil(ReplayTime))
+					{
+						break;
+					}
+
+					OnFrame(SubjectName, Transforms, Curves, ReplayTime);
+				}
+				FramesReplayed = ++NumReplayed;
+			}
+			Offset = NextOffset;
+		}
+
+		return NumReplayed;
+	}
+
+private:
+	/** Sleeps until Time in slices so a cancel is noticed, returns false when cancelled */
+	bool WaitUntil(double Time) const
+	{
+		const double MaxWaitSlice = 0.05;
+		for (;;)
+		{
+			if (bCancelRequested)
+			{
+				return false;
+			}
+
+			const double WaitTime = Time - FPlatformTime::Seconds();
+			if (WaitTime <= 0.0)
+			{
+				return true;
+			}
+			FPlatformProcess::Sleep((float)FMath::Min(WaitTime, MaxWaitSlice));
+		}
+	}
+
+	std::atomic<int32> FramesReplayed;
+	std::atomic<bool> bCancelRequested;
+};
@@ -3,6 +3,7 @@
 #include "RequiredProgramMainCPPInclude.h"
 #include "Misc/CommandLine.h"
 #include "Async/TaskGraphInterfaces.h"
+#include "Async/ParallelFor.h"
 #include "Modules/ModuleManager.h"
 #include "UObject/Object.h"
 #include "Misc/ConfigCacheIni.h"
@@ -11,6 +12,21 @@
 #include "LiveLinkRefSkeleton.h"
 #include "LiveLinkTypes.h"
 #include "Misc/OutputDevice.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/MemStack.h"
+#include "Misc/ScopeRWLock.h"
+#include "Containers/LockFreeList.h"
+#include "Misc/FileHelper.h"
+#include "LiveLinkJointMath.h"
+#include "LiveLinkFrameCodec.h"
+#include "LiveLinkTake.h"
+#include "LiveLinkSharedMemory.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogBlankMayaPlugin, Log, All);
 
@@ -54,8 +70,21 @@ IMPLEMENT_APPLICATION(MayaLiveLinkPlugin, "MayaLiveLinkPlugin");
 #include <maya/MUiMessage.h>
 #include <maya/MSyntax.h>
 #include <maya/MArgDatabase.h>
+#include <maya/MObjectHandle.h>
+#include <maya/MAnimUtil.h>
+#include <maya/MDGModifier.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MIntArray.h>
+#include <maya/MItDependencyNodes.h>
+#include <maya/MFnSkinCluster.h>
+#include <maya/MDagPathArray.h>
+
+#include "LiveLinkMatrixDecomposition.h"
 #undef DWORD
 
+#include <atomic>
+#include <cmath>
+
 
 #define MCHECKERROR(STAT,MSG)                   \
     if (!STAT) {                                \
@@ -78,799 +107,7299 @@ MCallbackIdArray myCallbackIds;
 
 MSpace::Space G_TransformSpace = MSpace::kTransform;
 
+// Debug output level set with LiveLinkSetOptionVerbosity: 0 off, 1 subject lifetime events, 2 validation details
+int32 DebugVerbosity = 0;
+
+// Queues a subject for validation and rebuild at the next drain, see FLiveLinkStreamedSubjectManager
+void QueueSubjectRevalidation(FName SubjectName);
+
 bool bUEInitialized = false;
 
 // User interface setting that applies a transformation to the root object so that the Subject is facing up in UE4.
 bool bCorrectForYUp = false;
 
-// Execute the python command to refresh our UI
-void RefreshUI()
-{
-	MGlobal::executeCommand("MayaLiveLinkRefreshUI");
-}
-
-void SetMatrixRow(double* Row, MVector Vec)
-{
-	Row[0] = Vec.x;
-	Row[1] = Vec.y;
-	Row[2] = Vec.z;
-}
-
-double RadToDeg(double Rad)
-{
-	const double E_PI = 3.1415926535897932384626433832795028841971693993751058209749445923078164062;
-	return (Rad*180.0) / E_PI;
-}
-
-MMatrix GetScale(const MFnIkJoint& Joint)
+// Settings for only sending subject frames that moved beyond tolerance since the last frame sent.
+struct FLiveLinkDeltaStreamSettings
 {
-	double Scale[3];
-	Joint.getScale(Scale);
-	MTransformationMatrix M;
-	M.setScale(Scale, G_TransformSpace);
-	return M.asMatrix();
-}
+	bool bEnabled = false;
 
-MMatrix GetRotationOrientation(const MFnIkJoint& Joint, MTransformationMatrix::RotationOrder& RotOrder)
-{
-	double ScaleOrientation[3];
-	Joint.getScaleOrientation(ScaleOrientation, RotOrder);
-	MTransformationMatrix M;
-	M.setRotation(ScaleOrientation, RotOrder);
-	return M.asMatrix();
-}
+	// Translation in cm, rotation in degrees
+	float PositionTolerance = 0.01f;
+	float RotationTolerance = 0.01f;
+	float ScaleTolerance = 0.0001f;
+	float CurveTolerance = 0.0001f;
 
-MMatrix GetRotation(const MFnIkJoint& Joint, MTransformationMatrix::RotationOrder& RotOrder)
-{
-	double Rotation[3];
-	Joint.getRotation(Rotation, RotOrder);
-	MTransformationMatrix M;
-	M.setRotation(Rotation, RotOrder);
-	return M.asMatrix();
-}
+	// A full frame is always sent after this many seconds so late joining editors still sync
+	double KeyframeInterval = 1.0;
+};
 
-MMatrix GetJointOrientation(const MFnIkJoint& Joint, MTransformationMatrix::RotationOrder& RotOrder)
-{
-	double JointOrientation[3];
-	Joint.getOrientation(JointOrientation, RotOrder);
-	MTransformationMatrix M;
-	M.setRotation(JointOrientation, RotOrder);
-	return M.asMatrix();
-}
+FLiveLinkDeltaStreamSettings DeltaStreamSettings;
 
-MMatrix GetTranslation(const MFnIkJoint& Joint)
+// Settings for spreading frame building over the task graph's worker threads.
+struct FLiveLinkParallelEvaluationSettings
 {
-	MVector Translation = Joint.getTranslation(G_TransformSpace);
-	MTransformationMatrix M;
-	M.setTranslation(Translation, G_TransformSpace);
-	return M.asMatrix();
-}
+	// 0 uses every core, 1 builds everything serially on the publishing thread
+	int32 MaxThreads = 0;
 
-FTransform BuildUETransformFromMayaTransform(MMatrix& InMatrix)
-{
-	MMatrix UnrealSpaceJointMatrix;
+	// Hierarchies with at least this many joints are also split over joints, 0 disables the split
+	int32 JointSplitThreshold = 512;
+	int32 JointsPerTask = 128;
 
-	// from FFbxDataConverter::ConvertMatrix
-	for (int i = 0; i < 4; ++i)
+	int32 GetNumThreads() const
 	{
-		double* Row = InMatrix[i];
-		if (i == 1)
-		{
-			UnrealSpaceJointMatrix[i][0] = -Row[0];
-			UnrealSpaceJointMatrix[i][1] = Row[1];
-			UnrealSpaceJointMatrix[i][2] = -Row[2];
-			UnrealSpaceJointMatrix[i][3] = -Row[3];
-		}
-		else
-		{
-			UnrealSpaceJointMatrix[i][0] = Row[0];
-			UnrealSpaceJointMatrix[i][1] = -Row[1];
-			UnrealSpaceJointMatrix[i][2] = Row[2];
-			UnrealSpaceJointMatrix[i][3] = Row[3];
-		}
+		return MaxThreads > 0 ? MaxThreads : FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
 	}
+};
 
-	//OutputRotation(FinalJointMatrix);
-
-	MTransformationMatrix UnrealSpaceJointTransform(UnrealSpaceJointMatrix);
-
-
-	// getRotation is MSpace::kTransform
-	double tx, ty, tz, tw;
-	UnrealSpaceJointTransform.getRotationQuaternion(tx, ty, tz, tw, MSpace::kWorld);
-
-	FTransform UETrans;
-	UETrans.SetRotation(FQuat(tx, ty, tz, tw));
-
-	MVector Translation = UnrealSpaceJointTransform.getTranslation(MSpace::kWorld);
-	UETrans.SetTranslation(FVector(Translation.x, Translation.y, Translation.z));
+FLiveLinkParallelEvaluationSettings ParallelEvaluationSettings;
 
-	double Scale[3];
-	UnrealSpaceJointTransform.getScale(Scale, MSpace::kWorld);
-	UETrans.SetScale3D(FVector((float)Scale[0], (float)Scale[1], (float)Scale[2]));
-	return UETrans;
-}
+// Bumped whenever something that is streamed may have changed without the scene time changing.
+uint64 SceneDirtyGeneration = 0;
 
-void OutputRotation(const MMatrix& M)
+void MarkSceneDirty(void* ClientData = nullptr)
 {
-	MTransformationMatrix TM(M);
-
-	MEulerRotation Euler = TM.eulerRotation();
-
-	FVector V;
-
-	V.X = RadToDeg(Euler[0]);
-	V.Y = RadToDeg(Euler[1]);
-	V.Z = RadToDeg(Euler[2]);
-	MGlobal::displayInfo(*V.ToString());
+	++SceneDirtyGeneration;
 }
 
-struct IStreamedEntity
-{
-public:
-	virtual ~IStreamedEntity() {};
-
-	virtual bool ShouldDisplayInUI() const { return false; }
-	virtual MString GetDisplayText() const = 0;
-	virtual bool ValidateSubject() const = 0;
-	virtual void RebuildSubjectData() = 0;
-	virtual void OnStream(double StreamTime, int32 FrameNumber) = 0;
-};
+// Set by panel focus and panel camera changes, the active camera is only looked up again after one of those
+bool bActiveCameraDirty = true;
 
-struct FStreamHierarchy
+void MarkActiveCameraDirty(void* ClientData = nullptr)
 {
-	FName JointName;
-	MFnIkJoint JointObject;
-	int32 ParentIndex;
-
-	FStreamHierarchy() {}
+	bActiveCameraDirty = true;
+	MarkSceneDirty();
+}
 
-	FStreamHierarchy(const FStreamHierarchy& Other)
-		: JointName(Other.JointName)
-		, JointObject(Other.JointObject.dagPath())
-		, ParentIndex(Other.ParentIndex)
-	{}
+/**
+* Counts heap allocations made through GMalloc by threads on the stream path, so steady-state streaming can be shown
+* to allocate nothing on the UE side. Maya API objects (MMatrix arrays, MString, MFn* sets) and anything else going
+* through the CRT heap bypass GMalloc and are not counted. Threads mark the stream path with FStreamPathScope.
+* ParallelFor's own task bookkeeping is excluded with FExcludeScope.
+*/
+namespace LiveLinkAllocations
+{
+	std::atomic<uint64> Allocations(0);
+	std::atomic<uint64> Reallocations(0);
+	std::atomic<uint64> Frees(0);
+	std::atomic<uint64> BytesAllocated(0);
 
-	FStreamHierarchy(FName InJointName, const MDagPath& InJointPath, int32 InParentIndex)
-		: JointName(InJointName)
-		, JointObject(InJointPath)
-		, ParentIndex(InParentIndex)
-	{}
-};
+	thread_local int32 StreamPathDepth = 0;
 
-namespace MayaSyncedUserDefinedAttributes
-{
-	bool IsPlugRelevantForSync(MPlug Plug)
+	inline bool IsOnStreamPath()
 	{
-		/*
-			Warning: MFnAttribute.isKeyable() and MPlug.isKeyable() do NOT return the same results.
-			Always check the MPlug properties instead of the MFnAttribute.
-			MPlug properties behave like getAttr in MEL.
-		*/
-		if (Plug.isLocked())
-		{
-			return false;
-		}
-		else
-		{
-			return Plug.isKeyable() || Plug.isChannelBoxFlagSet();
-		}
+		return StreamPathDepth > 0;
 	}
 
-	int CountUserDefinedAttributes(MFnIkJoint& RootJointObject)
+	class FStreamPathScope
 	{
-		int TotalAttributeCount = RootJointObject.attributeCount();
+	public:
+		FStreamPathScope() { ++StreamPathDepth; }
+		~FStreamPathScope() { --StreamPathDepth; }
+	};
 
-		int UserDefinedAttributeCount = 0;
-		int LastAttributeIndex = TotalAttributeCount - 1;
-		for (int i = LastAttributeIndex; i >= 0; i--)
-		{
-			bool IsUserDefined = static_cast<MFnAttribute>(RootJointObject.attribute(i)).isDynamic();
-			if (!IsUserDefined) break;
+	class FExcludeScope
+	{
+	public:
+		FExcludeScope() : SavedDepth(StreamPathDepth) { StreamPathDepth = 0; }
+		~FExcludeScope() { StreamPathDepth = SavedDepth; }
 
-			UserDefinedAttributeCount++;
-		}
+	private:
+		int32 SavedDepth;
+	};
 
-		return UserDefinedAttributeCount;
+	void Reset()
+	{
+		Allocations = 0;
+		Reallocations = 0;
+		Frees = 0;
+		BytesAllocated = 0;
 	}
 
-	void UpdatePropertyCurves(MFnIkJoint& RootJoint, TArray<FLiveLinkCurveElement>& Curves)
+	/** Forwards everything to the allocator it wraps, counting calls made on the stream path */
+	class FCountingMalloc : public FMalloc
 	{
-		int NumUserAttributes = CountUserDefinedAttributes(RootJoint);
+	public:
+		explicit FCountingMalloc(FMalloc* InInnerMalloc)
+			: InnerMalloc(InInnerMalloc)
+		{}
 
-		int AllRootAttributesCount = RootJoint.attributeCount();
-		int LastAttributeIndex  = AllRootAttributesCount - 1;
-		int StartAttributeIndex = AllRootAttributesCount - CountUserDefinedAttributes(RootJoint);
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			if (IsOnStreamPath())
+			{
+				Allocations.fetch_add(1, std::memory_order_relaxed);
+				BytesAllocated.fetch_add(Count, std::memory_order_relaxed);
+			}
+			return InnerMalloc->Malloc(Count, Alignment);
+		}
 
-		MStatus FindPlugStatus;
-		for (int i = StartAttributeIndex; i <= LastAttributeIndex; i++)
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
 		{
-			MPlug NewPlug = RootJoint.findPlug(static_cast<MFnAttribute>(RootJoint.attribute(i)).object(), FindPlugStatus);
-			if (FindPlugStatus == MStatus::kSuccess)
+			if (IsOnStreamPath())
 			{
-				if (IsPlugRelevantForSync(NewPlug))
-				{
-					int index = Curves.AddDefaulted();
-					Curves[index].CurveName  = FName(NewPlug.partialName().asChar());
-					Curves[index].CurveValue = NewPlug.asFloat();
-				}
+				Reallocations.fetch_add(1, std::memory_order_relaxed);
+				BytesAllocated.fetch_add(Count, std::memory_order_relaxed);
 			}
+			return InnerMalloc->Realloc(Original, Count, Alignment);
 		}
-	}
-};
 
-MString StripMayaNamespace(const MString& name)
-{
-	std::string stdname = name.asChar();
-	int charindex = stdname.rfind(":");
-	if (charindex != std::string::npos)
-	{
-		charindex++;
-		return stdname.substr(charindex).c_str();
-	}
+		virtual void Free(void* Original) override
+		{
+			if (Original && IsOnStreamPath())
+			{
+				Frees.fetch_add(1, std::memory_order_relaxed);
+			}
+			InnerMalloc->Free(Original);
+		}
 
-	return name;
+		virtual void Trim(bool bTrimThreadCaches) override { InnerMalloc->Trim(bTrimThreadCaches); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return InnerMalloc->QuantizeSize(Count, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return InnerMalloc->GetAllocationSize(Original, SizeOut); }
+		virtual void SetupTLSCachesOnCurrentThread() override { InnerMalloc->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual void InitializeStatsMetadata() override { InnerMalloc->InitializeStatsMetadata(); }
+		virtual void UpdateStats() override { InnerMalloc->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { InnerMalloc->GetAllocatorStats(OutStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { InnerMalloc->DumpAllocatorStats(Ar); }
+		virtual bool IsInternallyThreadSafe() const override { return InnerMalloc->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return InnerMalloc->ValidateHeap(); }
+		virtual const TCHAR* GetDescriptiveName() override { return InnerMalloc->GetDescriptiveName(); }
+
+	private:
+		FMalloc* InnerMalloc;
+	};
 }
 
-void ApplyCoordinateSystemCorrection(TArray<FTransform>& JointTransforms)
+/**
+* Always-on instrumentation of the streaming hot path. Every stat keeps a call count, total, min and max plus a
+* fixed-size histogram with four log-spaced buckets per power of two nanoseconds that percentiles are read from.
+* Updates are relaxed atomics so the worker and task graph threads record without locking.
+*/
+namespace LiveLinkStats
 {
-	if (bCorrectForYUp && JointTransforms.Num() > 0)
+	enum class EStat : uint8
 	{
-		FTransform OffsetTransform;
-		OffsetTransform.SetRotation(FQuat::MakeFromEuler(FVector(90, 0.0f, 0.0f)));
-		JointTransforms[0] = OffsetTransform * JointTransforms[0];
-	}
-}
-
-struct FLiveLinkStreamedJointHeirarchySubject : IStreamedEntity
-{
-	FLiveLinkStreamedJointHeirarchySubject(FName InSubjectName, MDagPath InRootPath)
-		: SubjectName(InSubjectName)
-		, RootDagPath(InRootPath)
-	{}
+		StreamSubjects,
+		CaptureFrame,
+		RebuildSubjectData,
+		ValidateSubjects,
+		UpdatePropertyCurves,
+		BuildFrames,
+		UpdateSubject,
+		UpdateSubjectFrame,
+		Count,
+	};
+
+	const TCHAR* const StatNames[(int32)EStat::Count] =
+	{
+		TEXT("StreamSubjects"),
+		TEXT("CaptureFrame"),
+		TEXT("RebuildSubjectData"),
+		TEXT("ValidateSubjects"),
+		TEXT("UpdatePropertyCurves"),
+		TEXT("BuildFrames"),
+		TEXT("UpdateSubject"),
+		TEXT("UpdateSubjectFrame"),
+	};
+
+	const int32 BucketsPerOctave = 4;
+	const int32 NumBuckets = 40 * BucketsPerOctave;
+
+	inline int32 GetBucketIndex(uint64 Nanoseconds)
+	{
+		if (Nanoseconds == 0)
+		{
+			return 0;
+		}
 
-	virtual bool ShouldDisplayInUI() const { return true; }
-	virtual MString GetDisplayText() const { return MString("Character: ") + MString(*SubjectName.ToString()) + " ( " + RootDagPath.fullPathName() + " )"; }
+		const int32 Octave = (int32)FMath::FloorLog2_64(Nanoseconds);
+		const int32 SubBucket = (Octave >= 2) ? (int32)((Nanoseconds >> (Octave - 2)) & 3) : 0;
+		return FMath::Min(Octave * BucketsPerOctave + SubBucket, NumBuckets - 1);
+	}
 
-	virtual bool ValidateSubject() const
+	inline uint64 GetBucketUpperBound(int32 BucketIndex)
 	{
-		MStatus Status;
-		bool bIsValid = RootDagPath.isValid(&Status);
-
-		TCHAR* StatusMessage = TEXT("Unset");
+		const int32 Octave = BucketIndex / BucketsPerOctave;
+		const int32 SubBucket = BucketIndex % BucketsPerOctave;
+		return (Octave >= 2) ? (uint64)(BucketsPerOctave + SubBucket + 1) << (Octave - 2) : (uint64)2 << Octave;
+	}
 
-		if (Status == MS::kSuccess)
+	struct FTimingStat
+	{
+		FTimingStat()
 		{
-			StatusMessage = TEXT("Success");
+			Reset();
 		}
-		else if (Status == MS::kFailure)
+
+		void Reset()
 		{
-			StatusMessage = TEXT("Failure");
+			Calls = 0;
+			TotalNanoseconds = 0;
+			MinNanoseconds = MAX_uint64;
+			MaxNanoseconds = 0;
+			for (std::atomic<uint64>& Bucket : Buckets)
+			{
+				Bucket = 0;
+			}
 		}
-		else
+
+		void Add(uint64 Nanoseconds)
 		{
-			StatusMessage = TEXT("Other");
+			Calls.fetch_add(1, std::memory_order_relaxed);
+			TotalNanoseconds.fetch_add(Nanoseconds, std::memory_order_relaxed);
+			Buckets[GetBucketIndex(Nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+
+			uint64 Min = MinNanoseconds.load(std::memory_order_relaxed);
+			while (Nanoseconds < Min && !MinNanoseconds.compare_exchange_weak(Min, Nanoseconds, std::memory_order_relaxed)) {}
+
+			uint64 Max = MaxNanoseconds.load(std::memory_order_relaxed);
+			while (Nanoseconds > Max && !MaxNanoseconds.compare_exchange_weak(Max, Nanoseconds, std::memory_order_relaxed)) {}
 		}
 
-		FPlatformMisc::LowLevelOutputDebugStringf(TEXT("Testing %s for removal Path:%s Valid:%s Status:%s\n"), *SubjectName.ToString(), RootDagPath.fullPathName().asWChar(), bIsValid ? TEXT("true") : TEXT("false"), StatusMessage);
-		if (Status != MS::kFailure && bIsValid)
+		/** Upper bound of the bucket holding the given fraction of calls, clamped to the max seen */
+		uint64 GetPercentile(double Fraction) const
 		{
-			//Path checks out as valid
-			MFnIkJoint Joint(RootDagPath, &Status);
-
-			MVector returnvec = Joint.getTranslation(MSpace::kWorld, &Status);
-			if (Status == MS::kSuccess)
+			const uint64 NumCalls = Calls.load(std::memory_order_relaxed);
+			if (NumCalls == 0)
 			{
-				StatusMessage = TEXT("Success");
+				return 0;
 			}
-			else if (Status == MS::kFailure)
-			{
-				StatusMessage = TEXT("Failure");
-			}
-			else
+
+			const uint64 Target = FMath::Max<uint64>((uint64)FMath::CeilToDouble(NumCalls * Fraction), 1);
+			uint64 Cumulative = 0;
+			for (int32 BucketIndex = 0; BucketIndex < NumBuckets; ++BucketIndex)
 			{
-				StatusMessage = TEXT("Other");
+				Cumulative += Buckets[BucketIndex].load(std::memory_order_relaxed);
+				if (Cumulative >= Target)
+				{
+					return FMath::Min(GetBucketUpperBound(BucketIndex), MaxNanoseconds.load(std::memory_order_relaxed));
+				}
 			}
-
-			FPlatformMisc::LowLevelOutputDebugStringf(TEXT("\tTesting %s for removal Path:%s Valid:%s Status:%s\n"), *SubjectName.ToString(), RootDagPath.fullPathName().asWChar(), bIsValid ? TEXT("true") : TEXT("false"), StatusMessage);
+			return MaxNanoseconds.load(std::memory_order_relaxed);
 		}
-		return bIsValid;
-	}
-
-	virtual void RebuildSubjectData()
-	{
-		JointsToStream.Reset();
 
-		MItDag::TraversalType traversalType = MItDag::kBreadthFirst;
-		MFn::Type filter = MFn::kJoint;
+		std::atomic<uint64> Calls;
+		std::atomic<uint64> TotalNanoseconds;
+		std::atomic<uint64> MinNanoseconds;
+		std::atomic<uint64> MaxNanoseconds;
+		std::atomic<uint64> Buckets[NumBuckets];
+	};
 
-		MStatus status;
-		MItDag JointIterator;
-		JointIterator.reset(RootDagPath, MItDag::kDepthFirst, MFn::kJoint);
+	FTimingStat TimingStats[(int32)EStat::Count];
 
-		//Build Hierarchy
-		TArray<int32> ParentIndexStack;
-		ParentIndexStack.SetNum(100, false);
+	/** Frames, static updates and approximate payload bytes sent */
+	struct FTrafficTotals
+	{
+		uint64 FramesSent = 0;
+		uint64 StaticUpdatesSent = 0;
+		uint64 BytesSent = 0;
+	};
+
+	/**
+	* Traffic counters owned by whoever streams a subject, so sending only touches that subject's atomics. Counters are
+	* registered for their lifetime and only summed per subject name when the stats are read.
+	*/
+	class FSubjectTraffic
+	{
+	public:
+		explicit FSubjectTraffic(FName InSubjectName);
+		~FSubjectTraffic();
 
-		TArray<FName> JointNames;
-		TArray<int32> JointParents;
+		void Record(bool bStaticUpdate, uint64 Bytes)
+		{
+			(bStaticUpdate ? StaticUpdatesSent : FramesSent).fetch_add(1, std::memory_order_relaxed);
+			BytesSent.fetch_add(Bytes, std::memory_order_relaxed);
+		}
 
-		int32 Index = 0;
+		FName GetSubjectName() const { return SubjectName; }
 
-		for (; !JointIterator.isDone(); JointIterator.next())
+		void AddTo(FTrafficTotals& Totals) const
 		{
-			uint32 Depth = JointIterator.depth();
-			if (Depth >= (uint32)ParentIndexStack.Num())
-			{
-				ParentIndexStack.SetNum(Depth + 1);
-			}
-			ParentIndexStack[Depth] = Index++;
+			Totals.FramesSent += FramesSent.load(std::memory_order_relaxed);
+			Totals.StaticUpdatesSent += StaticUpdatesSent.load(std::memory_order_relaxed);
+			Totals.BytesSent += BytesSent.load(std::memory_order_relaxed);
+		}
 
-			int32 ParentIndex = Depth == 0 ? -1 : ParentIndexStack[Depth - 1];
+		void Reset()
+		{
+			FramesSent = 0;
+			StaticUpdatesSent = 0;
+			BytesSent = 0;
+		}
 
-			MDagPath JointPath;
-			status = JointIterator.getPath(JointPath);
-			MFnIkJoint JointObject(JointPath);
+	private:
+		FName SubjectName;
+		std::atomic<uint64> FramesSent;
+		std::atomic<uint64> StaticUpdatesSent;
+		std::atomic<uint64> BytesSent;
+	};
 
-			//MGlobal::displayInfo(MString("Iter: ") + JointPath.fullPathName() + JointIterator.depth());
+	// Only taken when counters come and go and when the stats are read
+	FCriticalSection SubjectTrafficLock;
+	TArray<FSubjectTraffic*> LiveSubjectTraffic;
 
-			FName JointName(StripMayaNamespace(JointObject.name()).asChar());
-			JointsToStream.Add(FStreamHierarchy(JointName, JointPath, ParentIndex));
-			JointNames.Add(JointName);
-			JointParents.Add(ParentIndex);
-		}
+	// What counters that were destroyed since the last reset had counted
+	TMap<FName, FTrafficTotals> RetiredSubjectTraffic;
 
-		LiveLinkProvider->UpdateSubject(SubjectName, JointNames, JointParents);
+	FSubjectTraffic::FSubjectTraffic(FName InSubjectName)
+		: SubjectName(InSubjectName)
+		, FramesSent(0)
+		, StaticUpdatesSent(0)
+		, BytesSent(0)
+	{
+		FScopeLock Lock(&SubjectTrafficLock);
+		LiveSubjectTraffic.Add(this);
 	}
 
-	virtual void OnStream(double StreamTime, int32 FrameNumber)
+	FSubjectTraffic::~FSubjectTraffic()
 	{
-		TArray<FTransform> JointTransforms;
-		JointTransforms.Reserve(JointsToStream.Num());
-
-		TArray<MMatrix> InverseScales;
-		InverseScales.Reserve(JointsToStream.Num());
+		FScopeLock Lock(&SubjectTrafficLock);
+		LiveSubjectTraffic.RemoveSwap(this);
+		AddTo(RetiredSubjectTraffic.FindOrAdd(SubjectName));
+	}
 
-		for (int32 Idx = 0; Idx < JointsToStream.Num(); ++Idx)
+	/** Sums the live and retired counters per subject name */
+	void GatherSubjectTraffic(TMap<FName, FTrafficTotals>& OutTraffic)
+	{
+		FScopeLock Lock(&SubjectTrafficLock);
+		OutTraffic = RetiredSubjectTraffic;
+		for (const FSubjectTraffic* Traffic : LiveSubjectTraffic)
 		{
-			const FStreamHierarchy& H = JointsToStream[Idx];
-
-			MTransformationMatrix::RotationOrder RotOrder = H.JointObject.rotationOrder();
-
-			MMatrix JointScale = GetScale(H.JointObject);
-			InverseScales.Add(JointScale.inverse());
-
-			MMatrix ParentInverseScale = (H.ParentIndex == -1) ? MMatrix::identity : InverseScales[H.ParentIndex];
-
-			MMatrix MayaSpaceJointMatrix = JointScale *
-				GetRotationOrientation(H.JointObject, RotOrder) *
-				GetRotation(H.JointObject, RotOrder) *
-				GetJointOrientation(H.JointObject, RotOrder) *
-				ParentInverseScale *
-				GetTranslation(H.JointObject);
-
-			//OutputRotation(GetRotation(jointObject, RotOrder));
-			//OutputRotation(GetRotationOrientation(jointObject, RotOrder));
-			//OutputRotation(GetJointOrientation(jointObject, RotOrder));
-			//OutputRotation(TempJointMatrix);
-
-
-			JointTransforms.Add(BuildUETransformFromMayaTransform(MayaSpaceJointMatrix));
+			Traffic->AddTo(OutTraffic.FindOrAdd(Traffic->GetSubjectName()));
 		}
-
-		ApplyCoordinateSystemCorrection(JointTransforms);
-
-		TArray<FLiveLinkCurveElement> Curves;
-		MayaSyncedUserDefinedAttributes::UpdatePropertyCurves(JointsToStream[0].JointObject, Curves);
-		LiveLinkProvider->UpdateSubjectFrame(SubjectName, JointTransforms, Curves, StreamTime);
 	}
 
-private:
-	FName SubjectName;
-	MDagPath RootDagPath;
-
-	TArray<FStreamHierarchy> JointsToStream;
-};
-
-struct FLiveLinkBaseCameraStreamedSubject : public IStreamedEntity
-{
-public:
-	FLiveLinkBaseCameraStreamedSubject(FName InSubjectName) : SubjectName(InSubjectName) {}
-
-	virtual bool ValidateSubject() const { return true; }
-
-	virtual void RebuildSubjectData()
+	inline void Record(EStat Stat, uint64 Cycles)
 	{
-		LiveLinkProvider->UpdateSubject(SubjectName, ActiveCameraBoneNames, ActiveCameraBoneParents);
+		static const double NanosecondsPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1e9;
+		TimingStats[(int32)Stat].Add((uint64)(Cycles * NanosecondsPerCycle));
 	}
 
-	void StreamCamera(MDagPath CameraPath, double StreamTime, int32 FrameNumber)
+	class FScope
 	{
-		MStatus Status;
-		bool bIsValid = CameraPath.isValid(&Status);
+	public:
+		explicit FScope(EStat InStat)
+			: Stat(InStat)
+			, StartCycles(FPlatformTime::Cycles64())
+		{}
 
-		if (bIsValid && Status == MStatus::kSuccess)
+		~FScope()
 		{
-			MFnCamera C(CameraPath);
-
-			MPoint EyeLocation = C.eyePoint(MSpace::kWorld);
+			Record(Stat, FPlatformTime::Cycles64() - StartCycles);
+		}
 
-			MMatrix CameraTransformMatrix;
-			SetMatrixRow(CameraTransformMatrix[0], C.rightDirection(MSpace::kWorld));
-			SetMatrixRow(CameraTransformMatrix[1], C.viewDirection(MSpace::kWorld));
-			SetMatrixRow(CameraTransformMatrix[2], C.upDirection(MSpace::kWorld));
-			SetMatrixRow(CameraTransformMatrix[3], EyeLocation);
+	private:
+		EStat Stat;
+		uint64 StartCycles;
+	};
 
-			TArray<FTransform> CameraTransform = { BuildUETransformFromMayaTransform(CameraTransformMatrix) };
-			// Convert Maya Camera orientation to Unreal
-			CameraTransform[0].SetRotation(CameraTransform[0].GetRotation() * FRotator(0.f, -90.f, 0.f).Quaternion());
-			TArray<FLiveLinkCurveElement> Curves;
+	void Reset()
+	{
+		for (FTimingStat& Stat : TimingStats)
+		{
+			Stat.Reset();
+		}
 
-			LiveLinkProvider->UpdateSubjectFrame(SubjectName, CameraTransform, Curves, StreamTime);
+		FScopeLock Lock(&SubjectTrafficLock);
+		RetiredSubjectTraffic.Reset();
+		for (FSubjectTraffic* Traffic : LiveSubjectTraffic)
+		{
+			Traffic->Reset();
 		}
 	}
 
-protected:
-	FName  SubjectName;
-	static TArray<FName> ActiveCameraBoneNames;
-	static TArray<int32> ActiveCameraBoneParents;
+	/** One line per stat and subject, times in microseconds */
+	void GetSummary(TArray<FString>& OutLines)
+	{
+		for (int32 StatIndex = 0; StatIndex < (int32)EStat::Count; ++StatIndex)
+		{
+			const FTimingStat& Stat = TimingStats[StatIndex];
+			const uint64 Calls = Stat.Calls.load();
+			if (Calls == 0)
+			{
+				continue;
+			}
+
+			OutLines.Add(FString::Printf(TEXT("%s: calls %llu total %.1fus min %.1fus max %.1fus p50 %.1fus p95 %.1fus p99 %.1fus"),
+				StatNames[StatIndex], Calls, Stat.TotalNanoseconds.load() / 1e3, Stat.MinNanoseconds.load() / 1e3, Stat.MaxNanoseconds.load() / 1e3,
+				Stat.GetPercentile(0.5) / 1e3, Stat.GetPercentile(0.95) / 1e3, Stat.GetPercentile(0.99) / 1e3));
+		}
+
+		TMap<FName, FTrafficTotals> SubjectTraffic;
+		GatherSubjectTraffic(SubjectTraffic);
+		for (const TPair<FName, FTrafficTotals>& Traffic : SubjectTraffic)
+		{
+			OutLines.Add(FString::Printf(TEXT("%s: frames %llu static %llu bytes %llu"), *Traffic.Key.ToString(), Traffic.Value.FramesSent, Traffic.Value.StaticUpdatesSent, Traffic.Value.BytesSent));
+		}
+	}
+
+	/** Times in nanoseconds */
+	FString ToJson()
+	{
+		FString Json = TEXT("{\n\t\"stats\": {");
+		bool bFirst = true;
+		for (int32 StatIndex = 0; StatIndex < (int32)EStat::Count; ++StatIndex)
+		{
+			const FTimingStat& Stat = TimingStats[StatIndex];
+			const uint64 Calls = Stat.Calls.load();
+
+			Json += FString::Printf(TEXT("%s\n\t\t\"%s\": {\"calls\": %llu, \"total_ns\": %llu, \"min_ns\": %llu, \"max_ns\": %llu, \"p50_ns\": %llu, \"p95_ns\": %llu, \"p99_ns\": %llu}"),
+				bFirst ? TEXT("") : TEXT(","), StatNames[StatIndex], Calls, Stat.TotalNanoseconds.load(), Calls ? Stat.MinNanoseconds.load() : 0, Stat.MaxNanoseconds.load(),
+				Stat.GetPercentile(0.5), Stat.GetPercentile(0.95), Stat.GetPercentile(0.99));
+			bFirst = false;
+		}
+		Json += TEXT("\n\t},\n\t\"subjects\": {");
+
+		TMap<FName, FTrafficTotals> SubjectTraffic;
+		GatherSubjectTraffic(SubjectTraffic);
+		bFirst = true;
+		for (const TPair<FName, FTrafficTotals>& Traffic : SubjectTraffic)
+		{
+			Json += FString::Printf(TEXT("%s\n\t\t\"%s\": {\"frames_sent\": %llu, \"static_updates_sent\": %llu, \"bytes_sent\": %llu}"),
+				bFirst ? TEXT("") : TEXT(","), *Traffic.Key.ToString(), Traffic.Value.FramesSent, Traffic.Value.StaticUpdatesSent, Traffic.Value.BytesSent);
+			bFirst = false;
+		}
+		Json += TEXT("\n\t}\n}\n");
+		return Json;
+	}
+}
+
+// Execute the python command to refresh our UI
+void RefreshUI()
+{
+	MGlobal::executeCommand("MayaLiveLinkRefreshUI");
+}
+
+void SetMatrixRow(double* Row, MVector Vec)
+{
+	Row[0] = Vec.x;
+	Row[1] = Vec.y;
+	Row[2] = Vec.z;
+}
+
+double RadToDeg(double Rad)
+{
+	const double E_PI = 3.1415926535897932384626433832795028841971693993751058209749445923078164062;
+	return (Rad*180.0) / E_PI;
+}
+
+LiveLinkJointMath::ERotationOrder ToJointMathRotationOrder(MTransformationMatrix::RotationOrder RotOrder)
+{
+	using LiveLinkJointMath::ERotationOrder;
+	switch (RotOrder)
+	{
+	case MTransformationMatrix::kYZX: return ERotationOrder::YZX;
+	case MTransformationMatrix::kZXY: return ERotationOrder::ZXY;
+	case MTransformationMatrix::kXZY: return ERotationOrder::XZY;
+	case MTransformationMatrix::kYXZ: return ERotationOrder::YXZ;
+	case MTransformationMatrix::kZYX: return ERotationOrder::ZYX;
+	default: return ERotationOrder::XYZ;
+	}
+}
+
+void CaptureJointChannels(const MFnIkJoint& Joint, const LiveLinkJointMath::FJointChannels* ParentChannels, LiveLinkJointMath::FJointChannels& OutChannels)
+{
+	MTransformationMatrix::RotationOrder RotOrder;
+
+	Joint.getScale(OutChannels.Scale);
+
+	Joint.getScaleOrientation(OutChannels.ScaleOrientation, RotOrder);
+	OutChannels.ScaleOrientationOrder = ToJointMathRotationOrder(RotOrder);
+
+	Joint.getRotation(OutChannels.Rotation, RotOrder);
+	OutChannels.RotationOrder = ToJointMathRotationOrder(RotOrder);
+
+	Joint.getOrientation(OutChannels.JointOrientation, RotOrder);
+	OutChannels.JointOrientationOrder = ToJointMathRotationOrder(RotOrder);
+
+	MVector Translation = Joint.getTranslation(G_TransformSpace);
+	Translation.get(OutChannels.Translation);
+
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		OutChannels.ParentScale[Axis] = ParentChannels ? ParentChannels->Scale[Axis] : 1.0;
+	}
+}
+
+void OutputRotation(const MMatrix& M)
+{
+	MTransformationMatrix TM(M);
+
+	MEulerRotation Euler = TM.eulerRotation();
+
+	FVector V;
+
+	V.X = RadToDeg(Euler[0]);
+	V.Y = RadToDeg(Euler[1]);
+	V.Z = RadToDeg(Euler[2]);
+	MGlobal::displayInfo(*V.ToString());
+}
+
+/** Remembers the last frame sent for a subject so unchanged frames can be suppressed in delta mode */
+struct FLiveLinkSubjectFrameFilter
+{
+	explicit FLiveLinkSubjectFrameFilter(FName SubjectName)
+		: Traffic(SubjectName)
+		, LastKeyframeTime(0.0)
+		, bNeedsKeyframe(true)
+		, FramesSent(0)
+		, FramesSuppressed(0)
+	{}
+
+	// Forces the next frame through, used whenever the static data is resent
+	void Reset()
+	{
+		bNeedsKeyframe = true;
+	}
+
+	/**
+	* Live streaming stamps frames with FPlatformTime::Seconds() and baking with scene time, so time going backwards
+	* means the time base changed and the keyframe interval restarts with a keyframe.
+	*/
+	bool ShouldSend(const TArray<FTransform>& Transforms, const TArray<FLiveLinkCurveElement>& Curves, double StreamTime, bool bForceKeyframe = false)
+	{
+		const double SinceKeyframe = StreamTime - LastKeyframeTime;
+		const bool bKeyframe = bNeedsKeyframe || bForceKeyframe || !DeltaStreamSettings.bEnabled || SinceKeyframe < 0.0 || SinceKeyframe >= DeltaStreamSettings.KeyframeInterval;
+		if (!bKeyframe && !HasChanged(Transforms, Curves))
+		{
+			++FramesSuppressed;
+			return false;
+		}
+
+		if (bKeyframe)
+		{
+			LastKeyframeTime = StreamTime;
+			bNeedsKeyframe = false;
+		}
+
+		// Only keep a copy of the frame around when it will be compared against
+		if (DeltaStreamSettings.bEnabled)
+		{
+			LastTransforms.Reset(Transforms.Num());
+			LastTransforms.Append(Transforms);
+			LastCurves.Reset(Curves.Num());
+			LastCurves.Append(Curves);
+		}
+
+		++FramesSent;
+		return true;
+	}
+
+	uint64 GetFramesSent() const { return FramesSent.load(std::memory_order_relaxed); }
+	uint64 GetFramesSuppressed() const { return FramesSuppressed.load(std::memory_order_relaxed); }
+
+	LiveLinkStats::FSubjectTraffic& GetTraffic() { return Traffic; }
+
+private:
+	bool HasChanged(const TArray<FTransform>& Transforms, const TArray<FLiveLinkCurveElement>& Curves) const
+	{
+		if (Transforms.Num() != LastTransforms.Num() || Curves.Num() != LastCurves.Num())
+		{
+			return true;
+		}
+
+		const float RotationTolerance = FMath::DegreesToRadians(DeltaStreamSettings.RotationTolerance);
+		for (int32 Idx = 0; Idx < Transforms.Num(); ++Idx)
+		{
+			const FTransform& Current = Transforms[Idx];
+			const FTransform& Last = LastTransforms[Idx];
+
+			if (!Current.GetTranslation().Equals(Last.GetTranslation(), DeltaStreamSettings.PositionTolerance) ||
+				!Current.GetScale3D().Equals(Last.GetScale3D(), DeltaStreamSettings.ScaleTolerance) ||
+				Current.GetRotation().AngularDistance(Last.GetRotation()) > RotationTolerance)
+			{
+				return true;
+			}
+		}
+
+		for (int32 Idx = 0; Idx < Curves.Num(); ++Idx)
+		{
+			if (Curves[Idx].CurveName != LastCurves[Idx].CurveName ||
+				FMath::Abs(Curves[Idx].CurveValue - LastCurves[Idx].CurveValue) > DeltaStreamSettings.CurveTolerance)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	LiveLinkStats::FSubjectTraffic Traffic;
+
+	TArray<FTransform> LastTransforms;
+	TArray<FLiveLinkCurveElement> LastCurves;
+	double LastKeyframeTime;
+	bool bNeedsKeyframe;
+
+	// Counted on the publishing thread, which is the pipeline worker when streaming asynchronously, and read on the main thread
+	std::atomic<uint64> FramesSent;
+	std::atomic<uint64> FramesSuppressed;
 };
 
-TArray<FName> FLiveLinkBaseCameraStreamedSubject::ActiveCameraBoneNames = { FName("root") };
-TArray<int32> FLiveLinkBaseCameraStreamedSubject::ActiveCameraBoneParents = { -1 };
+/** Marks the scene dirty whenever one of the watched nodes is dirtied */
+class FLiveLinkNodeDirtyWatcher
+{
+public:
+	~FLiveLinkNodeDirtyWatcher()
+	{
+		Reset();
+	}
 
-struct FLiveLinkStreamedActiveCamera : public FLiveLinkBaseCameraStreamedSubject
+	void Watch(MObject Node)
+	{
+		MStatus Status;
+		MCallbackId CallbackId = MNodeMessage::addNodeDirtyCallback(Node, MarkSceneDirty, nullptr, &Status);
+		MREPORTERROR(Status, "MNodeMessage::addNodeDirtyCallback()");
+
+		if (Status == MStatus::kSuccess)
+		{
+			CallbackIds.append(CallbackId);
+		}
+	}
+
+	void Reset()
+	{
+		if (CallbackIds.length() != 0)
+		{
+			MMessage::removeCallbacks(CallbackIds);
+			CallbackIds.clear();
+		}
+	}
+
+private:
+	MCallbackIdArray CallbackIds;
+};
+
+/**
+* Flags a subject as removed as soon as Maya is about to delete or remove its root node, so validity never has to be
+* polled, and queues the subject so the manager drops it at the next drain.
+*/
+class FLiveLinkNodeRemovalWatcher
 {
 public:
-	FLiveLinkStreamedActiveCamera() : FLiveLinkBaseCameraStreamedSubject(ActiveCameraName) {}
+	FLiveLinkNodeRemovalWatcher()
+		: bRemoved(false)
+	{}
+
+	~FLiveLinkNodeRemovalWatcher()
+	{
+		Reset();
+	}
 
-	MDagPath CurrentActiveCameraDag;
+	void Watch(MObject Node, FName InSubjectName)
+	{
+		Reset();
+		SubjectName = InSubjectName;
+		bRemoved = false;
 
-	virtual MString GetDisplayText() const { return MString(); }
+		MStatus Status;
+		MCallbackId CallbackId = MNodeMessage::addNodePreRemovalCallback(Node, OnPreRemoval, this, &Status);
+		MREPORTERROR(Status, "MNodeMessage::addNodePreRemovalCallback()");
+		if (Status == MStatus::kSuccess)
+		{
+			CallbackIds.append(CallbackId);
+		}
+
+		CallbackId = MNodeMessage::addNodeAboutToDeleteCallback(Node, OnAboutToDelete, this, &Status);
+		MREPORTERROR(Status, "MNodeMessage::addNodeAboutToDeleteCallback()");
+		if (Status == MStatus::kSuccess)
+		{
+			CallbackIds.append(CallbackId);
+		}
+	}
+
+	void Reset()
+	{
+		if (CallbackIds.length() != 0)
+		{
+			MMessage::removeCallbacks(CallbackIds);
+			CallbackIds.clear();
+		}
+	}
+
+	bool IsRemoved() const { return bRemoved; }
+
+private:
+	static void OnPreRemoval(MObject& Node, void* ClientData)
+	{
+		static_cast<FLiveLinkNodeRemovalWatcher*>(ClientData)->MarkRemoved();
+	}
+
+	static void OnAboutToDelete(MObject& Node, MDGModifier& Modifier, void* ClientData)
+	{
+		static_cast<FLiveLinkNodeRemovalWatcher*>(ClientData)->MarkRemoved();
+	}
+
+	void MarkRemoved()
+	{
+		if (!bRemoved)
+		{
+			bRemoved = true;
+			if (DebugVerbosity >= 1)
+			{
+				FPlatformMisc::LowLevelOutputDebugStringf(TEXT("Live Link subject %s lost its root node\n"), *SubjectName.ToString());
+			}
+			QueueSubjectRevalidation(SubjectName);
+		}
+	}
+
+	FName SubjectName;
+	bool bRemoved;
+	MCallbackIdArray CallbackIds;
+};
+
+/**
+* Queues a subject's rebuild when one of the watched nodes changes visibility, or gets an attribute connected or
+* disconnected, e.g. keyed or unkeyed, for subjects whose set of nodes depends on either.
+*/
+class FLiveLinkNodeFilterWatcher
+{
+public:
+	FLiveLinkNodeFilterWatcher(FName InSubjectName, bool bInWatchVisibility, bool bInWatchConnections)
+		: SubjectName(InSubjectName)
+		, bWatchVisibility(bInWatchVisibility)
+		, bWatchConnections(bInWatchConnections)
+	{}
+
+	~FLiveLinkNodeFilterWatcher()
+	{
+		Reset();
+	}
 
-	virtual void OnStream(double StreamTime, int32 FrameNumber)
+	void Watch(MObject Node)
 	{
+		if (!bWatchVisibility && !bWatchConnections)
+		{
+			return;
+		}
+
 		MStatus Status;
-		M3dView ActiveView = M3dView::active3dView(&Status);
+		MCallbackId CallbackId = MNodeMessage::addAttributeChangedCallback(Node, OnAttributeChanged, this, &Status);
+		MREPORTERROR(Status, "MNodeMessage::addAttributeChangedCallback()");
 		if (Status == MStatus::kSuccess)
 		{
-			MDagPath CameraDag;
-			if (ActiveView.getCamera(CameraDag) == MStatus::kSuccess)
+			CallbackIds.append(CallbackId);
+		}
+	}
+
+	void Reset()
+	{
+		if (CallbackIds.length() != 0)
+		{
+			MMessage::removeCallbacks(CallbackIds);
+			CallbackIds.clear();
+		}
+	}
+
+private:
+	/** The attributes MDagPath::isVisible reads on a transform */
+	static bool IsVisibilityPlug(const MPlug& Plug)
+	{
+		const MString AttributeName = Plug.partialName(false, false, false, false, false, true);
+		return AttributeName == "visibility" || AttributeName == "lodVisibility" || AttributeName == "overrideEnabled" || AttributeName == "overrideVisibility";
+	}
+
+	static void OnAttributeChanged(MNodeMessage::AttributeMessage Msg, MPlug& Plug, MPlug& OtherPlug, void* ClientData)
+	{
+		FLiveLinkNodeFilterWatcher* Watcher = static_cast<FLiveLinkNodeFilterWatcher*>(ClientData);
+		const bool bConnectionChanged = (Msg & (MNodeMessage::kConnectionMade | MNodeMessage::kConnectionBroken)) != 0;
+		const bool bVisibilityChanged = (bConnectionChanged || (Msg & MNodeMessage::kAttributeSet) != 0) && IsVisibilityPlug(Plug);
+
+		if ((Watcher->bWatchConnections && bConnectionChanged) || (Watcher->bWatchVisibility && bVisibilityChanged))
+		{
+			QueueSubjectRevalidation(Watcher->SubjectName);
+		}
+	}
+
+	FName SubjectName;
+	bool bWatchVisibility;
+	bool bWatchConnections;
+	MCallbackIdArray CallbackIds;
+};
+
+/** Every DAG node under a subject's root, used to tell which subjects a DAG change touches */
+class FLiveLinkDagSubtreeIndex
+{
+public:
+	void Build(const MDagPath& InRootPath)
+	{
+		RootPath = InRootPath;
+		Nodes.Reset();
+
+		MItDag DagIterator;
+		DagIterator.reset(RootPath, MItDag::kDepthFirst, MFn::kInvalid);
+		for (; !DagIterator.isDone(); DagIterator.next())
+		{
+			Nodes.Add(MObjectHandle(DagIterator.currentItem()).hashCode());
+		}
+	}
+
+	bool IsAffectedBy(const MDagPath& Child, const MDagPath& Parent) const
+	{
+		if (!RootPath.isValid())
+		{
+			return true;
+		}
+
+		if (Nodes.Contains(MObjectHandle(Child.node()).hashCode()) || Nodes.Contains(MObjectHandle(Parent.node()).hashCode()))
+		{
+			return true;
+		}
+
+		// Reparenting one of the root's ancestors changes the root path
+		MObject ChildNode = Child.node();
+		MDagPath AncestorPath(RootPath);
+		while (AncestorPath.length() > 1)
+		{
+			AncestorPath.pop();
+			if (AncestorPath.node() == ChildNode)
 			{
-				CurrentActiveCameraDag = CameraDag;
+				return true;
 			}
 		}
 
-		StreamCamera(CurrentActiveCameraDag, StreamTime, FrameNumber);
+		return false;
 	}
 
 private:
-	static FName ActiveCameraName;
+	MDagPath RootPath;
+	TSet<uint32> Nodes;
 };
 
-struct FLiveLinkStreamedCameraSubject : FLiveLinkBaseCameraStreamedSubject
+struct FLiveLinkSubjectCapture;
+struct FLiveLinkStaticDataState;
+
+struct IStreamedEntity
 {
 public:
-	FLiveLinkStreamedCameraSubject(FName InSubjectName, MDagPath InDagPath) : FLiveLinkBaseCameraStreamedSubject(InSubjectName), CameraPath(InDagPath) {}
+	virtual ~IStreamedEntity() {};
 
-	virtual bool ShouldDisplayInUI() const { return true; }
-	virtual MString GetDisplayText() const { return MString("Camera: ") + *SubjectName.ToString() + " ( " + CameraPath.fullPathName() + " )"; }
+	virtual bool ShouldDisplayInUI() const { return false; }
+	virtual MString GetDisplayText() const = 0;
+	virtual FName GetSubjectName() const = 0;
+	virtual const FLiveLinkSubjectFrameFilter& GetFrameFilter() const = 0;
+	virtual const FLiveLinkStaticDataState& GetStaticDataState() const = 0;
+	virtual bool ValidateSubject() const = 0;
+	virtual bool IsAffectedByDagChange(const MDagPath& Child, const MDagPath& Parent) const { return true; }
+	virtual void RebuildSubjectData() = 0;
+
+	// Joints each of the subject's LOD levels streams as of the last rebuild, plus the joints under the root
+	virtual void GetLodJointCounts(TArray<TPair<FName, int32>>& OutCounts, int32& OutNumJoints) const { OutNumJoints = 0; }
+
+	// Copies everything needed to build this subject's frame, returns false if there is nothing to stream
+	virtual bool CaptureFrame(FLiveLinkSubjectCapture& OutCapture) = 0;
+};
+
+struct FStreamHierarchy
+{
+	FName JointName;
+	MFnIkJoint JointObject;
+	int32 ParentIndex;
+
+	FStreamHierarchy() {}
+
+	FStreamHierarchy(const FStreamHierarchy& Other)
+		: JointName(Other.JointName)
+		, JointObject(Other.JointObject.dagPath())
+		, ParentIndex(Other.ParentIndex)
+	{}
+
+	FStreamHierarchy(FName InJointName, const MDagPath& InJointPath, int32 InParentIndex)
+		: JointName(InJointName)
+		, JointObject(InJointPath)
+		, ParentIndex(InParentIndex)
+	{}
+};
+
+/**
+* Which joints and curves of a character subject are streamed. A joint is kept when it matches an include pattern (or
+* there are none), matches no exclude pattern, is no deeper than MaxDepth below the root and, in influence only mode,
+* drives a skinCluster. The root is always kept. Curves are kept by the same include/exclude rule on their names.
+*/
+struct FLiveLinkJointMask
+{
+	TArray<FString> IncludeJoints;
+	TArray<FString> ExcludeJoints;
+	TArray<FString> IncludeCurves;
+	TArray<FString> ExcludeCurves;
+
+	// -1 for no limit
+	int32 MaxDepth = -1;
+	bool bInfluencesOnly = false;
+
+	bool KeepsJoint(const FString& JointName, int32 Depth, bool bIsInfluence) const
+	{
+		if (Depth == 0)
+		{
+			return true;
+		}
+		if ((MaxDepth >= 0 && Depth > MaxDepth) || (bInfluencesOnly && !bIsInfluence))
+		{
+			return false;
+		}
+		return MatchesPatterns(JointName, IncludeJoints, ExcludeJoints);
+	}
+
+	bool KeepsCurve(const FString& CurveName) const
+	{
+		return MatchesPatterns(CurveName, IncludeCurves, ExcludeCurves);
+	}
+
+private:
+	static bool MatchesPatterns(const FString& Name, const TArray<FString>& Include, const TArray<FString>& Exclude)
+	{
+		auto Matches = [&Name](const FString& Pattern) { return Name.MatchesWildcard(Pattern); };
+		return (Include.Num() == 0 || Include.ContainsByPredicate(Matches)) && !Exclude.ContainsByPredicate(Matches);
+	}
+};
+
+/** Named LOD levels of joint masks per subject, only touched on Maya's main thread */
+class FLiveLinkSubjectLodRegistry
+{
+public:
+	/** The first level set for a subject becomes its active level */
+	void SetMask(FName SubjectName, FName Level, const FLiveLinkJointMask& Mask)
+	{
+		FSubjectLods& Lods = Subjects.FindOrAdd(SubjectName);
+		Lods.Levels.Add(Level, Mask);
+		if (Lods.ActiveLevel.IsNone())
+		{
+			Lods.ActiveLevel = Level;
+		}
+	}
+
+	/** Removes one level, or all of the subject's levels for NAME_None */
+	bool RemoveLevel(FName SubjectName, FName Level)
+	{
+		FSubjectLods* Lods = Subjects.Find(SubjectName);
+		if (Lods == nullptr)
+		{
+			return false;
+		}
+
+		if (Level.IsNone())
+		{
+			Subjects.Remove(SubjectName);
+			return true;
+		}
+
+		if (Lods->ActiveLevel == Level)
+		{
+			Lods->ActiveLevel = NAME_None;
+		}
+		return Lods->Levels.Remove(Level) > 0;
+	}
+
+	/** NAME_None streams every joint and curve, other levels must have been set first */
+	bool SetActiveLevel(FName SubjectName, FName Level)
+	{
+		FSubjectLods* Lods = Subjects.Find(SubjectName);
+		if (Level.IsNone() || (Lods != nullptr && Lods->Levels.Contains(Level)))
+		{
+			if (Lods != nullptr)
+			{
+				Lods->ActiveLevel = Level;
+			}
+			return true;
+		}
+		return false;
+	}
+
+	FName GetActiveLevel(FName SubjectName) const
+	{
+		const FSubjectLods* Lods = Subjects.Find(SubjectName);
+		return Lods ? Lods->ActiveLevel : NAME_None;
+	}
+
+	const FLiveLinkJointMask* FindActiveMask(FName SubjectName) const
+	{
+		const FSubjectLods* Lods = Subjects.Find(SubjectName);
+		return Lods ? Lods->Levels.Find(Lods->ActiveLevel) : nullptr;
+	}
+
+	const TMap<FName, FLiveLinkJointMask>* FindLevels(FName SubjectName) const
+	{
+		const FSubjectLods* Lods = Subjects.Find(SubjectName);
+		return Lods ? &Lods->Levels : nullptr;
+	}
+
+private:
+	struct FSubjectLods
+	{
+		TMap<FName, FLiveLinkJointMask> Levels;
+		FName ActiveLevel;
+	};
+
+	TMap<FName, FSubjectLods> Subjects;
+};
+
+FLiveLinkSubjectLodRegistry SubjectLodRegistry;
+
+/** Skin influences in the scene, as MObjectHandle hash codes, for influence only joint masks */
+void GatherSkinInfluences(TSet<uint32>& OutInfluences)
+{
+	for (MItDependencyNodes SkinIterator(MFn::kSkinClusterFilter); !SkinIterator.isDone(); SkinIterator.next())
+	{
+		MFnSkinCluster SkinCluster(SkinIterator.thisNode());
+		MDagPathArray Influences;
+		SkinCluster.influenceObjects(Influences);
+		for (unsigned int Idx = 0; Idx < Influences.length(); ++Idx)
+		{
+			OutInfluences.Add(MObjectHandle(Influences[Idx].node()).hashCode());
+		}
+	}
+}
+
+namespace MayaSyncedUserDefinedAttributes
+{
+	bool IsPlugRelevantForSync(MPlug Plug)
+	{
+		/*
+			Warning: MFnAttribute.isKeyable() and MPlug.isKeyable() do NOT return the same results.
+			Always check the MPlug properties instead of the MFnAttribute.
+			MPlug properties behave like getAttr in MEL.
+		*/
+		if (Plug.isLocked())
+		{
+			return false;
+		}
+		else
+		{
+			return Plug.isKeyable() || Plug.isChannelBoxFlagSet();
+		}
+	}
+
+	int CountUserDefinedAttributes(MFnIkJoint& RootJointObject)
+	{
+		int TotalAttributeCount = RootJointObject.attributeCount();
+
+		int UserDefinedAttributeCount = 0;
+		int LastAttributeIndex = TotalAttributeCount - 1;
+		for (int i = LastAttributeIndex; i >= 0; i--)
+		{
+			bool IsUserDefined = static_cast<MFnAttribute>(RootJointObject.attribute(i)).isDynamic();
+			if (!IsUserDefined) break;
+
+			UserDefinedAttributeCount++;
+		}
+
+		return UserDefinedAttributeCount;
+	}
+
+	/**
+	* Extra nodes whose attributes stream as curves of a subject, e.g. facial controls or blendShape weights that
+	* don't live on the root joint. Node names may use Maya wildcards and attribute names FString wildcards. On a
+	* blendShape node the pattern is matched against the weight aliases instead of the node's attributes.
+	*/
+	struct FCurveSourceSpec
+	{
+		MString NodePattern;
+		MString AttributePattern;
+		MString Prefix;
+	};
+
+	/** Curve sources per subject, only touched on Maya's main thread */
+	class FCurveSourceRegistry
+	{
+	public:
+		FCurveSourceRegistry()
+			: Generation(0)
+		{}
+
+		void AddSource(FName SubjectName, const FCurveSourceSpec& Spec)
+		{
+			TArray<FCurveSourceSpec>& SubjectSources = Sources.FindOrAdd(SubjectName);
+			for (FCurveSourceSpec& Existing : SubjectSources)
+			{
+				if (Existing.NodePattern == Spec.NodePattern && Existing.AttributePattern == Spec.AttributePattern)
+				{
+					Existing.Prefix = Spec.Prefix;
+					++Generation;
+					return;
+				}
+			}
+			SubjectSources.Add(Spec);
+			++Generation;
+		}
+
+		/** Removes the sources registered for a node pattern, or all of the subject's sources for an empty pattern */
+		int32 RemoveSources(FName SubjectName, const MString& NodePattern)
+		{
+			TArray<FCurveSourceSpec>* SubjectSources = Sources.Find(SubjectName);
+			if (SubjectSources == nullptr)
+			{
+				return 0;
+			}
+
+			int32 NumRemoved = SubjectSources->Num();
+			if (NodePattern.length() == 0)
+			{
+				Sources.Remove(SubjectName);
+			}
+			else
+			{
+				NumRemoved = SubjectSources->RemoveAll([&NodePattern](const FCurveSourceSpec& Spec) { return Spec.NodePattern == NodePattern; });
+			}
+
+			if (NumRemoved > 0)
+			{
+				++Generation;
+			}
+			return NumRemoved;
+		}
+
+		const TArray<FCurveSourceSpec>* FindSources(FName SubjectName) const
+		{
+			return Sources.Find(SubjectName);
+		}
+
+		// Bumped on every change so the plug caches know to resolve their sources again
+		uint64 GetGeneration() const { return Generation; }
+
+	private:
+		TMap<FName, TArray<FCurveSourceSpec>> Sources;
+		uint64 Generation;
+	};
+
+	FCurveSourceRegistry CurveSourceRegistry;
+
+	/**
+	* Resolved plugs and curve names for the user defined attributes on a root joint followed by the subject's
+	* registered curve sources, read into one flat array each frame.
+	* Rebuilt only when an attribute on the root or a source node is added, removed, renamed, locked/unlocked or has
+	* its keyable state toggled, a source node is removed or the subject's sources change, so the per frame work is
+	* just reading values. Channel box flag changes and new nodes matching a source pattern have no message and are
+	* picked up the next time the subject is rebuilt.
+	*/
+	class FCurvePlugCache
+	{
+	public:
+		FCurvePlugCache()
+			: bDirty(true)
+			, SourceGeneration(0)
+			, bHasCallback(false)
+		{}
+
+		~FCurvePlugCache()
+		{
+			Reset();
+		}
+
+		void Initialize(MObject RootNode, FName InSubjectName)
+		{
+			Reset();
+			SubjectName = InSubjectName;
+
+			MStatus Status;
+			CallbackId = MNodeMessage::addAttributeChangedCallback(RootNode, OnAttributeChanged, this, &Status);
+			MREPORTERROR(Status, "MNodeMessage::addAttributeChangedCallback()");
+			bHasCallback = (Status == MStatus::kSuccess);
+		}
+
+		void Reset()
+		{
+			if (bHasCallback)
+			{
+				MMessage::removeCallback(CallbackId);
+				bHasCallback = false;
+			}
+			ResetSourceCallbacks();
+
+			Plugs.Reset();
+			CurveNames.Reset();
+			bDirty = true;
+		}
+
+		/** Reads the current curve values, the names are shared and immutable so they can be handed to other threads */
+		void UpdatePropertyCurves(MFnIkJoint& RootJoint, TSharedPtr<const TArray<FName>, ESPMode::ThreadSafe>& OutCurveNames, TArray<float>& OutCurveValues)
+		{
+			LiveLinkStats::FScope Scope(LiveLinkStats::EStat::UpdatePropertyCurves);
+
+			if (NeedsRebuild())
+			{
+				Rebuild(RootJoint);
+			}
+
+			OutCurveNames = CurveNames;
+			OutCurveValues.SetNum(Plugs.Num(), false);
+			for (int32 Index = 0; Index < Plugs.Num(); ++Index)
+			{
+				OutCurveValues[Index] = Plugs[Index].asFloat();
+			}
+		}
+
+		/** Names UpdatePropertyCurves will hand out next, used to tell whether the static data changed */
+		TSharedPtr<const TArray<FName>, ESPMode::ThreadSafe> GetCurveNames(MFnIkJoint& RootJoint)
+		{
+			if (NeedsRebuild())
+			{
+				Rebuild(RootJoint);
+			}
+			return CurveNames;
+		}
+
+	private:
+		bool NeedsRebuild() const
+		{
+			return bDirty || !bHasCallback || SourceGeneration != CurveSourceRegistry.GetGeneration();
+		}
+
+		void Rebuild(MFnIkJoint& RootJoint)
+		{
+			Plugs.Reset();
+			ResetSourceCallbacks();
+			TArray<FName> NewCurveNames;
+
+			int AllRootAttributesCount = RootJoint.attributeCount();
+			int LastAttributeIndex = AllRootAttributesCount - 1;
+			int StartAttributeIndex = AllRootAttributesCount - CountUserDefinedAttributes(RootJoint);
+
+			const FLiveLinkJointMask* Mask = SubjectLodRegistry.FindActiveMask(SubjectName);
+
+			MStatus FindPlugStatus;
+			for (int i = StartAttributeIndex; i <= LastAttributeIndex; i++)
+			{
+				MPlug NewPlug = RootJoint.findPlug(static_cast<MFnAttribute>(RootJoint.attribute(i)).object(), FindPlugStatus);
+				if (FindPlugStatus == MStatus::kSuccess)
+				{
+					const MString CurveName = NewPlug.partialName();
+					if (IsPlugRelevantForSync(NewPlug) && (Mask == nullptr || Mask->KeepsCurve(UTF8_TO_TCHAR(CurveName.asChar()))))
+					{
+						Plugs.Add(NewPlug);
+						NewCurveNames.Add(FName(CurveName.asChar()));
+					}
+				}
+			}
+
+			ResolveSources(RootJoint.object(), Mask, NewCurveNames);
+
+			CurveNames = MakeShareable(new TArray<FName>(MoveTemp(NewCurveNames)));
+			SourceGeneration = CurveSourceRegistry.GetGeneration();
+			bDirty = false;
+		}
+
+		void ResolveSources(MObject RootNode, const FLiveLinkJointMask* Mask, TArray<FName>& NewCurveNames)
+		{
+			const TArray<FCurveSourceSpec>* Sources = CurveSourceRegistry.FindSources(SubjectName);
+			if (Sources == nullptr)
+			{
+				return;
+			}
+
+			TSet<FName> UsedNames;
+			UsedNames.Append(NewCurveNames);
+
+			// A node matched by several specs is watched once, the root already has its own callbacks
+			TSet<uint32> WatchedNodes;
+			WatchedNodes.Add(MObjectHandle(RootNode).hashCode());
+
+			for (const FCurveSourceSpec& Spec : *Sources)
+			{
+				// Fails when nothing matches, the pattern is tried again on the next rebuild
+				MSelectionList Nodes;
+				if (Nodes.add(Spec.NodePattern) != MS::kSuccess)
+				{
+					continue;
+				}
+
+				const FString AttributePattern(UTF8_TO_TCHAR(Spec.AttributePattern.asChar()));
+				for (unsigned int NodeIdx = 0; NodeIdx < Nodes.length(); ++NodeIdx)
+				{
+					MObject Node;
+					if (Nodes.getDependNode(NodeIdx, Node) != MS::kSuccess)
+					{
+						continue;
+					}
+
+					bool bAlreadyWatched = false;
+					WatchedNodes.Add(MObjectHandle(Node).hashCode(), &bAlreadyWatched);
+					if (!bAlreadyWatched)
+					{
+						WatchSourceNode(Node);
+					}
+
+					MFnDependencyNode NodeFn(Node);
+					if (Node.hasFn(MFn::kBlendShape))
+					{
+						MPlug WeightPlug = NodeFn.findPlug("weight");
+						MIntArray WeightIndices;
+						WeightPlug.getExistingArrayAttributeIndices(WeightIndices);
+						for (unsigned int WeightIdx = 0; WeightIdx < WeightIndices.length(); ++WeightIdx)
+						{
+							AddSourcePlug(WeightPlug.elementByLogicalIndex(WeightIndices[WeightIdx]), AttributePattern, Spec.Prefix, Mask, UsedNames, NewCurveNames);
+						}
+					}
+					else
+					{
+						for (unsigned int AttributeIdx = 0; AttributeIdx < NodeFn.attributeCount(); ++AttributeIdx)
+						{
+							MStatus FindPlugStatus;
+							MPlug Plug = NodeFn.findPlug(NodeFn.attribute(AttributeIdx), false, &FindPlugStatus);
+							if (FindPlugStatus == MStatus::kSuccess && !Plug.isArray() && !Plug.isCompound() && IsPlugRelevantForSync(Plug))
+							{
+								AddSourcePlug(Plug, AttributePattern, Spec.Prefix, Mask, UsedNames, NewCurveNames);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		/** Curves are named after the attribute's alias or long name, values are read in Maya's internal units */
+		void AddSourcePlug(const MPlug& Plug, const FString& AttributePattern, const MString& Prefix, const FLiveLinkJointMask* Mask, TSet<FName>& UsedNames, TArray<FName>& NewCurveNames)
+		{
+			const MString AttributeName = Plug.partialName(false, false, false, true, false, true);
+			if (!FString(UTF8_TO_TCHAR(AttributeName.asChar())).MatchesWildcard(AttributePattern) ||
+				(Mask != nullptr && !Mask->KeepsCurve(UTF8_TO_TCHAR((Prefix + AttributeName).asChar()))))
+			{
+				return;
+			}
+
+			const FName CurveName((Prefix + AttributeName).asChar());
+			if (UsedNames.Contains(CurveName))
+			{
+				MGlobal::displayWarning(MString("Live Link: curve ") + Prefix + AttributeName + " on " + Plug.name() + " is already streamed for " + MString(*SubjectName.ToString()) + ", use a prefix to keep both");
+				return;
+			}
+
+			UsedNames.Add(CurveName);
+			Plugs.Add(Plug);
+			NewCurveNames.Add(CurveName);
+		}
+
+		void WatchSourceNode(MObject Node)
+		{
+			MStatus Status;
+			MCallbackId SourceCallbackId = MNodeMessage::addAttributeChangedCallback(Node, OnAttributeChanged, this, &Status);
+			if (Status == MStatus::kSuccess)
+			{
+				SourceCallbackIds.append(SourceCallbackId);
+			}
+
+			// Removed sources must never be read again, a dirty source has to stream even when nothing else moved
+			SourceCallbackId = MNodeMessage::addNodePreRemovalCallback(Node, OnSourceRemoved, this, &Status);
+			if (Status == MStatus::kSuccess)
+			{
+				SourceCallbackIds.append(SourceCallbackId);
+			}
+
+			SourceCallbackId = MNodeMessage::addNodeDirtyCallback(Node, MarkSceneDirty, nullptr, &Status);
+			if (Status == MStatus::kSuccess)
+			{
+				SourceCallbackIds.append(SourceCallbackId);
+			}
+		}
+
+		void ResetSourceCallbacks()
+		{
+			if (SourceCallbackIds.length() != 0)
+			{
+				MMessage::removeCallbacks(SourceCallbackIds);
+				SourceCallbackIds.clear();
+			}
+		}
+
+		static void OnSourceRemoved(MObject& Node, void* ClientData)
+		{
+			static_cast<FCurvePlugCache*>(ClientData)->bDirty = true;
+			MarkSceneDirty();
+		}
+
+		static void OnAttributeChanged(MNodeMessage::AttributeMessage Msg, MPlug& Plug, MPlug& OtherPlug, void* ClientData)
+		{
+			const int LayoutChangeMask = MNodeMessage::kAttributeAdded | MNodeMessage::kAttributeRemoved | MNodeMessage::kAttributeRenamed |
+				MNodeMessage::kAttributeLocked | MNodeMessage::kAttributeUnlocked | MNodeMessage::kAttributeKeyable | MNodeMessage::kAttributeUnkeyable;
+
+			if (Msg & LayoutChangeMask)
+			{
+				static_cast<FCurvePlugCache*>(ClientData)->bDirty = true;
+			}
+		}
+
+		FName SubjectName;
+		TArray<MPlug> Plugs;
+		TSharedPtr<const TArray<FName>, ESPMode::ThreadSafe> CurveNames;
+		bool bDirty;
+		uint64 SourceGeneration;
+
+		MCallbackId CallbackId;
+		bool bHasCallback;
+		MCallbackIdArray SourceCallbackIds;
+	};
+};
+
+MString StripMayaNamespace(const MString& name)
+{
+	std::string stdname = name.asChar();
+	int charindex = stdname.rfind(":");
+	if (charindex != std::string::npos)
+	{
+		charindex++;
+		return stdname.substr(charindex).c_str();
+	}
+
+	return name;
+}
+
+void ApplyCoordinateSystemCorrection(TArray<FTransform>& JointTransforms, bool bApplyCorrection)
+{
+	if (bApplyCorrection && JointTransforms.Num() > 0)
+	{
+		FTransform OffsetTransform;
+		OffsetTransform.SetRotation(FQuat::MakeFromEuler(FVector(90, 0.0f, 0.0f)));
+		JointTransforms[0] = OffsetTransform * JointTransforms[0];
+	}
+}
+
+namespace LiveLinkFrameCodec
+{
+	/** Per subject encoding choice, read by whichever thread publishes */
+	class FRegistry
+	{
+	public:
+		void SetSettings(FName SubjectName, const FSettings& Settings)
+		{
+			FScopeLock Lock(&CriticalSection);
+			if (SubjectName.IsNone())
+			{
+				DefaultSettings = Settings;
+			}
+			else
+			{
+				SubjectSettings.Add(SubjectName, Settings);
+			}
+		}
+
+		void ClearSettings(FName SubjectName)
+		{
+			FScopeLock Lock(&CriticalSection);
+			SubjectSettings.Remove(SubjectName);
+		}
+
+		FSettings GetSettings(FName SubjectName) const
+		{
+			FScopeLock Lock(&CriticalSection);
+			const FSettings* Found = SubjectSettings.Find(SubjectName);
+			return Found ? *Found : DefaultSettings;
+		}
+
+	private:
+		mutable FCriticalSection CriticalSection;
+		FSettings DefaultSettings;
+		TMap<FName, FSettings> SubjectSettings;
+	};
+
+	FRegistry Registry;
+}
+
+/** Appends everything sent to the provider to a take file, see LiveLinkTake for the layout */
+class FLiveLinkTakeRecorder
+{
+public:
+	FLiveLinkTakeRecorder()
+		: bRecording(false)
+	{}
+
+	~FLiveLinkTakeRecorder()
+	{
+		Stop();
+	}
+
+	bool IsRecording() const { return bRecording.load(); }
+
+	bool Start(const FString& Filename)
+	{
+		Stop();
+
+		FScopeLock Lock(&CriticalSection);
+
+		Writer.Reset(IFileManager::Get().CreateFileWriter(*Filename));
+		if (!Writer.IsValid())
+		{
+			return false;
+		}
+
+		Names.Reset();
+		NameIndices.Reset();
+		SubjectOffsets.Reset();
+		FrameOffsets.Reset();
+		PositionRanges.Reset();
+
+		Record.Reset();
+		LiveLinkTake::Append(Record, LiveLinkTake::Magic);
+		LiveLinkTake::Append(Record, LiveLinkTake::Version);
+		LiveLinkTake::Append(Record, (uint64)0);
+		Writer->Serialize(Record.GetData(), Record.Num());
+
+		bRecording = true;
+		return true;
+	}
+
+	/** Writes the footer and patches its offset into the header */
+	void Stop()
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if (!Writer.IsValid())
+		{
+			return;
+		}
+		bRecording = false;
+
+		uint64 FooterOffset = Writer->Tell();
+
+		Record.Reset();
+		LiveLinkTake::Append(Record, (uint32)Names.Num());
+		for (const FName& Name : Names)
+		{
+			LiveLinkTake::AppendString(Record, Name.ToString());
+		}
+		LiveLinkTake::Append(Record, (uint32)SubjectOffsets.Num());
+		Record.Append(reinterpret_cast<const uint8*>(SubjectOffsets.GetData()), SubjectOffsets.Num() * sizeof(uint64));
+		LiveLinkTake::Append(Record, (uint32)FrameOffsets.Num());
+		Record.Append(reinterpret_cast<const uint8*>(FrameOffsets.GetData()), FrameOffsets.Num() * sizeof(uint64));
+		Writer->Serialize(Record.GetData(), Record.Num());
+
+		Writer->Seek(sizeof(uint32) * 2);
+		Writer->Serialize(&FooterOffset, sizeof(uint64));
+		Writer->Close();
+		Writer.Reset();
+	}
+
+	void RecordSubject(FName SubjectName, const TArray<FName>& BoneNames, const TArray<int32>& BoneParents)
+	{
+		if (!IsRecording())
+		{
+			return;
+		}
+
+		FScopeLock Lock(&CriticalSection);
+		if (!Writer.IsValid())
+		{
+			return;
+		}
+
+		const uint32 SubjectNameIndex = GetNameIndex(SubjectName);
+		BoneNameIndices.Reset();
+		for (const FName& BoneName : BoneNames)
+		{
+			BoneNameIndices.Add(GetNameIndex(BoneName));
+		}
+
+		BeginRecord(LiveLinkTake::ERecordType::Subject);
+		LiveLinkTake::Append(Record, SubjectNameIndex);
+		LiveLinkTake::Append(Record, (uint32)BoneNames.Num());
+		Record.Append(reinterpret_cast<const uint8*>(BoneNameIndices.GetData()), BoneNameIndices.Num() * sizeof(uint32));
+		Record.Append(reinterpret_cast<const uint8*>(BoneParents.GetData()), BoneParents.Num() * sizeof(int32));
+		SubjectOffsets.Add(EndRecord());
+	}
+
+	void RecordFrame(FName SubjectName, const TArray<FTransform>& Transforms, const TArray<FLiveLinkCurveElement>& Curves, double StreamTime)
+	{
+		if (!IsRecording())
+		{
+			return;
+		}
+
+		FScopeLock Lock(&CriticalSection);
+		if (!Writer.IsValid())
+		{
+			return;
+		}
+
+		const uint32 SubjectNameIndex = GetNameIndex(SubjectName);
+		BoneNameIndices.Reset();
+		for (const FLiveLinkCurveElement& Curve : Curves)
+		{
+			BoneNameIndices.Add(GetNameIndex(Curve.CurveName));
+		}
+
+		const LiveLinkFrameCodec::FSettings EncodingSettings = LiveLinkFrameCodec::Registry.GetSettings(SubjectName);
+		if (EncodingSettings.Encoding == LiveLinkFrameCodec::EEncoding::Compact && LiveLinkFrameCodec::CanEncode(Transforms.Num(), Curves.Num()))
+		{
+			BeginRecord(LiveLinkTake::ERecordType::CompactFrame);
+			LiveLinkTake::Append(Record, SubjectNameIndex);
+			LiveLinkTake::Append(Record, StreamTime);
+			LiveLinkTake::Append(Record, (uint32)Curves.Num());
+			Record.Append(reinterpret_cast<const uint8*>(BoneNameIndices.GetData()), BoneNameIndices.Num() * sizeof(uint32));
+
+			const int32 SizeOffset = Record.Num();
+			LiveLinkTake::Append(Record, (uint32)0);
+			LiveLinkFrameCodec::Encode(Transforms, Curves, EncodingSettings, PositionRanges.FindOrAdd(SubjectName), Record);
+			*reinterpret_cast<uint32*>(Record.GetData() + SizeOffset) = Record.Num() - SizeOffset - sizeof(uint32);
+
+			FrameOffsets.Add(EndRecord());
+			return;
+		}
+
+		BeginRecord(LiveLinkTake::ERecordType::Frame);
+		LiveLinkTake::Append(Record, SubjectNameIndex);
+		LiveLinkTake::Append(Record, StreamTime);
+		LiveLinkTake::Append(Record, (uint32)Transforms.Num());
+		for (const FTransform& Transform : Transforms)
+		{
+			const FQuat Rotation = Transform.GetRotation();
+			const FVector Translation = Transform.GetTranslation();
+			const FVector Scale = Transform.GetScale3D();
+			const float Values[LiveLinkTake::FloatsPerTransform] = { Rotation.X, Rotation.Y, Rotation.Z, Rotation.W, Translation.X, Translation.Y, Translation.Z, Scale.X, Scale.Y, Scale.Z };
+			Record.Append(reinterpret_cast<const uint8*>(Values), sizeof(Values));
+		}
+		LiveLinkTake::Append(Record, (uint32)Curves.Num());
+		for (int32 Idx = 0; Idx < Curves.Num(); ++Idx)
+		{
+			LiveLinkTake::Append(Record, BoneNameIndices[Idx]);
+			LiveLinkTake::Append(Record, Curves[Idx].CurveValue);
+		}
+		FrameOffsets.Add(EndRecord());
+	}
+
+	int32 GetFramesRecorded() const { return FrameOffsets.Num(); }
+
+private:
+	uint32 GetNameIndex(FName Name)
+	{
+		if (const uint32* Found = NameIndices.Find(Name))
+		{
+			return *Found;
+		}
+
+		const uint32 NameIndex = Names.Add(Name);
+		NameIndices.Add(Name, NameIndex);
+
+		// Written inline too so a take without a footer can still be read
+		TArray<uint8> NameRecord;
+		LiveLinkTake::Append(NameRecord, LiveLinkTake::ERecordType::Name);
+		LiveLinkTake::Append(NameRecord, (uint32)0);
+		LiveLinkTake::Append(NameRecord, NameIndex);
+		LiveLinkTake::AppendString(NameRecord, Name.ToString());
+		*reinterpret_cast<uint32*>(NameRecord.GetData() + sizeof(uint8)) = NameRecord.Num() - LiveLinkTake::RecordHeaderSize;
+		Writer->Serialize(NameRecord.GetData(), NameRecord.Num());
+
+		return NameIndex;
+	}
+
+	void BeginRecord(LiveLinkTake::ERecordType Type)
+	{
+		Record.Reset();
+		LiveLinkTake::Append(Record, Type);
+		LiveLinkTake::Append(Record, (uint32)0);
+	}
+
+	uint64 EndRecord()
+	{
+		const uint64 Offset = Writer->Tell();
+		*reinterpret_cast<uint32*>(Record.GetData() + sizeof(uint8)) = Record.Num() - LiveLinkTake::RecordHeaderSize;
+		Writer->Serialize(Record.GetData(), Record.Num());
+		return Offset;
+	}
+
+	FCriticalSection CriticalSection;
+	std::atomic<bool> bRecording;
+	TUniquePtr<FArchive> Writer;
+
+	TArray<uint8> Record;
+	TArray<uint32> BoneNameIndices;
+
+	TArray<FName> Names;
+	TMap<FName, uint32> NameIndices;
+	TArray<uint64> SubjectOffsets;
+	TArray<uint64> FrameOffsets;
+
+	// Compact frames quantize translations over their subject's range so far
+	TMap<FName, LiveLinkFrameCodec::FPositionRange> PositionRanges;
+};
+
+FLiveLinkTakeRecorder TakeRecorder;
+
+/** A subject frame as handed to the endpoints, built once and shared read only between them */
+struct FLiveLinkEncodedFrame
+{
+	FName SubjectName;
+	TArray<FTransform> Transforms;
+	TArray<FLiveLinkCurveElement> Curves;
+	double StreamTime;
+
+	std::atomic<int32> NumReferences;
+};
+
+/**
+* Encoded frames are recycled with their arrays' allocations, so once every subject has a frame in flight publishing
+* allocates nothing. Frames go back to the pool when their last reference is released, on whichever thread that is.
+*/
+class FLiveLinkEncodedFramePool
+{
+public:
+	~FLiveLinkEncodedFramePool()
+	{
+		while (FLiveLinkEncodedFrame* Frame = FreeFrames.Pop())
+		{
+			delete Frame;
+		}
+	}
+
+	FLiveLinkEncodedFrame* Acquire()
+	{
+		FLiveLinkEncodedFrame* Frame = FreeFrames.Pop();
+		if (Frame == nullptr)
+		{
+			Frame = new FLiveLinkEncodedFrame();
+		}
+		Frame->NumReferences.store(0, std::memory_order_relaxed);
+		return Frame;
+	}
+
+	void Release(FLiveLinkEncodedFrame* Frame)
+	{
+		FreeFrames.Push(Frame);
+	}
+
+private:
+	TLockFreePointerListUnordered<FLiveLinkEncodedFrame, PLATFORM_CACHE_LINE_SIZE> FreeFrames;
+};
+
+FLiveLinkEncodedFramePool EncodedFramePool;
+
+/** Intrusive reference to a pooled frame, a shared pointer would allocate its reference controller per frame */
+class FLiveLinkEncodedFrameRef
+{
+public:
+	FLiveLinkEncodedFrameRef()
+		: Frame(nullptr)
+	{}
+
+	explicit FLiveLinkEncodedFrameRef(FLiveLinkEncodedFrame* InFrame)
+		: Frame(InFrame)
+	{
+		AddReference();
+	}
+
+	FLiveLinkEncodedFrameRef(const FLiveLinkEncodedFrameRef& Other)
+		: Frame(Other.Frame)
+	{
+		AddReference();
+	}
+
+	FLiveLinkEncodedFrameRef(FLiveLinkEncodedFrameRef&& Other)
+		: Frame(Other.Frame)
+	{
+		Other.Frame = nullptr;
+	}
+
+	~FLiveLinkEncodedFrameRef()
+	{
+		Reset();
+	}
+
+	FLiveLinkEncodedFrameRef& operator=(const FLiveLinkEncodedFrameRef& Other)
+	{
+		if (Frame != Other.Frame)
+		{
+			Reset();
+			Frame = Other.Frame;
+			AddReference();
+		}
+		return *this;
+	}
+
+	FLiveLinkEncodedFrameRef& operator=(FLiveLinkEncodedFrameRef&& Other)
+	{
+		if (this != &Other)
+		{
+			Reset();
+			Frame = Other.Frame;
+			Other.Frame = nullptr;
+		}
+		return *this;
+	}
+
+	void Reset()
+	{
+		if (Frame != nullptr && Frame->NumReferences.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			EncodedFramePool.Release(Frame);
+		}
+		Frame = nullptr;
+	}
+
+	bool IsValid() const { return Frame != nullptr; }
+	const FLiveLinkEncodedFrame* operator->() const { return Frame; }
+	const FLiveLinkEncodedFrame& operator*() const { return *Frame; }
+
+private:
+	void AddReference()
+	{
+		if (Frame != nullptr)
+		{
+			Frame->NumReferences.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	FLiveLinkEncodedFrame* Frame;
+};
+
+struct FLiveLinkEncodedSubject
+{
+	FName SubjectName;
+	TArray<FName> BoneNames;
+	TArray<int32> BoneParents;
+};
+
+typedef TSharedPtr<const FLiveLinkEncodedSubject, ESPMode::ThreadSafe> FLiveLinkEncodedSubjectPtr;
+
+/**
+* A provider with its own thread and send queue, so a slow connection only holds up itself and its sender. Updates are
+* sent in the order they were queued. By default every frame is delivered, and the sender waits once MaxKeptFrames are
+* queued. Endpoints that opt into dropping frames only keep the latest queued frame of each subject, older ones count
+* as dropped, except for frames the sender asked to keep (baking a range, replaying a take). Static updates are never
+* dropped and replace any droppable frame of their subject still waiting, since that frame was built for the previous
+* skeleton.
+*/
+class FLiveLinkEndpoint : public FRunnable
+{
+public:
+	FLiveLinkEndpoint(const FString& InProviderName, double InMaxRate)
+		: FLiveLinkEndpoint(ILiveLinkProvider::CreateLiveLinkProvider(InProviderName), InProviderName, InMaxRate, false)
+	{}
+
+	FLiveLinkEndpoint(const TSharedPtr<ILiveLinkProvider>& InProvider, const FString& InProviderName, double InMaxRate, bool bInPrimary)
+		: ProviderName(InProviderName)
+		, Provider(InProvider)
+		, MaxRate(InMaxRate)
+		, bPrimary(bInPrimary)
+		, bDropFrames(false)
+		, Thread(nullptr)
+		, WorkEvent(nullptr)
+		, FrameConsumedEvent(nullptr)
+		, bStopRequested(false)
+		, KeptFramesWaiting(0)
+		, FramesQueued(0)
+		, FramesSent(0)
+		, FramesDropped(0)
+		, SubjectsSent(0)
+	{
+		WorkEvent = FPlatformProcess::GetSynchEventFromPool(false);
+		FrameConsumedEvent = FPlatformProcess::GetSynchEventFromPool(false);
+		Thread = FRunnableThread::Create(this, *(TEXT("LiveLinkEndpoint ") + ProviderName));
+	}
+
+	virtual ~FLiveLinkEndpoint()
+	{
+		bStopRequested = true;
+		WorkEvent->Trigger();
+		Thread->WaitForCompletion();
+		delete Thread;
+
+		FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+		FPlatformProcess::ReturnSynchEventToPool(FrameConsumedEvent);
+		Provider = nullptr;
+	}
+
+	const FString& GetProviderName() const { return ProviderName; }
+	bool IsPrimary() const { return bPrimary; }
+	bool HasConnection() const { return Provider.IsValid() && Provider->HasConnection(); }
+
+	/** 0 sends as fast as frames arrive */
+	void SetMaxRate(double InMaxRate) { MaxRate = FMath::Max(InMaxRate, 0.0); }
+	double GetMaxRate() const { return MaxRate; }
+
+	/** Off by default, an endpoint that drops frames only sends each subject's latest one */
+	void SetDropFrames(bool bInDropFrames) { bDropFrames = bInDropFrames; }
+	bool GetDropFrames() const { return bDropFrames.load(); }
+
+	void EnqueueSubject(const FLiveLinkEncodedSubjectPtr& Subject)
+	{
+		{
+			FScopeLock Lock(&CriticalSection);
+			DropLatestFrameLocked(Subject->SubjectName);
+			PendingUpdates.Add(FUpdate(Subject));
+		}
+		WorkEvent->Trigger();
+	}
+
+	/** Any frame of the subject still waiting would bring it back, so it is dropped */
+	void EnqueueClear(FName SubjectName)
+	{
+		{
+			FScopeLock Lock(&CriticalSection);
+			DropLatestFrameLocked(SubjectName);
+			PendingUpdates.Add(FUpdate(SubjectName));
+		}
+		WorkEvent->Trigger();
+	}
+
+	/** bAllowDrop false keeps the frame even on an endpoint that drops frames */
+	void EnqueueFrame(const FLiveLinkEncodedFrameRef& Frame, bool bAllowDrop)
+	{
+		const bool bKeep = !bDropFrames.load() || !bAllowDrop;
+		if (bKeep)
+		{
+			// The endpoint thread triggers FrameConsumedEvent after each batch of kept frames it sends
+			while (KeptFramesWaiting.load() >= MaxKeptFrames && !bStopRequested.load())
+			{
+				FrameConsumedEvent->Wait(10);
+			}
+		}
+
+		{
+			FScopeLock Lock(&CriticalSection);
+			++FramesQueued;
+
+			if (bKeep)
+			{
+				// Later droppable frames of the subject must not overtake this one
+				LatestFrameIndices.Remove(Frame->SubjectName);
+				PendingUpdates.Add(FUpdate(Frame, true));
+				++KeptFramesWaiting;
+			}
+			else if (const int32* Index = LatestFrameIndices.Find(Frame->SubjectName))
+			{
+				PendingUpdates[*Index].Frame = Frame;
+				++FramesDropped;
+			}
+			else
+			{
+				LatestFrameIndices.Add(Frame->SubjectName, PendingUpdates.Add(FUpdate(Frame, false)));
+			}
+		}
+		WorkEvent->Trigger();
+	}
+
+	int32 GetQueueDepth() const
+	{
+		FScopeLock Lock(&CriticalSection);
+		return PendingUpdates.Num();
+	}
+
+	uint64 GetFramesQueued() const { return FramesQueued.load(); }
+	uint64 GetFramesSent() const { return FramesSent.load(); }
+	uint64 GetFramesDropped() const { return FramesDropped.load(); }
+	uint64 GetSubjectsSent() const { return SubjectsSent.load(); }
+
+	void ResetStats()
+	{
+		FramesQueued = 0;
+		FramesSent = 0;
+		FramesDropped = 0;
+		SubjectsSent = 0;
+	}
+
+	//~ Begin FRunnable interface
+	virtual uint32 Run() override
+	{
+		double NextSendTime = 0.0;
+		while (!bStopRequested.load())
+		{
+			const double Now = FPlatformTime::Seconds();
+			if (Now < NextSendTime)
+			{
+				WorkEvent->Wait(FMath::Max(1, (int32)((NextSendTime - Now) * 1000.0)));
+				continue;
+			}
+
+			{
+				FScopeLock Lock(&CriticalSection);
+				Swap(PendingUpdates, SendingUpdates);
+				LatestFrameIndices.Reset();
+			}
+
+			if (SendingUpdates.Num() == 0)
+			{
+				WorkEvent->Wait(10);
+				continue;
+			}
+
+			bool bSentKeptFrames = false;
+			for (const FUpdate& Update : SendingUpdates)
+			{
+				if (Update.Subject.IsValid())
+				{
+					LiveLinkStats::FScope Scope(LiveLinkStats::EStat::UpdateSubject);
+					Provider->UpdateSubject(Update.Subject->SubjectName, Update.Subject->BoneNames, Update.Subject->BoneParents);
+					++SubjectsSent;
+				}
+				else if (Update.Frame.IsValid())
+				{
+					const FLiveLinkEncodedFrame& Frame = *Update.Frame;
+					LiveLinkStats::FScope Scope(LiveLinkStats::EStat::UpdateSubjectFrame);
+					Provider->UpdateSubjectFrame(Frame.SubjectName, Frame.Transforms, Frame.Curves, Frame.StreamTime);
+					++FramesSent;
+				}
+				else if (!Update.ClearedSubjectName.IsNone())
+				{
+					Provider->ClearSubject(Update.ClearedSubjectName);
+				}
+
+				if (Update.bKept)
+				{
+					--KeptFramesWaiting;
+					bSentKeptFrames = true;
+				}
+			}
+			SendingUpdates.Reset();
+
+			if (bSentKeptFrames)
+			{
+				FrameConsumedEvent->Trigger();
+			}
+
+			const double Rate = MaxRate;
+			NextSendTime = (Rate > 0.0) ? Now + 1.0 / Rate : 0.0;
+		}
+		return 0;
+	}
+	//~ End FRunnable interface
+
+private:
+	static const int32 MaxKeptFrames = 1024;
+
+	/** A static update, a frame or a cleared subject, a dropped frame leaves an update with none of them */
+	struct FUpdate
+	{
+		explicit FUpdate(const FLiveLinkEncodedSubjectPtr& InSubject)
+			: Subject(InSubject)
+			, bKept(false)
+		{}
+
+		explicit FUpdate(FName InClearedSubjectName)
+			: ClearedSubjectName(InClearedSubjectName)
+			, bKept(false)
+		{}
+
+		FUpdate(const FLiveLinkEncodedFrameRef& InFrame, bool bInKept)
+			: Frame(InFrame)
+			, bKept(bInKept)
+		{}
+
+		FLiveLinkEncodedSubjectPtr Subject;
+		FLiveLinkEncodedFrameRef Frame;
+		FName ClearedSubjectName;
+		bool bKept;
+	};
+
+	void DropLatestFrameLocked(FName SubjectName)
+	{
+		int32 Index;
+		if (LatestFrameIndices.RemoveAndCopyValue(SubjectName, Index))
+		{
+			PendingUpdates[Index].Frame.Reset();
+			++FramesDropped;
+		}
+	}
+
+	FString ProviderName;
+	TSharedPtr<ILiveLinkProvider> Provider;
+	std::atomic<double> MaxRate;
+	bool bPrimary;
+	std::atomic<bool> bDropFrames;
+
+	FRunnableThread* Thread;
+	FEvent* WorkEvent;
+	// Wakes a sender waiting for room for kept frames
+	FEvent* FrameConsumedEvent;
+	std::atomic<bool> bStopRequested;
+
+	mutable FCriticalSection CriticalSection;
+	TArray<FUpdate> PendingUpdates;
+	// Index in PendingUpdates of each subject's droppable frame
+	TMap<FName, int32> LatestFrameIndices;
+
+	// Only touched by the endpoint thread, swapped with the pending updates to keep both allocations
+	TArray<FUpdate> SendingUpdates;
+
+	std::atomic<int32> KeptFramesWaiting;
+
+	std::atomic<uint64> FramesQueued;
+	std::atomic<uint64> FramesSent;
+	std::atomic<uint64> FramesDropped;
+	std::atomic<uint64> SubjectsSent;
+};
+
+/**
+* Fans everything sent out to the endpoints, starting with the primary provider created with the plugin. Each frame
+* is copied once into a pooled buffer that all endpoints reference. Publishing a frame only holds the endpoint list's
+* lock to take references to the endpoints, so a sender waiting on a slow lossless endpoint doesn't hold up endpoints
+* coming and going or static updates. Static data is kept per subject until the subject goes away, so endpoints added
+* later get the latest static data of every subject first.
+*/
+class FLiveLinkEndpointHub
+{
+public:
+	FLiveLinkEndpointHub()
+		: bHasEndpoints(false)
+	{}
+
+	bool HasEndpoints() const { return bHasEndpoints.load(); }
+
+	void SetPrimaryProvider(const TSharedPtr<ILiveLinkProvider>& Provider, const FString& ProviderName)
+	{
+		FRWScopeLock Lock(EndpointsLock, SLT_Write);
+		Endpoints.RemoveAll([](const FEndpointPtr& Endpoint) { return Endpoint->IsPrimary(); });
+		if (Provider.IsValid())
+		{
+			Endpoints.Insert(MakeShared<FLiveLinkEndpoint, ESPMode::ThreadSafe>(Provider, ProviderName, 0.0, true), 0);
+		}
+		bHasEndpoints = Endpoints.Num() > 0;
+	}
+
+	bool AddEndpoint(const FString& ProviderName, double MaxRate, bool bDropFrames)
+	{
+		FRWScopeLock Lock(EndpointsLock, SLT_Write);
+		if (FindEndpoint(ProviderName) != INDEX_NONE)
+		{
+			return false;
+		}
+
+		Endpoints.Add(MakeShared<FLiveLinkEndpoint, ESPMode::ThreadSafe>(ProviderName, MaxRate));
+		Endpoints.Last()->SetDropFrames(bDropFrames);
+		for (const TPair<FName, FLiveLinkEncodedSubjectPtr>& Pair : LatestSubjects)
+		{
+			Endpoints.Last()->EnqueueSubject(Pair.Value);
+		}
+		bHasEndpoints = true;
+		return true;
+	}
+
+	/** The primary endpoint can't be removed, it goes with the plugin */
+	bool RemoveEndpoint(const FString& ProviderName)
+	{
+		FRWScopeLock Lock(EndpointsLock, SLT_Write);
+		const int32 Index = FindEndpoint(ProviderName);
+		if (Index == INDEX_NONE || Endpoints[Index]->IsPrimary())
+		{
+			return false;
+		}
+
+		Endpoints.RemoveAt(Index);
+		bHasEndpoints = Endpoints.Num() > 0;
+		return true;
+	}
+
+	/** Removes every extra endpoint, or with bIncludingPrimary every endpoint as the plugin unloads */
+	void RemoveAllEndpoints(bool bIncludingPrimary = false)
+	{
+		FRWScopeLock Lock(EndpointsLock, SLT_Write);
+		Endpoints.RemoveAll([bIncludingPrimary](const FEndpointPtr& Endpoint) { return bIncludingPrimary || !Endpoint->IsPrimary(); });
+		bHasEndpoints = Endpoints.Num() > 0;
+	}
+
+	bool SetMaxRate(const FString& ProviderName, double MaxRate)
+	{
+		FRWScopeLock Lock(EndpointsLock, SLT_ReadOnly);
+		const int32 Index = FindEndpoint(ProviderName);
+		if (Index != INDEX_NONE)
+		{
+			Endpoints[Index]->SetMaxRate(MaxRate);
+		}
+		return Index != INDEX_NONE;
+	}
+
+	bool SetDropFrames(const FString& ProviderName, bool bDropFrames)
+	{
+		FRWScopeLock Lock(EndpointsLock, SLT_ReadOnly);
+		const int32 Index = FindEndpoint(ProviderName);
+		if (Index != INDEX_NONE)
+		{
+			Endpoints[Index]->SetDropFrames(bDropFrames);
+		}
+		return Index != INDEX_NONE;
+	}
+
+	void PublishSubject(FName SubjectName, const TArray<FName>& BoneNames, const TArray<int32>& BoneParents)
+	{
+		FLiveLinkEncodedSubject* Subject = new FLiveLinkEncodedSubject();
+		Subject->SubjectName = SubjectName;
+		Subject->BoneNames = BoneNames;
+		Subject->BoneParents = BoneParents;
+		const FLiveLinkEncodedSubjectPtr SharedSubject = MakeShareable(Subject);
+
+		FRWScopeLock Lock(EndpointsLock, SLT_Write);
+		LatestSubjects.Add(SubjectName, SharedSubject);
+		for (const FEndpointPtr& Endpoint : Endpoints)
+		{
+			Endpoint->EnqueueSubject(SharedSubject);
+		}
+	}
+
+	/** bAllowDrop false makes endpoints that drop frames deliver this one even when newer ones of the subject follow */
+	void PublishFrame(FName SubjectName, const TArray<FTransform>& Transforms, const TArray<FLiveLinkCurveElement>& Curves, double StreamTime, bool bAllowDrop)
+	{
+		FLiveLinkEncodedFrame* Frame = EncodedFramePool.Acquire();
+		Frame->SubjectName = SubjectName;
+		Frame->Transforms.Reset(Transforms.Num());
+		Frame->Transforms.Append(Transforms);
+		Frame->Curves.Reset(Curves.Num());
+		Frame->Curves.Append(Curves);
+		Frame->StreamTime = StreamTime;
+		const FLiveLinkEncodedFrameRef SharedFrame(Frame);
+
+		// Enqueuing can wait on a lossless endpoint, which must not happen under the lock
+		TArray<FEndpointPtr, TInlineAllocator<8>> PublishEndpoints;
+		{
+			FRWScopeLock Lock(EndpointsLock, SLT_ReadOnly);
+			PublishEndpoints.Append(Endpoints);
+		}
+		for (const FEndpointPtr& Endpoint : PublishEndpoints)
+		{
+			Endpoint->EnqueueFrame(SharedFrame, bAllowDrop);
+		}
+	}
+
+	/** Drops the static data kept for a subject that is no longer streamed */
+	void ForgetSubject(FName SubjectName)
+	{
+		FRWScopeLock Lock(EndpointsLock, SLT_Write);
+		LatestSubjects.Remove(SubjectName);
+	}
+
+	/** Forgets the subject and removes it from every endpoint's provider */
+	void ClearSubject(FName SubjectName)
+	{
+		FRWScopeLock Lock(EndpointsLock, SLT_Write);
+		LatestSubjects.Remove(SubjectName);
+		for (const FEndpointPtr& Endpoint : Endpoints)
+		{
+			Endpoint->EnqueueClear(SubjectName);
+		}
+	}
+
+	/** One line per endpoint: name, connected, max rate, drops frames, queued, sent, dropped, static updates sent, queue depth */
+	void GetEndpointStatus(TArray<FString>& OutLines) const
+	{
+		FRWScopeLock Lock(EndpointsLock, SLT_ReadOnly);
+		for (const FEndpointPtr& Endpoint : Endpoints)
+		{
+			OutLines.Add(FString::Printf(TEXT("%s%s connected: %d rate: %.1f drops: %d queued: %llu sent: %llu dropped: %llu static: %llu pending: %d"),
+				*Endpoint->GetProviderName(), Endpoint->IsPrimary() ? TEXT(" (primary)") : TEXT(""), Endpoint->HasConnection() ? 1 : 0, Endpoint->GetMaxRate(), Endpoint->GetDropFrames() ? 1 : 0,
+				Endpoint->GetFramesQueued(), Endpoint->GetFramesSent(), Endpoint->GetFramesDropped(), Endpoint->GetSubjectsSent(), Endpoint->GetQueueDepth()));
+		}
+	}
+
+	void ResetStats()
+	{
+		FRWScopeLock Lock(EndpointsLock, SLT_ReadOnly);
+		for (const FEndpointPtr& Endpoint : Endpoints)
+		{
+			Endpoint->ResetStats();
+		}
+	}
+
+private:
+	// Shared so a frame being published keeps an endpoint removed meanwhile alive until it is enqueued
+	typedef TSharedPtr<FLiveLinkEndpoint, ESPMode::ThreadSafe> FEndpointPtr;
+
+	int32 FindEndpoint(const FString& ProviderName) const
+	{
+		return Endpoints.IndexOfByPredicate([&ProviderName](const FEndpointPtr& Endpoint)
+		{
+			return Endpoint->GetProviderName() == ProviderName;
+		});
+	}
+
+	// Publishing only reads the endpoint list, so frames from different threads never wait on each other here
+	mutable FRWLock EndpointsLock;
+	TArray<FEndpointPtr> Endpoints;
+	TMap<FName, FLiveLinkEncodedSubjectPtr> LatestSubjects;
+	std::atomic<bool> bHasEndpoints;
+};
+
+FLiveLinkEndpointHub EndpointHub;
+
+namespace LiveLinkSharedMemory
+{
+	/**
+	* Writes everything sent to the provider into the ring while a region is open. Static data is kept while closed so
+	* opening a region or a reader attaching can start with every subject's names.
+	*/
+	class FWriter
+	{
+	public:
+		FWriter()
+			: Region(nullptr)
+			, Header(nullptr)
+			, bOpen(false)
+			, NextSubjectId(0)
+			, LastResyncRequests(0)
+			, FramesWritten(0)
+			, SubjectsWritten(0)
+			, BytesWritten(0)
+			, RecordsOversized(0)
+		{}
+
+		~FWriter()
+		{
+			Close();
+		}
+
+		bool Open(const FString& Name, uint32 SlotCount, uint32 SlotSize)
+		{
+			FScopeLock Lock(&CriticalSection);
+			CloseLocked();
+
+			SlotCount = FMath::Max<uint32>(SlotCount, 2);
+			SlotSize = Align(FMath::Max<uint32>(SlotSize, 1024), 64);
+			const SIZE_T RegionSize = sizeof(FHeader) + (SIZE_T)SlotCount * SlotSize;
+
+			Region = FPlatformMemory::MapNamedSharedMemoryRegion(Name, true, AccessReadWrite, RegionSize);
+			if (Region == nullptr)
+			{
+				return false;
+			}
+
+			// A region left behind by a crashed session is reused, so start from a clean ring
+			FMemory::Memzero(Region->GetAddress(), RegionSize);
+			Header = static_cast<FHeader*>(Region->GetAddress());
+			Header->Version = Version;
+			Header->SlotCount = SlotCount;
+			Header->SlotSize = SlotSize;
+			Header->WriteIndex.store(0, std::memory_order_relaxed);
+			Header->ResyncRequests.store(0, std::memory_order_relaxed);
+			LastResyncRequests = 0;
+			std::atomic_thread_fence(std::memory_order_release);
+			Header->Magic = Magic;
+
+			for (TPair<FName, FSubjectState>& Pair : Subjects)
+			{
+				WriteSubjectLocked(Pair.Value);
+			}
+
+			bOpen = true;
+			return true;
+		}
+
+		void Close()
+		{
+			FScopeLock Lock(&CriticalSection);
+			CloseLocked();
+		}
+
+		bool IsOpen() const { return bOpen.load(); }
+		FString GetName() const
+		{
+			FScopeLock Lock(&CriticalSection);
+			return Region ? Region->GetName() : FString();
+		}
+
+		void PublishSubject(FName SubjectName, const TArray<FName>& BoneNames, const TArray<int32>& BoneParents)
+		{
+			FScopeLock Lock(&CriticalSection);
+			FSubjectState* State = Subjects.Find(SubjectName);
+			if (State == nullptr)
+			{
+				State = &Subjects.Add(SubjectName);
+				State->SubjectName = SubjectName;
+				State->SubjectId = NextSubjectId++;
+			}
+			State->BoneNames = BoneNames;
+			State->BoneParents = BoneParents;
+
+			if (bOpen)
+			{
+				WriteSubjectLocked(*State);
+			}
+		}
+
+		void PublishFrame(FName SubjectName, const TArray<FTransform>& Transforms, const TArray<FLiveLinkCurveElement>& Curves, double StreamTime)
+		{
+			if (!bOpen)
+			{
+				return;
+			}
+
+			FScopeLock Lock(&CriticalSection);
+			FSubjectState* State = Subjects.Find(SubjectName);
+			if (!bOpen || State == nullptr)
+			{
+				return;
+			}
+
+			const uint32 ResyncRequests = Header->ResyncRequests.load(std::memory_order_acquire);
+			if (ResyncRequests != LastResyncRequests)
+			{
+				LastResyncRequests = ResyncRequests;
+				for (TPair<FName, FSubjectState>& Pair : Subjects)
+				{
+					WriteSubjectLocked(Pair.Value);
+				}
+			}
+
+			if (UpdateCurveNames(*State, Curves))
+			{
+				WriteSubjectLocked(*State);
+			}
+
+			const LiveLinkFrameCodec::FSettings EncodingSettings = LiveLinkFrameCodec::Registry.GetSettings(SubjectName);
+			if (EncodingSettings.Encoding == LiveLinkFrameCodec::EEncoding::Compact && LiveLinkFrameCodec::CanEncode(Transforms.Num(), Curves.Num()))
+			{
+				EncodeBuffer.Reset();
+				LiveLinkFrameCodec::Encode(Transforms, Curves, EncodingSettings, State->PositionRange, EncodeBuffer);
+
+				uint8* Payload = BeginRecord(ERecordType::CompactFrame, sizeof(FFrameRecord) + EncodeBuffer.Num());
+				if (Payload == nullptr)
+				{
+					return;
+				}
+
+				FFrameRecord* Record = WriteFrameRecord(Payload, *State, Transforms, Curves, StreamTime);
+				FMemory::Memcpy(Record + 1, EncodeBuffer.GetData(), EncodeBuffer.Num());
+
+				Record->PublishTime = FPlatformTime::Seconds();
+				EndRecord();
+				++FramesWritten;
+				return;
+			}
+
+			const uint32 PayloadSize = sizeof(FFrameRecord) + (Transforms.Num() * FloatsPerTransform + Curves.Num()) * sizeof(float);
+			uint8* Payload = BeginRecord(ERecordType::Frame, PayloadSize);
+			if (Payload == nullptr)
+			{
+				return;
+			}
+
+			FFrameRecord* Record = WriteFrameRecord(Payload, *State, Transforms, Curves, StreamTime);
+			float* Values = reinterpret_cast<float*>(Record + 1);
+			for (const FTransform& Transform : Transforms)
+			{
+				const FQuat Rotation = Transform.GetRotation();
+				const FVector Translation = Transform.GetTranslation();
+				const FVector Scale = Transform.GetScale3D();
+				*Values++ = Rotation.X;
+				*Values++ = Rotation.Y;
+				*Values++ = Rotation.Z;
+				*Values++ = Rotation.W;
+				*Values++ = Translation.X;
+				*Values++ = Translation.Y;
+				*Values++ = Translation.Z;
+				*Values++ = Scale.X;
+				*Values++ = Scale.Y;
+				*Values++ = Scale.Z;
+			}
+			for (const FLiveLinkCurveElement& Curve : Curves)
+			{
+				*Values++ = Curve.CurveValue;
+			}
+
+			Record->PublishTime = FPlatformTime::Seconds();
+			EndRecord();
+			++FramesWritten;
+		}
+
+		uint64 GetFramesWritten() const { return FramesWritten.load(); }
+		uint64 GetSubjectsWritten() const { return SubjectsWritten.load(); }
+		uint64 GetBytesWritten() const { return BytesWritten.load(); }
+		uint64 GetRecordsOversized() const { return RecordsOversized.load(); }
+
+		void ResetStats()
+		{
+			FramesWritten = 0;
+			SubjectsWritten = 0;
+			BytesWritten = 0;
+			RecordsOversized = 0;
+		}
+
+	private:
+		struct FSubjectState
+		{
+			FName SubjectName;
+			uint32 SubjectId;
+			TArray<FName> BoneNames;
+			TArray<int32> BoneParents;
+			TArray<FName> CurveNames;
+			LiveLinkFrameCodec::FPositionRange PositionRange;
+		};
+
+		static FFrameRecord* WriteFrameRecord(uint8* Payload, const FSubjectState& State, const TArray<FTransform>& Transforms, const TArray<FLiveLinkCurveElement>& Curves, double StreamTime)
+		{
+			FFrameRecord* Record = reinterpret_cast<FFrameRecord*>(Payload);
+			Record->SubjectId = State.SubjectId;
+			Record->NumTransforms = Transforms.Num();
+			Record->NumCurves = Curves.Num();
+			Record->Reserved = 0;
+			Record->StreamTime = StreamTime;
+			return Record;
+		}
+
+		void CloseLocked()
+		{
+			bOpen = false;
+			if (Region != nullptr)
+			{
+				FPlatformMemory::UnmapNamedSharedMemoryRegion(Region);
+				Region = nullptr;
+				Header = nullptr;
+			}
+		}
+
+		static bool UpdateCurveNames(FSubjectState& State, const TArray<FLiveLinkCurveElement>& Curves)
+		{
+			bool bChanged = State.CurveNames.Num() != Curves.Num();
+			for (int32 Idx = 0; Idx < Curves.Num() && !bChanged; ++Idx)
+			{
+				bChanged = State.CurveNames[Idx] != Curves[Idx].CurveName;
+			}
+
+			if (bChanged)
+			{
+				State.CurveNames.Reset(Curves.Num());
+				for (const FLiveLinkCurveElement& Curve : Curves)
+				{
+					State.CurveNames.Add(Curve.CurveName);
+				}
+			}
+			return bChanged;
+		}
+
+		void AppendName(FName Name)
+		{
+			FTCHARToUTF8 Converter(*Name.ToString());
+			const uint16 Length = (uint16)FMath::Min(Converter.Length(), (int32)MAX_uint16);
+			NameBuffer.Append(reinterpret_cast<const uint8*>(&Length), sizeof(Length));
+			NameBuffer.Append(reinterpret_cast<const uint8*>(Converter.Get()), Length);
+		}
+
+		void WriteSubjectLocked(const FSubjectState& State)
+		{
+			NameBuffer.Reset();
+			AppendName(State.SubjectName);
+			for (FName BoneName : State.BoneNames)
+			{
+				AppendName(BoneName);
+			}
+			for (FName CurveName : State.CurveNames)
+			{
+				AppendName(CurveName);
+			}
+
+			const uint32 PayloadSize = sizeof(FSubjectRecord) + State.BoneParents.Num() * sizeof(int32) + NameBuffer.Num();
+			uint8* Payload = BeginRecord(ERecordType::Subject, PayloadSize);
+			if (Payload == nullptr)
+			{
+				return;
+			}
+
+			FSubjectRecord* Record = reinterpret_cast<FSubjectRecord*>(Payload);
+			Record->SubjectId = State.SubjectId;
+			Record->NumBones = State.BoneNames.Num();
+			Record->NumCurves = State.CurveNames.Num();
+			Record->NamesSize = NameBuffer.Num();
+
+			uint8* Parents = reinterpret_cast<uint8*>(Record + 1);
+			FMemory::Memcpy(Parents, State.BoneParents.GetData(), State.BoneParents.Num() * sizeof(int32));
+			FMemory::Memcpy(Parents + State.BoneParents.Num() * sizeof(int32), NameBuffer.GetData(), NameBuffer.Num());
+
+			EndRecord();
+			++SubjectsWritten;
+		}
+
+		/** Claims the next slot and marks it as being written, nullptr if the record doesn't fit in a slot */
+		uint8* BeginRecord(ERecordType Type, uint32 PayloadSize)
+		{
+			if (PayloadSize > GetMaxPayloadSize(*Header))
+			{
+				++RecordsOversized;
+				return nullptr;
+			}
+
+			PendingIndex = Header->WriteIndex.load(std::memory_order_relaxed);
+			PendingSlot = GetSlot(Region->GetAddress(), *Header, PendingIndex);
+			PendingSlot->Sequence.store(2 * PendingIndex + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			PendingSlot->Type = Type;
+			PendingSlot->PayloadSize = PayloadSize;
+			BytesWritten += PayloadSize;
+			return reinterpret_cast<uint8*>(PendingSlot + 1);
+		}
+
+		void EndRecord()
+		{
+			PendingSlot->Sequence.store(2 * PendingIndex + 2, std::memory_order_release);
+			Header->WriteIndex.store(PendingIndex + 1, std::memory_order_release);
+		}
+
+		mutable FCriticalSection CriticalSection;
+		FPlatformMemory::FSharedMemoryRegion* Region;
+		FHeader* Header;
+		std::atomic<bool> bOpen;
+
+		TMap<FName, FSubjectState> Subjects;
+		uint32 NextSubjectId;
+		uint32 LastResyncRequests;
+		TArray<uint8> NameBuffer;
+		TArray<uint8> EncodeBuffer;
+
+		FSlotHeader* PendingSlot;
+		uint64 PendingIndex;
+
+		std::atomic<uint64> FramesWritten;
+		std::atomic<uint64> SubjectsWritten;
+		std::atomic<uint64> BytesWritten;
+		std::atomic<uint64> RecordsOversized;
+	};
+
+	FWriter Writer;
+}
+
+/**
+* Every static update and frame goes out through these so they can also be recorded and fanned out. The provider is
+* called from the primary endpoint's thread, never from the caller's.
+* Traffic is the sending subject's stats counters, sends without one aren't counted.
+*/
+void SendSubject(FName SubjectName, const TArray<FName>& BoneNames, const TArray<int32>& BoneParents, LiveLinkStats::FSubjectTraffic* Traffic = nullptr)
+{
+	{
+		// Static updates are rare and copied into a new shared buffer each time
+		LiveLinkAllocations::FExcludeScope ExcludeAllocations;
+		EndpointHub.PublishSubject(SubjectName, BoneNames, BoneParents);
+	}
+	LiveLinkSharedMemory::Writer.PublishSubject(SubjectName, BoneNames, BoneParents);
+	if (Traffic != nullptr)
+	{
+		Traffic->Record(true, BoneNames.Num() * (sizeof(FName) + sizeof(int32)));
+	}
+	TakeRecorder.RecordSubject(SubjectName, BoneNames, BoneParents);
+}
+
+/** bAllowDrop false has endpoints that drop frames receive this one even if a newer one of the subject follows quickly */
+void SendSubjectFrame(FName SubjectName, const TArray<FTransform>& Transforms, const TArray<FLiveLinkCurveElement>& Curves, double StreamTime, LiveLinkStats::FSubjectTraffic* Traffic = nullptr, bool bAllowDrop = true)
+{
+	if (EndpointHub.HasEndpoints())
+	{
+		EndpointHub.PublishFrame(SubjectName, Transforms, Curves, StreamTime, bAllowDrop);
+	}
+	LiveLinkSharedMemory::Writer.PublishFrame(SubjectName, Transforms, Curves, StreamTime);
+	if (Traffic != nullptr)
+	{
+		// Approximate payload, transforms as 10 floats and curves as name plus value
+		Traffic->Record(false, sizeof(double) + Transforms.Num() * LiveLinkTake::FloatsPerTransform * sizeof(float) + Curves.Num() * (sizeof(FName) + sizeof(float)));
+	}
+	TakeRecorder.RecordFrame(SubjectName, Transforms, Curves, StreamTime);
+}
+
+/** Raw subject data captured on Maya's main thread, enough to build the subject's frame without touching the DAG */
+struct FLiveLinkSubjectCapture
+{
+	enum class ESource : uint8
+	{
+		JointChannels,
+		Transform,
+		TransformHierarchy,
+		Camera,
+	};
+
+	ESource Source;
+	FName SubjectName;
+	TSharedPtr<FLiveLinkSubjectFrameFilter, ESPMode::ThreadSafe> FrameFilter;
+
+	// Joint subjects, one set of channels per streamed joint
+	TArray<LiveLinkJointMath::FJointChannels> JointChannels;
+	bool bCorrectForYUp;
+
+	// Streamed joints below joints the active LOD level drops, with their local matrix relative to the streamed parent
+	TArray<int32> FoldedJointIndices;
+	TArray<MMatrix> FoldedJointMatrices;
+
+	// Prop and camera subjects
+	MMatrix Transform;
+
+	// Prop hierarchy subjects, local transform of every part
+	TArray<MMatrix> Transforms;
+
+	TSharedPtr<const TArray<FName>, ESPMode::ThreadSafe> CurveNames;
+	TArray<float> CurveValues;
+};
+
+/** The frame built from one capture plus the scratch buffers used to build it */
+struct FLiveLinkFrameBuildContext
+{
+	TArray<FTransform> Transforms;
+	TArray<FLiveLinkCurveElement> Curves;
+};
+
+/**
+* Every capture taken in one stream pass and the frames built from them. Slots are kept between passes so their
+* buffers get reused.
+*/
+struct FLiveLinkStreamSnapshot
+{
+	FLiveLinkStreamSnapshot()
+		: NumCaptures(0)
+		, StreamTime(0.0)
+		, FrameNumber(0)
+		, bForceKeyframe(false)
+		, bAllowDrop(true)
+	{}
+
+	void Reset(double InStreamTime, int32 InFrameNumber)
+	{
+		NumCaptures = 0;
+		StreamTime = InStreamTime;
+		FrameNumber = InFrameNumber;
+		bForceKeyframe = false;
+		bAllowDrop = true;
+		ParallelSettings = ParallelEvaluationSettings;
+	}
+
+	FLiveLinkSubjectCapture& AddCapture()
+	{
+		if (NumCaptures == Captures.Num())
+		{
+			Captures.AddDefaulted();
+			Frames.AddDefaulted();
+		}
+		return Captures[NumCaptures++];
+	}
+
+	void RemoveLastCapture()
+	{
+		--NumCaptures;
+	}
+
+	TArray<FLiveLinkSubjectCapture> Captures;
+	TArray<FLiveLinkFrameBuildContext> Frames;
+	int32 NumCaptures;
+	double StreamTime;
+	int32 FrameNumber;
+
+	// Every subject's frame goes out as a keyframe, even in delta mode
+	bool bForceKeyframe;
+
+	// Whether endpoints that drop frames may skip these when newer ones catch up with them
+	bool bAllowDrop;
+
+	// Copied when capturing starts so the publishing thread never reads the live settings
+	FLiveLinkParallelEvaluationSettings ParallelSettings;
+};
+
+/**
+* Joints the fused kernel can't represent are gathered and decomposed together. The gathered joints only live for the
+* range, so they go on the calling thread's mem stack, whose pages are reused from pass to pass instead of each range
+* holding on to its own heap buffers.
+*/
+void BuildJointTransformRange(const TArray<LiveLinkJointMath::FJointChannels>& JointChannels, int32 Begin, int32 End, TArray<FTransform>& Transforms)
+{
+	FMemMark Mark(FMemStack::Get());
+	TArray<int32, TMemStackAllocator<>> MatrixPathJoints;
+	TArray<MMatrix, TMemStackAllocator<>> MatrixPathTransforms;
+
+	for (int32 Idx = Begin; Idx < End; ++Idx)
+	{
+		if (!LiveLinkJointMath::BuildUETransform(JointChannels[Idx], Transforms[Idx]))
+		{
+			MatrixPathJoints.Add(Idx);
+			MatrixPathTransforms.Add(BuildMayaJointMatrix(JointChannels[Idx]));
+		}
+	}
+
+	if (MatrixPathJoints.Num() > 0)
+	{
+		TArray<FTransform, TMemStackAllocator<>> MatrixPathResults;
+		MatrixPathResults.SetNumUninitialized(MatrixPathJoints.Num());
+		BuildUETransformsFromMayaTransforms(MatrixPathTransforms.GetData(), MatrixPathResults.GetData(), MatrixPathJoints.Num());
+
+		for (int32 Idx = 0; Idx < MatrixPathJoints.Num(); ++Idx)
+		{
+			Transforms[MatrixPathJoints[Idx]] = MatrixPathResults[Idx];
+		}
+	}
+}
+
+/**
+* Every joint is converted independently of its neighbours, and each lane of the batched decomposition only depends
+* on its own matrix, so splitting the range gives the exact same transforms as the serial path. Ranges start on batch
+* boundaries so only the last one has a partial batch, the benchmark's accuracy report checks both paths match.
+*/
+void BuildJointTransforms(const TArray<LiveLinkJointMath::FJointChannels>& JointChannels, const FLiveLinkParallelEvaluationSettings& Settings, FLiveLinkFrameBuildContext& Context)
+{
+	const int32 NumJoints = JointChannels.Num();
+	Context.Transforms.SetNum(NumJoints, false);
+
+	int32 NumRanges = 1;
+	if (Settings.JointSplitThreshold > 0 && NumJoints >= Settings.JointSplitThreshold)
+	{
+		const int32 JointsPerTask = FMath::Max(Settings.JointsPerTask, 1);
+		NumRanges = FMath::Min(FMath::DivideAndRoundUp(NumJoints, JointsPerTask), Settings.GetNumThreads());
+	}
+
+	if (NumRanges <= 1)
+	{
+		BuildJointTransformRange(JointChannels, 0, NumJoints, Context.Transforms);
+		return;
+	}
+
+	const int32 JointsPerRange = Align(FMath::DivideAndRoundUp(NumJoints, NumRanges), LiveLinkBatchedDecomposition::BatchSize);
+	NumRanges = FMath::DivideAndRoundUp(NumJoints, JointsPerRange);
+	LiveLinkAllocations::FExcludeScope ExcludeAllocations;
+	ParallelFor(NumRanges, [&](int32 RangeIndex)
+	{
+		LiveLinkAllocations::FStreamPathScope StreamPath;
+		const int32 Begin = RangeIndex * JointsPerRange;
+		const int32 End = FMath::Min(Begin + JointsPerRange, NumJoints);
+		BuildJointTransformRange(JointChannels, Begin, End, Context.Transforms);
+	});
+}
+
+/**
+* Replaces the transforms of joints below dropped joints with their composed matrices, decomposed once each. The
+* dropped chain is composed as Maya matrices so shear from non-uniform scale above a rotation isn't lost, which
+* multiplying decomposed FTransforms would do at every dropped joint.
+*/
+void BuildFoldedJointTransforms(const FLiveLinkSubjectCapture& Capture, FLiveLinkFrameBuildContext& Context)
+{
+	const int32 NumFolded = Capture.FoldedJointIndices.Num();
+	if (NumFolded == 0)
+	{
+		return;
+	}
+
+	FMemMark Mark(FMemStack::Get());
+	TArray<FTransform, TMemStackAllocator<>> FoldedTransforms;
+	FoldedTransforms.SetNumUninitialized(NumFolded);
+	BuildUETransformsFromMayaTransforms(Capture.FoldedJointMatrices.GetData(), FoldedTransforms.GetData(), NumFolded);
+
+	for (int32 Idx = 0; Idx < NumFolded; ++Idx)
+	{
+		Context.Transforms[Capture.FoldedJointIndices[Idx]] = FoldedTransforms[Idx];
+	}
+}
+
+/**
+* Cameras and props carry one matrix each, too few to fill a decomposition batch on their own, so every single
+* transform subject of a snapshot is decomposed in one batch before the per-subject builds. Leaves each of those
+* subjects' frame holding its one transform.
+*/
+void DecomposeSingleTransformCaptures(FLiveLinkStreamSnapshot& Snapshot)
+{
+	FMemMark Mark(FMemStack::Get());
+	TArray<MMatrix, TMemStackAllocator<>> Matrices;
+	TArray<int32, TMemStackAllocator<>> CaptureIndices;
+	for (int32 Idx = 0; Idx < Snapshot.NumCaptures; ++Idx)
+	{
+		const FLiveLinkSubjectCapture& Capture = Snapshot.Captures[Idx];
+		if (Capture.Source == FLiveLinkSubjectCapture::ESource::Transform || Capture.Source == FLiveLinkSubjectCapture::ESource::Camera)
+		{
+			Matrices.Add(Capture.Transform);
+			CaptureIndices.Add(Idx);
+		}
+	}
+
+	if (Matrices.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<FTransform, TMemStackAllocator<>> Transforms;
+	Transforms.SetNumUninitialized(Matrices.Num());
+	BuildUETransformsFromMayaTransforms(Matrices.GetData(), Transforms.GetData(), Matrices.Num());
+
+	for (int32 Idx = 0; Idx < CaptureIndices.Num(); ++Idx)
+	{
+		TArray<FTransform>& FrameTransforms = Snapshot.Frames[CaptureIndices[Idx]].Transforms;
+		FrameTransforms.Reset();
+		FrameTransforms.Add(Transforms[Idx]);
+	}
+}
+
+/**
+* Converts a capture into UE-space transforms, safe to call off the main thread. Single transform subjects expect
+* DecomposeSingleTransformCaptures to have run on their snapshot.
+*/
+void BuildSubjectTransforms(const FLiveLinkSubjectCapture& Capture, const FLiveLinkParallelEvaluationSettings& Settings, FLiveLinkFrameBuildContext& Context)
+{
+	switch (Capture.Source)
+	{
+	case FLiveLinkSubjectCapture::ESource::JointChannels:
+		Context.Transforms.Reset();
+		BuildJointTransforms(Capture.JointChannels, Settings, Context);
+		BuildFoldedJointTransforms(Capture, Context);
+		ApplyCoordinateSystemCorrection(Context.Transforms, Capture.bCorrectForYUp);
+		break;
+
+	case FLiveLinkSubjectCapture::ESource::Transform:
+		check(Context.Transforms.Num() == 1);
+		break;
+
+	case FLiveLinkSubjectCapture::ESource::TransformHierarchy:
+		Context.Transforms.SetNumUninitialized(Capture.Transforms.Num(), false);
+		BuildUETransformsFromMayaTransforms(Capture.Transforms.GetData(), Context.Transforms.GetData(), Capture.Transforms.Num());
+		break;
+
+	case FLiveLinkSubjectCapture::ESource::Camera:
+		check(Context.Transforms.Num() == 1);
+		// Convert Maya Camera orientation to Unreal
+		Context.Transforms[0].SetRotation(Context.Transforms[0].GetRotation() * FRotator(0.f, -90.f, 0.f).Quaternion());
+		break;
+	}
+}
+
+void BuildSubjectCurves(const FLiveLinkSubjectCapture& Capture, FLiveLinkFrameBuildContext& Context)
+{
+	Context.Curves.Reset();
+
+	if (Capture.CurveNames.IsValid())
+	{
+		const TArray<FName>& CurveNames = *Capture.CurveNames;
+		Context.Curves.SetNum(CurveNames.Num(), false);
+		for (int32 Idx = 0; Idx < CurveNames.Num(); ++Idx)
+		{
+			Context.Curves[Idx].CurveName = CurveNames[Idx];
+			Context.Curves[Idx].CurveValue = Capture.CurveValues[Idx];
+		}
+	}
+}
+
+void BuildSubjectFrame(const FLiveLinkSubjectCapture& Capture, const FLiveLinkParallelEvaluationSettings& Settings, FLiveLinkFrameBuildContext& Context)
+{
+	BuildSubjectTransforms(Capture, Settings, Context);
+	BuildSubjectCurves(Capture, Context);
+}
+
+/**
+* Calls Function for every capture of the snapshot, split over subjects across up to MaxThreads threads. Subjects are
+* handed out in contiguous ranges and each one writes only its own frame, so the result doesn't depend on the thread count.
+*/
+template<typename FunctionType>
+void ParallelForEachCapture(const FLiveLinkStreamSnapshot& Snapshot, const FunctionType& Function)
+{
+	const int32 NumRanges = FMath::Min(Snapshot.ParallelSettings.GetNumThreads(), Snapshot.NumCaptures);
+
+	if (NumRanges <= 1)
+	{
+		for (int32 Idx = 0; Idx < Snapshot.NumCaptures; ++Idx)
+		{
+			Function(Idx);
+		}
+		return;
+	}
+
+	const int32 CapturesPerRange = FMath::DivideAndRoundUp(Snapshot.NumCaptures, NumRanges);
+	LiveLinkAllocations::FExcludeScope ExcludeAllocations;
+	ParallelFor(NumRanges, [&](int32 RangeIndex)
+	{
+		LiveLinkAllocations::FStreamPathScope StreamPath;
+		const int32 Begin = RangeIndex * CapturesPerRange;
+		const int32 End = FMath::Min(Begin + CapturesPerRange, Snapshot.NumCaptures);
+		for (int32 Idx = Begin; Idx < End; ++Idx)
+		{
+			Function(Idx);
+		}
+	});
+}
+
+void BuildSnapshotFrames(FLiveLinkStreamSnapshot& Snapshot)
+{
+	DecomposeSingleTransformCaptures(Snapshot);
+	ParallelForEachCapture(Snapshot, [&Snapshot](int32 Idx)
+	{
+		BuildSubjectFrame(Snapshot.Captures[Idx], Snapshot.ParallelSettings, Snapshot.Frames[Idx]);
+	});
+}
+
+/** Frame filters and provider calls stay on the publishing thread and run in subject order */
+void PublishSnapshot(FLiveLinkStreamSnapshot& Snapshot)
+{
+	{
+		LiveLinkStats::FScope Scope(LiveLinkStats::EStat::BuildFrames);
+		BuildSnapshotFrames(Snapshot);
+	}
+
+	for (int32 Idx = 0; Idx < Snapshot.NumCaptures; ++Idx)
+	{
+		const FLiveLinkSubjectCapture& Capture = Snapshot.Captures[Idx];
+		const FLiveLinkFrameBuildContext& Frame = Snapshot.Frames[Idx];
+
+		if (Capture.FrameFilter->ShouldSend(Frame.Transforms, Frame.Curves, Snapshot.StreamTime, Snapshot.bForceKeyframe))
+		{
+			SendSubjectFrame(Capture.SubjectName, Frame.Transforms, Frame.Curves, Snapshot.StreamTime, &Capture.FrameFilter->GetTraffic(), Snapshot.bAllowDrop);
+		}
+	}
+}
+
+/**
+* Turns stream snapshots into published frames.
+*
+* In synchronous mode snapshots are published straight away on Maya's main thread. In asynchronous mode the main thread
+* only captures, and a worker thread builds and publishes the frames. Snapshots are handed over through a lock-free
+* single producer / single consumer ring of bounded depth: only the main thread moves the head and only the worker moves
+* the tail. Published buffers go back through a second ring the other way round.
+*
+* When the worker falls behind, the main thread never blocks and never takes from the queue itself. It holds the new
+* snapshot back as pending (replacing, and so dropping, an older pending one) and raises SkipTo to the newest queued
+* index. The worker honours SkipTo on its next pop by returning every older queued snapshot to the free ring unpublished.
+* Depth + 3 snapshot buffers are preallocated: one being captured, one pending, Depth queued and one being published.
+*/
+class FLiveLinkStreamPipeline : public FRunnable
+{
+public:
+	FLiveLinkStreamPipeline()
+		: Thread(nullptr)
+		, WorkEvent(nullptr)
+		, ProgressEvent(nullptr)
+		, Depth(0)
+		, WriteSlot(0)
+		, PendingSlot(INDEX_NONE)
+		, QueueHead(0)
+		, QueueTail(0)
+		, SkipTo(0)
+		, FreeHead(0)
+		, FreeTail(0)
+		, bStopRequested(false)
+		, bWorkerBusy(false)
+	{
+		Configure(1);
+		ResetStats();
+	}
+
+	virtual ~FLiveLinkStreamPipeline()
+	{
+		Stop();
+	}
+
+	bool IsAsync() const { return Thread != nullptr; }
+	int32 GetDepth() const { return Depth; }
+
+	void SetAsync(bool bAsync, int32 InDepth)
+	{
+		Stop();
+		Configure(FMath::Max(InDepth, 1));
+
+		if (bAsync)
+		{
+			bStopRequested = false;
+			WorkEvent = FPlatformProcess::GetSynchEventFromPool(false);
+			ProgressEvent = FPlatformProcess::GetSynchEventFromPool(false);
+			Thread = FRunnableThread::Create(this, TEXT("LiveLinkStreamPipeline"));
+		}
+	}
+
+	/** Returns the snapshot to capture into, owned by the main thread until SubmitSnapshot */
+	FLiveLinkStreamSnapshot& BeginSnapshot(double StreamTime, int32 FrameNumber)
+	{
+		FLiveLinkStreamSnapshot& Snapshot = Snapshots[WriteSlot];
+		Snapshot.Reset(StreamTime, FrameNumber);
+		return Snapshot;
+	}
+
+	/** With bAllowDrop false a full queue waits for the worker instead of dropping, used when every frame matters */
+	void SubmitSnapshot(bool bAllowDrop = true)
+	{
+		++SnapshotsSubmitted;
+
+		if (!IsAsync())
+		{
+			PublishSnapshot(Snapshots[WriteSlot]);
+			++SnapshotsPublished;
+			return;
+		}
+
+		// A snapshot held back while the queue was full is older than this one and goes first
+		if (PendingSlot != INDEX_NONE)
+		{
+			if (!bAllowDrop)
+			{
+				WaitForRoom();
+			}
+			if (HasRoom())
+			{
+				PushQueued(PendingSlot);
+				PendingSlot = INDEX_NONE;
+			}
+		}
+
+		if (!bAllowDrop)
+		{
+			WaitForRoom();
+		}
+
+		if (HasRoom())
+		{
+			PushQueued(WriteSlot);
+			WriteSlot = PopFree();
+		}
+		else
+		{
+			// Full, hold this snapshot back rather than block Maya and let the worker skip to the newest queued one
+			int32 NextWriteSlot = PendingSlot;
+			if (NextWriteSlot != INDEX_NONE)
+			{
+				++SnapshotsDropped;
+			}
+			else
+			{
+				NextWriteSlot = PopFree();
+			}
+			PendingSlot = WriteSlot;
+			WriteSlot = NextWriteSlot;
+			SkipTo.store(QueueHead.load() - 1);
+		}
+	}
+
+	/** Blocks until every queued snapshot is published, needed before static data is sent */
+	void Flush()
+	{
+		if (!IsAsync())
+		{
+			return;
+		}
+
+		if (PendingSlot != INDEX_NONE)
+		{
+			WaitForRoom();
+			PushQueued(PendingSlot);
+			PendingSlot = INDEX_NONE;
+		}
+
+		while (QueueTail.load() != QueueHead.load() || bWorkerBusy.load())
+		{
+			ProgressEvent->Wait(WaitIntervalMs);
+		}
+	}
+
+	int64 GetQueueDepth() const { return QueueHead.load() - QueueTail.load(); }
+	uint64 GetSnapshotsSubmitted() const { return SnapshotsSubmitted.load(); }
+	uint64 GetSnapshotsPublished() const { return SnapshotsPublished.load(); }
+	uint64 GetSnapshotsDropped() const { return SnapshotsDropped.load(); }
+	int64 GetMaxQueueDepth() const { return MaxQueueDepth.load(); }
+
+	void ResetStats()
+	{
+		SnapshotsSubmitted = 0;
+		SnapshotsPublished = 0;
+		SnapshotsDropped = 0;
+		MaxQueueDepth = 0;
+	}
+
+	//~ Begin FRunnable interface
+	virtual uint32 Run() override
+	{
+		while (!bStopRequested.load())
+		{
+			bWorkerBusy.store(true);
+
+			const int32 Slot = PopQueued();
+			if (Slot != INDEX_NONE)
+			{
+				// The queue has room again, a main thread waiting on it can carry on capturing
+				ProgressEvent->Trigger();
+
+				LiveLinkAllocations::FStreamPathScope StreamPath;
+				PublishSnapshot(Snapshots[Slot]);
+				++SnapshotsPublished;
+				PushFree(Slot);
+			}
+
+			bWorkerBusy.store(false);
+			ProgressEvent->Trigger();
+
+			if (Slot == INDEX_NONE)
+			{
+				WorkEvent->Wait(WaitIntervalMs);
+			}
+		}
+		return 0;
+	}
+	//~ End FRunnable interface
+
+private:
+	// Both events are also polled at this interval, so a trigger racing a wait only costs that much
+	static const uint32 WaitIntervalMs = 10;
+
+	void Stop()
+	{
+		if (Thread)
+		{
+			Flush();
+
+			bStopRequested = true;
+			WorkEvent->Trigger();
+			Thread->WaitForCompletion();
+
+			delete Thread;
+			Thread = nullptr;
+
+			FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+			WorkEvent = nullptr;
+			FPlatformProcess::ReturnSynchEventToPool(ProgressEvent);
+			ProgressEvent = nullptr;
+		}
+	}
+
+	void Configure(int32 InDepth)
+	{
+		Depth = InDepth;
+		Snapshots.SetNum(Depth + 3);
+		QueueSlots.Empty(Depth);
+		QueueSlots.SetNum(Depth);
+		FreeSlots.Empty(Depth + 3);
+		FreeSlots.SetNum(Depth + 3);
+
+		// Slot 0 is the first write slot, every other buffer starts out free
+		WriteSlot = 0;
+		PendingSlot = INDEX_NONE;
+		QueueHead.store(0);
+		QueueTail.store(0);
+		SkipTo.store(0);
+		FreeTail.store(0);
+		for (int32 Slot = 1; Slot < Snapshots.Num(); ++Slot)
+		{
+			FreeSlots[Slot - 1].store(Slot);
+		}
+		FreeHead.store(Snapshots.Num() - 1);
+	}
+
+	/** Main thread only, the tail only ever moves forward so room seen here stays room until the next push */
+	bool HasRoom() const
+	{
+		return QueueHead.load() - QueueTail.load() < Depth;
+	}
+
+	void WaitForRoom()
+	{
+		while (!HasRoom())
+		{
+			ProgressEvent->Wait(WaitIntervalMs);
+		}
+	}
+
+	/** Main thread only, the slot is written before the head is published so the worker never sees a stale index */
+	void PushQueued(int32 Slot)
+	{
+		const int64 Head = QueueHead.load();
+		QueueSlots[Head % Depth].store(Slot);
+		QueueHead.store(Head + 1);
+		MaxQueueDepth.store(FMath::Max<int64>(MaxQueueDepth.load(), Head + 1 - QueueTail.load()));
+		WorkEvent->Trigger();
+	}
+
+	/**
+	* Worker only. Queued snapshots older than SkipTo go back to the free ring unpublished, before the tail moves past
+	* them: until then the main thread counts them as queued and won't write their queue entries.
+	*/
+	int32 PopQueued()
+	{
+		int64 Tail = QueueTail.load();
+		const int64 Head = QueueHead.load();
+		if (Tail == Head)
+		{
+			return INDEX_NONE;
+		}
+
+		const int64 Skip = FMath::Min(SkipTo.load(), Head - 1);
+		for (; Tail < Skip; ++Tail)
+		{
+			PushFree(QueueSlots[Tail % Depth].load());
+			++SnapshotsDropped;
+		}
+
+		const int32 Slot = QueueSlots[Tail % Depth].load();
+		QueueTail.store(Tail + 1);
+		return Slot;
+	}
+
+	/** Worker only */
+	void PushFree(int32 Slot)
+	{
+		const int64 FreeIndex = FreeHead.load();
+		FreeSlots[FreeIndex % FreeSlots.Num()].store(Slot);
+		FreeHead.store(FreeIndex + 1);
+	}
+
+	/** Main thread only, Depth + 3 buffers guarantee a free one whenever a slot is pushed or becomes pending */
+	int32 PopFree()
+	{
+		const int64 FreeIndex = FreeTail.load();
+		check(FreeIndex < FreeHead.load());
+		const int32 Slot = FreeSlots[FreeIndex % FreeSlots.Num()].load();
+		FreeTail.store(FreeIndex + 1);
+		return Slot;
+	}
+
+	FRunnableThread* Thread;
+	FEvent* WorkEvent;
+	// Triggered by the worker whenever the queue gets room or it goes idle, for SubmitSnapshot and Flush to wait on
+	FEvent* ProgressEvent;
+
+	int32 Depth;
+	TArray<FLiveLinkStreamSnapshot> Snapshots;
+	int32 WriteSlot;
+	// Captured while the queue was full, main thread only
+	int32 PendingSlot;
+
+	// Main thread to worker, indices of captured snapshots
+	TArray<std::atomic<int32>> QueueSlots;
+	std::atomic<int64> QueueHead;
+	std::atomic<int64> QueueTail;
+	// Written by the main thread, queue index the worker skips forward to
+	std::atomic<int64> SkipTo;
+
+	// Worker to main thread, indices of published or skipped snapshots
+	TArray<std::atomic<int32>> FreeSlots;
+	std::atomic<int64> FreeHead;
+	std::atomic<int64> FreeTail;
+
+	std::atomic<bool> bStopRequested;
+	std::atomic<bool> bWorkerBusy;
+
+	std::atomic<uint64> SnapshotsSubmitted;
+	std::atomic<uint64> SnapshotsPublished;
+	// Pending snapshots replaced on the main thread and queued ones skipped by the worker
+	std::atomic<uint64> SnapshotsDropped;
+	std::atomic<int64> MaxQueueDepth;
+};
+
+FLiveLinkStreamPipeline StreamPipeline;
+
+/**
+* What a subject last sent as static data. Unreal reinitializes the skeleton on every static update, so rebuilds
+* that leave the hierarchy and curve names as they were don't resend. Bumping StaticDataResyncGeneration forces
+* every subject to send again on its next rebuild.
+*/
+struct FLiveLinkStaticDataState
+{
+	uint64 Hash = 0;
+	uint64 ResyncGeneration = 0;
+
+	// Copy of what was sent, for sinks that start after the send such as a take being recorded
+	TArray<FName> BoneNames;
+	TArray<int32> BoneParents;
+
+	bool HasSent() const { return ResyncGeneration != 0; }
+};
+
+uint64 StaticDataResyncGeneration = 1;
+uint64 StaticUpdatesSent = 0;
+uint64 StaticUpdatesSuppressed = 0;
+
+/** FNV-1a over the hierarchy and curve name set, names hash by their name table entry so this is per process */
+uint64 HashStaticData(const TArray<FName>& BoneNames, const TArray<int32>& BoneParents, const TArray<FName>* CurveNames)
+{
+	uint64 Hash = 14695981039346656037ull;
+	auto HashValue = [&Hash](uint32 Value)
+	{
+		for (int32 Byte = 0; Byte < 4; ++Byte)
+		{
+			Hash = (Hash ^ ((Value >> (Byte * 8)) & 0xff)) * 1099511628211ull;
+		}
+	};
+
+	HashValue(BoneNames.Num());
+	for (int32 Idx = 0; Idx < BoneNames.Num(); ++Idx)
+	{
+		HashValue(GetTypeHash(BoneNames[Idx]));
+		HashValue((uint32)BoneParents[Idx]);
+	}
+
+	const int32 NumCurves = CurveNames ? CurveNames->Num() : 0;
+	HashValue(NumCurves);
+	for (int32 Idx = 0; Idx < NumCurves; ++Idx)
+	{
+		HashValue(GetTypeHash((*CurveNames)[Idx]));
+	}
+	return Hash;
+}
+
+/** Static data goes straight to the provider, so frames captured against the old hierarchy are flushed first */
+void StreamSubjectStaticData(FName SubjectName, FLiveLinkSubjectFrameFilter& FrameFilter, FLiveLinkStaticDataState& State, const TArray<FName>& BoneNames, const TArray<int32>& BoneParents, const TArray<FName>* CurveNames = nullptr)
+{
+	const uint64 Hash = HashStaticData(BoneNames, BoneParents, CurveNames);
+	if (State.ResyncGeneration == StaticDataResyncGeneration && State.Hash == Hash)
+	{
+		++StaticUpdatesSuppressed;
+		return;
+	}
+
+	StreamPipeline.Flush();
+	SendSubject(SubjectName, BoneNames, BoneParents, &FrameFilter.GetTraffic());
+	FrameFilter.Reset();
+
+	State.Hash = Hash;
+	State.ResyncGeneration = StaticDataResyncGeneration;
+	State.BoneNames = BoneNames;
+	State.BoneParents = BoneParents;
+	++StaticUpdatesSent;
+}
+
+// Scene shape and run length for the synthetic streaming benchmark.
+struct FLiveLinkBenchmarkSettings
+{
+	int32 NumCharacters = 10;
+	int32 JointsPerCharacter = 200;
+	int32 FanOut = 3;
+	int32 MaxDepth = 32;
+	int32 NumCameras = 2;
+	int32 NumProps = 10;
+	int32 NumCurves = 16;
+	int32 NumFrames = 200;
+	int32 NumWarmupFrames = 10;
+	int32 Seed = 0;
+
+	// Send the synthetic subjects to the provider instead of a stand-in receiver
+	bool bPublish = false;
+
+	// Also send every frame through a private shared memory ring read by another thread, see LiveLinkSharedMemory
+	bool bTransport = false;
+
+	// Error bounds for the compact encoding comparison
+	float MaxPositionError = 0.01f;
+	float MaxRotationError = 0.01f;
+	float MaxCurveError = 0.001f;
+};
+
+/** Full and compact frame sizes and the compact round trip error for one kind of subject */
+struct FLiveLinkEncodingStats
+{
+	int64 NumFrames = 0;
+	int64 FullBytes = 0;
+	int64 CompactBytes = 0;
+	double MaxTranslationError = 0.0;
+	double MaxRotationError = 0.0;
+	double MaxScaleError = 0.0;
+	double MaxCurveError = 0.0;
+
+	// Per subject like the take recorder's, so the sizes match what a recording of the run would take
+	TMap<FName, LiveLinkFrameCodec::FPositionRange> PositionRanges;
+
+	void Accumulate(FName SubjectName, const FLiveLinkFrameBuildContext& Frame, const LiveLinkFrameCodec::FSettings& Settings, TArray<uint8>& Buffer, TArray<FTransform>& DecodedTransforms, TArray<FLiveLinkCurveElement>& DecodedCurves)
+	{
+		// Matches the take Frame record payload
+		const int64 FrameFullBytes = sizeof(uint32) * 3 + sizeof(double) + Frame.Transforms.Num() * LiveLinkTake::FloatsPerTransform * sizeof(float) + Frame.Curves.Num() * (sizeof(uint32) + sizeof(float));
+		FullBytes += FrameFullBytes;
+		++NumFrames;
+
+		Buffer.Reset();
+		if (!LiveLinkFrameCodec::Encode(Frame.Transforms, Frame.Curves, Settings, PositionRanges.FindOrAdd(SubjectName), Buffer))
+		{
+			// Too large for the compact header, the take and the shared memory writer send these with the Full encoding
+			CompactBytes += FrameFullBytes;
+			return;
+		}
+		CompactBytes += sizeof(uint32) * 3 + sizeof(double) + Frame.Curves.Num() * sizeof(uint32) + Buffer.Num();
+
+		if (!LiveLinkFrameCodec::Decode(Buffer.GetData(), Buffer.Num(), DecodedTransforms, DecodedCurves))
+		{
+			MaxTranslationError = MaxRotationError = MaxScaleError = MaxCurveError = TNumericLimits<float>::Max();
+			return;
+		}
+
+		for (int32 Idx = 0; Idx < DecodedTransforms.Num(); ++Idx)
+		{
+			const FTransform& Reference = Frame.Transforms[Idx];
+			const FTransform& Decoded = DecodedTransforms[Idx];
+			MaxTranslationError = FMath::Max<double>(MaxTranslationError, FVector::Dist(Decoded.GetTranslation(), Reference.GetTranslation()));
+			MaxRotationError = FMath::Max<double>(MaxRotationError, FMath::RadiansToDegrees(Decoded.GetRotation().AngularDistance(Reference.GetRotation().GetNormalized())));
+			MaxScaleError = FMath::Max<double>(MaxScaleError, (Decoded.GetScale3D() - Reference.GetScale3D()).GetAbsMax());
+		}
+		for (int32 Idx = 0; Idx < DecodedCurves.Num(); ++Idx)
+		{
+			MaxCurveError = FMath::Max<double>(MaxCurveError, FMath::Abs(DecodedCurves[Idx].CurveValue - Frame.Curves[Idx].CurveValue));
+		}
+	}
+
+	FString ToJson() const
+	{
+		const double Frames = FMath::Max<double>(NumFrames, 1);
+		return FString::Printf(TEXT("{\"frames\": %lld, \"full_bytes_per_frame\": %.1f, \"compact_bytes_per_frame\": %.1f, \"ratio\": %.3f, \"max_translation_error\": %g, \"max_rotation_error_deg\": %g, \"max_scale_error\": %g, \"max_curve_error\": %g}"),
+			NumFrames, FullBytes / Frames, CompactBytes / Frames, FullBytes > 0 ? (double)CompactBytes / FullBytes : 0.0, MaxTranslationError, MaxRotationError, MaxScaleError, MaxCurveError);
+	}
+};
+
+/**
+* Parametric stand-in for a Maya scene. It produces the same captures the streamed subjects take, animated with
+* random sine curves, so everything after capture can be measured without a DAG. Skeletons are laid out breadth
+* first with the given fan-out and restart at the root once MaxDepth is reached. A few joints get a non-uniform
+* scale so their children take the matrix path.
+*/
+class FLiveLinkSyntheticScene
+{
+public:
+	void Generate(const FLiveLinkBenchmarkSettings& Settings)
+	{
+		using namespace LiveLinkJointMath;
+
+		FRandomStream Random(Settings.Seed);
+		Characters.Reset();
+		Transforms.Reset();
+
+		TArray<FName> CurveNames;
+		for (int32 CurveIdx = 0; CurveIdx < Settings.NumCurves; ++CurveIdx)
+		{
+			CurveNames.Add(FName(TEXT("attr"), CurveIdx + 1));
+		}
+		TSharedPtr<const TArray<FName>, ESPMode::ThreadSafe> SharedCurveNames = MakeShareable(new TArray<FName>(MoveTemp(CurveNames)));
+
+		const int32 NumJoints = FMath::Max(Settings.JointsPerCharacter, 1);
+		const int32 FanOut = FMath::Max(Settings.FanOut, 1);
+
+		for (int32 CharacterIdx = 0; CharacterIdx < Settings.NumCharacters; ++CharacterIdx)
+		{
+			Characters.AddDefaulted();
+			FSyntheticCharacter& Character = Characters.Last();
+			Character.SubjectName = FName(TEXT("LiveLinkBenchmark_Character"), CharacterIdx + 1);
+			Character.FrameFilter = MakeShareable(new FLiveLinkSubjectFrameFilter(Character.SubjectName));
+			Character.CurveNames = SharedCurveNames;
+
+			TArray<int32> JointDepths;
+			for (int32 JointIdx = 0; JointIdx < NumJoints; ++JointIdx)
+			{
+				int32 ParentIdx = (JointIdx == 0) ? -1 : (JointIdx - 1) / FanOut;
+				if (ParentIdx != -1 && JointDepths[ParentIdx] >= Settings.MaxDepth)
+				{
+					ParentIdx = 0;
+				}
+				JointDepths.Add(ParentIdx == -1 ? 0 : JointDepths[ParentIdx] + 1);
+
+				Character.BoneNames.Add(FName(TEXT("joint"), JointIdx + 1));
+				Character.BoneParents.Add(ParentIdx);
+				Character.Phases.Add(Random.FRandRange(0.f, 2.f * PI));
+
+				FJointChannels Channels;
+				for (int32 Axis = 0; Axis < 3; ++Axis)
+				{
+					Channels.Translation[Axis] = Random.FRandRange(-10.f, 10.f);
+					Channels.Rotation[Axis] = Random.FRandRange(-PI, PI);
+					Channels.JointOrientation[Axis] = Random.FRandRange(-PI, PI);
+					Channels.ScaleOrientation[Axis] = (Random.FRand() < 0.1f) ? Random.FRandRange(-0.5f, 0.5f) : 0.0;
+					Channels.Scale[Axis] = 1.0;
+				}
+				if (Random.FRand() < 0.02f)
+				{
+					Channels.Scale[0] = Random.FRandRange(0.5f, 2.f);
+				}
+				Channels.RotationOrder = (ERotationOrder)Random.RandHelper(6);
+				Channels.JointOrientationOrder = ERotationOrder::XYZ;
+				Channels.ScaleOrientationOrder = ERotationOrder::XYZ;
+
+				const FJointChannels* ParentChannels = (ParentIdx == -1) ? nullptr : &Character.RestChannels[ParentIdx];
+				for (int32 Axis = 0; Axis < 3; ++Axis)
+				{
+					Channels.ParentScale[Axis] = ParentChannels ? ParentChannels->Scale[Axis] : 1.0;
+				}
+				Character.RestChannels.Add(Channels);
+			}
+
+			for (int32 CurveIdx = 0; CurveIdx < Settings.NumCurves; ++CurveIdx)
+			{
+				Character.CurvePhases.Add(Random.FRandRange(0.f, 2.f * PI));
+			}
+		}
+
+		for (int32 TransformIdx = 0; TransformIdx < Settings.NumCameras + Settings.NumProps; ++TransformIdx)
+		{
+			const bool bCamera = TransformIdx < Settings.NumCameras;
+
+			Transforms.AddDefaulted();
+			FSyntheticTransform& Transform = Transforms.Last();
+			Transform.bCamera = bCamera;
+			Transform.SubjectName = bCamera ? FName(TEXT("LiveLinkBenchmark_Camera"), TransformIdx + 1) : FName(TEXT("LiveLinkBenchmark_Prop"), TransformIdx - Settings.NumCameras + 1);
+			Transform.FrameFilter = MakeShareable(new FLiveLinkSubjectFrameFilter(Transform.SubjectName));
+			Transform.Phase = Random.FRandRange(0.f, 2.f * PI);
+			Transform.Location = MVector(Random.FRandRange(-500.f, 500.f), Random.FRandRange(-500.f, 500.f), Random.FRandRange(-500.f, 500.f));
+		}
+	}
+
+	/** Static data for publishing runs */
+	void SendStaticData() const
+	{
+		ForEachStaticData([](FName SubjectName, const TArray<FName>& BoneNames, const TArray<int32>& BoneParents)
+		{
+			SendSubject(SubjectName, BoneNames, BoneParents);
+		});
+	}
+
+	/** Publishing runs don't leave their subjects behind in the editor */
+	void ClearSubjects() const
+	{
+		ForEachStaticData([](FName SubjectName, const TArray<FName>&, const TArray<int32>&)
+		{
+			EndpointHub.ClearSubject(SubjectName);
+		});
+	}
+
+	void ForEachStaticData(TFunctionRef<void(FName, const TArray<FName>&, const TArray<int32>&)> Visit) const
+	{
+		static const TArray<FName> TransformBoneNames = { FName("root") };
+		static const TArray<int32> TransformBoneParents = { -1 };
+
+		for (const FSyntheticCharacter& Character : Characters)
+		{
+			Visit(Character.SubjectName, Character.BoneNames, Character.BoneParents);
+		}
+		for (const FSyntheticTransform& Transform : Transforms)
+		{
+			Visit(Transform.SubjectName, TransformBoneNames, TransformBoneParents);
+		}
+	}
+
+	void Capture(double SceneTime, FLiveLinkStreamSnapshot& Snapshot) const
+	{
+		for (const FSyntheticCharacter& Character : Characters)
+		{
+			FLiveLinkSubjectCapture& Capture = Snapshot.AddCapture();
+			Capture.Source = FLiveLinkSubjectCapture::ESource::JointChannels;
+			Capture.SubjectName = Character.SubjectName;
+			Capture.FrameFilter = Character.FrameFilter;
+			Capture.FoldedJointIndices.Reset();
+			Capture.FoldedJointMatrices.Reset();
+			Capture.bCorrectForYUp = bCorrectForYUp;
+
+			Capture.JointChannels = Character.RestChannels;
+			for (int32 JointIdx = 0; JointIdx < Capture.JointChannels.Num(); ++JointIdx)
+			{
+				double* Rotation = Capture.JointChannels[JointIdx].Rotation;
+				const double Phase = Character.Phases[JointIdx];
+				Rotation[0] += 0.5 * FMath::Sin(SceneTime * 2.0 + Phase);
+				Rotation[1] += 0.3 * FMath::Sin(SceneTime * 3.0 + Phase);
+				Rotation[2] += 0.2 * FMath::Sin(SceneTime * 5.0 + Phase);
+			}
+
+			Capture.CurveNames = Character.CurveNames;
+			Capture.CurveValues.SetNum(Character.CurvePhases.Num(), false);
+			for (int32 CurveIdx = 0; CurveIdx < Character.CurvePhases.Num(); ++CurveIdx)
+			{
+				Capture.CurveValues[CurveIdx] = FMath::Sin(SceneTime + Character.CurvePhases[CurveIdx]);
+			}
+		}
+
+		for (const FSyntheticTransform& Transform : Transforms)
+		{
+			FLiveLinkSubjectCapture& Capture = Snapshot.AddCapture();
+			Capture.Source = Transform.bCamera ? FLiveLinkSubjectCapture::ESource::Camera : FLiveLinkSubjectCapture::ESource::Transform;
+			Capture.SubjectName = Transform.SubjectName;
+			Capture.FrameFilter = Transform.FrameFilter;
+			Capture.CurveNames.Reset();
+
+			const double Angle = SceneTime + Transform.Phase;
+			Capture.Transform = MEulerRotation(0.3 * FMath::Sin(Angle), Angle, 0.1 * FMath::Cos(Angle)).asMatrix();
+			SetMatrixRow(Capture.Transform[3], Transform.Location + MVector(FMath::Sin(Angle), 0.0, FMath::Cos(Angle)) * 100.0);
+		}
+	}
+
+	int32 GetNumSubjects() const
+	{
+		return Characters.Num() + Transforms.Num();
+	}
+
+	int32 GetNumJoints() const
+	{
+		int32 NumJoints = Transforms.Num();
+		for (const FSyntheticCharacter& Character : Characters)
+		{
+			NumJoints += Character.RestChannels.Num();
+		}
+		return NumJoints;
+	}
+
+	/**
+	* Worst differences of the fused kernel and the batched decomposition against the scalar matrix path, and the
+	* number of joints whose transform differs in any bit between serial and joint-split builds of each character
+	*/
+	struct FAccuracy
+	{
+		int32 FusedJoints = 0;
+		int32 MatrixPathJoints = 0;
+		int32 ParallelMismatchedJoints = 0;
+		double FusedTranslationError = 0.0;
+		double FusedRotationError = 0.0;
+		double FusedScaleError = 0.0;
+		double BatchedTranslationError = 0.0;
+		double BatchedRotationError = 0.0;
+		double BatchedScaleError = 0.0;
+	};
+
+	FAccuracy MeasureAccuracy() const
+	{
+		FAccuracy Accuracy;
+		TArray<MMatrix> Matrices;
+		TArray<FTransform> Reference;
+
+		for (const FSyntheticCharacter& Character : Characters)
+		{
+			for (const LiveLinkJointMath::FJointChannels& Channels : Character.RestChannels)
+			{
+				const MMatrix JointMatrix = BuildMayaJointMatrix(Channels);
+				const FTransform ScalarTransform = BuildUETransformFromMayaTransform(JointMatrix);
+				Matrices.Add(JointMatrix);
+				Reference.Add(ScalarTransform);
+
+				FTransform FusedTransform;
+				if (LiveLinkJointMath::BuildUETransform(Channels, FusedTransform))
+				{
+					++Accuracy.FusedJoints;
+					AccumulateError(FusedTransform, ScalarTransform, Accuracy.FusedTranslationError, Accuracy.FusedRotationError, Accuracy.FusedScaleError);
+				}
+				else
+				{
+					++Accuracy.MatrixPathJoints;
+				}
+			}
+		}
+
+		TArray<FTransform> Batched;
+		Batched.SetNum(Matrices.Num());
+		BuildUETransformsFromMayaTransforms(Matrices.GetData(), Batched.GetData(), Matrices.Num());
+		for (int32 Idx = 0; Idx < Batched.Num(); ++Idx)
+		{
+			AccumulateError(Batched[Idx], Reference[Idx], Accuracy.BatchedTranslationError, Accuracy.BatchedRotationError, Accuracy.BatchedScaleError);
+		}
+
+		// Odd task sizes so range boundaries fall mid batch before being aligned
+		FLiveLinkParallelEvaluationSettings SerialSettings;
+		SerialSettings.JointSplitThreshold = 0;
+		FLiveLinkParallelEvaluationSettings SplitSettings;
+		SplitSettings.MaxThreads = FMath::Max(ParallelEvaluationSettings.GetNumThreads(), 4);
+		SplitSettings.JointSplitThreshold = 1;
+		SplitSettings.JointsPerTask = 7;
+
+		FLiveLinkFrameBuildContext SerialContext;
+		FLiveLinkFrameBuildContext SplitContext;
+		for (const FSyntheticCharacter& Character : Characters)
+		{
+			BuildJointTransforms(Character.RestChannels, SerialSettings, SerialContext);
+			BuildJointTransforms(Character.RestChannels, SplitSettings, SplitContext);
+			for (int32 Idx = 0; Idx < SerialContext.Transforms.Num(); ++Idx)
+			{
+				if (!IsBitIdentical(SerialContext.Transforms[Idx], SplitContext.Transforms[Idx]))
+				{
+					++Accuracy.ParallelMismatchedJoints;
+				}
+			}
+		}
+
+		return Accuracy;
+	}
+
+private:
+	static bool IsBitIdentical(const FTransform& A, const FTransform& B)
+	{
+		const FQuat RotationA = A.GetRotation(), RotationB = B.GetRotation();
+		const FVector TranslationA = A.GetTranslation(), TranslationB = B.GetTranslation();
+		const FVector ScaleA = A.GetScale3D(), ScaleB = B.GetScale3D();
+		return FMemory::Memcmp(&RotationA, &RotationB, sizeof(FQuat)) == 0
+			&& FMemory::Memcmp(&TranslationA, &TranslationB, sizeof(FVector)) == 0
+			&& FMemory::Memcmp(&ScaleA, &ScaleB, sizeof(FVector)) == 0;
+	}
+
+	static void AccumulateError(const FTransform& Value, const FTransform& Reference, double& TranslationError, double& RotationError, double& ScaleError)
+	{
+		TranslationError = FMath::Max<double>(TranslationError, FVector::Dist(Value.GetTranslation(), Reference.GetTranslation()));
+		RotationError = FMath::Max<double>(RotationError, FMath::RadiansToDegrees(Value.GetRotation().AngularDistance(Reference.GetRotation())));
+		ScaleError = FMath::Max<double>(ScaleError, (Value.GetScale3D() - Reference.GetScale3D()).GetAbsMax());
+	}
+
+	struct FSyntheticCharacter
+	{
+		FName SubjectName;
+		TSharedPtr<FLiveLinkSubjectFrameFilter, ESPMode::ThreadSafe> FrameFilter;
+		TArray<FName> BoneNames;
+		TArray<int32> BoneParents;
+		TArray<LiveLinkJointMath::FJointChannels> RestChannels;
+		TArray<double> Phases;
+		TSharedPtr<const TArray<FName>, ESPMode::ThreadSafe> CurveNames;
+		TArray<double> CurvePhases;
+	};
+
+	struct FSyntheticTransform
+	{
+		FName SubjectName;
+		TSharedPtr<FLiveLinkSubjectFrameFilter, ESPMode::ThreadSafe> FrameFilter;
+		bool bCamera;
+		double Phase;
+		MVector Location;
+	};
+
+	TArray<FSyntheticCharacter> Characters;
+	TArray<FSyntheticTransform> Transforms;
+};
+
+/** Reads the benchmark's shared memory ring on its own thread, the way a reader in the editor's process would */
+class FLiveLinkTransportBenchmarkReader : public FRunnable
+{
+public:
+	FLiveLinkTransportBenchmarkReader(const FString& RegionName, int32 MaxFrames)
+		: Thread(nullptr)
+		, bStopRequested(false)
+		, Checksum(0.0f)
+	{
+		LatenciesUs.Reserve(MaxFrames);
+		if (Reader.Open(RegionName))
+		{
+			Thread = FRunnableThread::Create(this, TEXT("LiveLinkTransportBenchmarkReader"));
+		}
+	}
+
+	virtual ~FLiveLinkTransportBenchmarkReader()
+	{
+		Stop();
+	}
+
+	bool IsRunning() const { return Thread != nullptr; }
+
+	/** Reads whatever is left in the ring, then waits for the thread */
+	virtual void Stop() override
+	{
+		bStopRequested = true;
+		if (Thread != nullptr)
+		{
+			Thread->WaitForCompletion();
+			delete Thread;
+			Thread = nullptr;
+		}
+	}
+
+	virtual uint32 Run() override
+	{
+		for (;;)
+		{
+			const bool bStopping = bStopRequested.load();
+			Reader.Poll([this](const LiveLinkSharedMemory::FReader::FFrameView& View)
+			{
+				// Touch every value like a consumer applying the frame would, in place unless it has to be decoded
+				float Sum = 0.0f;
+				if (View.IsCompact())
+				{
+					View.Decode(DecodedTransforms, DecodedCurves);
+					for (const FTransform& Transform : DecodedTransforms)
+					{
+						Sum += Transform.GetTranslation().X;
+					}
+				}
+				else
+				{
+					const uint32 NumValues = View.Record.NumTransforms * LiveLinkSharedMemory::FloatsPerTransform + View.Record.NumCurves;
+					for (uint32 Idx = 0; Idx < NumValues; ++Idx)
+					{
+						Sum += View.Transforms[Idx];
+					}
+				}
+				Checksum += Sum;
+
+				// A torn record's times may be another record's, or garbage
+				const double ReadTime = FPlatformTime::Seconds();
+				if (View.IsIntact() && LatenciesUs.Num() < LatenciesUs.Max())
+				{
+					LatenciesUs.Add((float)((ReadTime - View.Record.PublishTime) * 1e6));
+				}
+			});
+
+			if (bStopping)
+			{
+				return 0;
+			}
+			FPlatformProcess::Sleep(0.f);
+		}
+	}
+
+	const LiveLinkSharedMemory::FReader& GetReader() const { return Reader; }
+
+	/** Latency percentile in microseconds, only valid once stopped */
+	float GetLatencyPercentile(float Percentile)
+	{
+		if (LatenciesUs.Num() == 0)
+		{
+			return 0.0f;
+		}
+		LatenciesUs.Sort();
+		return LatenciesUs[FMath::Clamp((int32)(Percentile * LatenciesUs.Num()), 0, LatenciesUs.Num() - 1)];
+	}
+
+private:
+	LiveLinkSharedMemory::FReader Reader;
+	FRunnableThread* Thread;
+	std::atomic<bool> bStopRequested;
+
+	TArray<float> LatenciesUs;
+	float Checksum;
+
+	TArray<FTransform> DecodedTransforms;
+	TArray<FLiveLinkCurveElement> DecodedCurves;
+};
+
+/**
+* Runs the synthetic scene through the streaming stages and returns the results as JSON. Capture times the synthetic
+* source filling the snapshot, not Maya API reads; convert, curves and publish run the same code as live streaming.
+*/
+FString RunStreamingBenchmark(const FLiveLinkBenchmarkSettings& Settings)
+{
+	enum EStage { Capture, Convert, Curves, Publish, NumStages };
+	static const TCHAR* StageNames[NumStages] = { TEXT("capture"), TEXT("convert"), TEXT("curves"), TEXT("publish") };
+
+	FLiveLinkSyntheticScene Scene;
+	Scene.Generate(Settings);
+	if (Settings.bPublish)
+	{
+		StreamPipeline.Flush();
+		Scene.SendStaticData();
+	}
+
+	FLiveLinkStreamSnapshot Snapshot;
+	uint64 StageCycles[NumStages] = {};
+
+	enum ESubjectType { Character, Camera, Prop, NumSubjectTypes };
+	static const TCHAR* SubjectTypeNames[NumSubjectTypes] = { TEXT("character"), TEXT("camera"), TEXT("prop") };
+	FLiveLinkEncodingStats EncodingStats[NumSubjectTypes];
+
+	LiveLinkFrameCodec::FSettings EncodingSettings;
+	EncodingSettings.Encoding = LiveLinkFrameCodec::EEncoding::Compact;
+	EncodingSettings.MaxPositionError = Settings.MaxPositionError;
+	EncodingSettings.MaxRotationError = Settings.MaxRotationError;
+	EncodingSettings.MaxCurveError = Settings.MaxCurveError;
+
+	TArray<uint8> EncodeBuffer;
+	TArray<FTransform> DecodedTransforms;
+	TArray<FLiveLinkCurveElement> DecodedCurves;
+
+	// Private ring sized so a whole frame of subjects fits, named per process so parallel Maya sessions don't collide
+	LiveLinkSharedMemory::FWriter TransportWriter;
+	TUniquePtr<FLiveLinkTransportBenchmarkReader> TransportReader;
+	uint64 TransportCycles = 0;
+	if (Settings.bTransport)
+	{
+		const FString RegionName = FString::Printf(TEXT("MayaLiveLinkBenchmark%u"), FPlatformProcess::GetCurrentProcessId());
+		const uint32 SlotSize = FMath::Max(64 * 1024, Settings.JointsPerCharacter * 64 + Settings.NumCurves * 32);
+		if (TransportWriter.Open(RegionName, FMath::Max(256, Scene.GetNumSubjects() * 4), SlotSize))
+		{
+			Scene.ForEachStaticData([&TransportWriter](FName SubjectName, const TArray<FName>& BoneNames, const TArray<int32>& BoneParents)
+			{
+				TransportWriter.PublishSubject(SubjectName, BoneNames, BoneParents);
+			});
+			TransportReader = MakeUnique<FLiveLinkTransportBenchmarkReader>(RegionName, (Settings.NumFrames + Settings.NumWarmupFrames) * Scene.GetNumSubjects());
+		}
+	}
+
+	for (int32 Frame = -Settings.NumWarmupFrames; Frame < Settings.NumFrames; ++Frame)
+	{
+		const double SceneTime = Frame / 30.0;
+		uint64 Cycles[NumStages + 1];
+
+		Cycles[Capture] = FPlatformTime::Cycles64();
+		Snapshot.Reset(SceneTime, Frame);
+		Scene.Capture(SceneTime, Snapshot);
+
+		Cycles[Convert] = FPlatformTime::Cycles64();
+		DecomposeSingleTransformCaptures(Snapshot);
+		ParallelForEachCapture(Snapshot, [&Snapshot](int32 Idx)
+		{
+			BuildSubjectTransforms(Snapshot.Captures[Idx], Snapshot.ParallelSettings, Snapshot.Frames[Idx]);
+		});
+
+		Cycles[Curves] = FPlatformTime::Cycles64();
+		ParallelForEachCapture(Snapshot, [&Snapshot](int32 Idx)
+		{
+			BuildSubjectCurves(Snapshot.Captures[Idx], Snapshot.Frames[Idx]);
+		});
+
+		Cycles[Publish] = FPlatformTime::Cycles64();
+		for (int32 Idx = 0; Idx < Snapshot.NumCaptures; ++Idx)
+		{
+			const FLiveLinkSubjectCapture& SubjectCapture = Snapshot.Captures[Idx];
+			const FLiveLinkFrameBuildContext& SubjectFrame = Snapshot.Frames[Idx];
+			if (SubjectCapture.FrameFilter->ShouldSend(SubjectFrame.Transforms, SubjectFrame.Curves, SceneTime) && Settings.bPublish)
+			{
+				SendSubjectFrame(SubjectCapture.SubjectName, SubjectFrame.Transforms, SubjectFrame.Curves, SceneTime, &SubjectCapture.FrameFilter->GetTraffic());
+			}
+		}
+		Cycles[NumStages] = FPlatformTime::Cycles64();
+
+		if (TransportWriter.IsOpen())
+		{
+			if (Frame == 0)
+			{
+				TransportWriter.ResetStats();
+			}
+
+			const uint64 TransportStart = FPlatformTime::Cycles64();
+			for (int32 Idx = 0; Idx < Snapshot.NumCaptures; ++Idx)
+			{
+				TransportWriter.PublishFrame(Snapshot.Captures[Idx].SubjectName, Snapshot.Frames[Idx].Transforms, Snapshot.Frames[Idx].Curves, SceneTime);
+			}
+			if (Frame >= 0)
+			{
+				TransportCycles += FPlatformTime::Cycles64() - TransportStart;
+			}
+		}
+
+		if (Frame >= 0)
+		{
+			for (int32 Stage = 0; Stage < NumStages; ++Stage)
+			{
+				StageCycles[Stage] += Cycles[Stage + 1] - Cycles[Stage];
+			}
+
+			for (int32 Idx = 0; Idx < Snapshot.NumCaptures; ++Idx)
+			{
+				const FLiveLinkSubjectCapture::ESource Source = Snapshot.Captures[Idx].Source;
+				const ESubjectType SubjectType = (Source == FLiveLinkSubjectCapture::ESource::JointChannels) ? Character : (Source == FLiveLinkSubjectCapture::ESource::Camera) ? Camera : Prop;
+				EncodingStats[SubjectType].Accumulate(Snapshot.Captures[Idx].SubjectName, Snapshot.Frames[Idx], EncodingSettings, EncodeBuffer, DecodedTransforms, DecodedCurves);
+			}
+		}
+	}
+
+	if (Settings.bPublish)
+	{
+		Scene.ClearSubjects();
+	}
+
+	const int32 NumSubjects = FMath::Max(Scene.GetNumSubjects(), 1);
+	const int32 NumJoints = FMath::Max(Scene.GetNumJoints(), 1);
+	const int32 NumFrames = FMath::Max(Settings.NumFrames, 1);
+	const double NanosecondsPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1e9;
+
+	FString Json = TEXT("{\n");
+	Json += FString::Printf(TEXT("\t\"scene\": {\"characters\": %d, \"joints_per_character\": %d, \"fan_out\": %d, \"max_depth\": %d, \"cameras\": %d, \"props\": %d, \"curves\": %d, \"frames\": %d, \"seed\": %d, \"subjects\": %d, \"joints_per_frame\": %d, \"threads\": %d, \"publish\": %s},\n"),
+		Settings.NumCharacters, Settings.JointsPerCharacter, Settings.FanOut, Settings.MaxDepth, Settings.NumCameras, Settings.NumProps, Settings.NumCurves,
+		Settings.NumFrames, Settings.Seed, Scene.GetNumSubjects(), Scene.GetNumJoints(), ParallelEvaluationSettings.GetNumThreads(), Settings.bPublish ? TEXT("true") : TEXT("false"));
+
+	Json += TEXT("\t\"stages\": {\n");
+	uint64 TotalCycles = 0;
+	for (int32 Stage = 0; Stage <= NumStages; ++Stage)
+	{
+		const bool bTotal = Stage == NumStages;
+		const uint64 Cycles = bTotal ? TotalCycles : StageCycles[Stage];
+		TotalCycles += bTotal ? 0 : Cycles;
+
+		const double NanosecondsPerFrame = Cycles * NanosecondsPerCycle / NumFrames;
+		Json += FString::Printf(TEXT("\t\t\"%s\": {\"ns_per_frame\": %.1f, \"ns_per_subject\": %.1f, \"ns_per_joint\": %.2f}%s\n"),
+			bTotal ? TEXT("total") : StageNames[Stage], NanosecondsPerFrame, NanosecondsPerFrame / NumSubjects, NanosecondsPerFrame / NumJoints, bTotal ? TEXT("") : TEXT(","));
+	}
+	Json += TEXT("\t},\n");
+
+	const FLiveLinkSyntheticScene::FAccuracy Accuracy = Scene.MeasureAccuracy();
+	Json += FString::Printf(TEXT("\t\"accuracy\": {\"fused_joints\": %d, \"matrix_path_joints\": %d, \"fused_max_translation_error\": %g, \"fused_max_rotation_error_deg\": %g, \"fused_max_scale_error\": %g, \"batched_max_translation_error\": %g, \"batched_max_rotation_error_deg\": %g, \"batched_max_scale_error\": %g, \"parallel_mismatched_joints\": %d},\n"),
+		Accuracy.FusedJoints, Accuracy.MatrixPathJoints, Accuracy.FusedTranslationError, Accuracy.FusedRotationError, Accuracy.FusedScaleError,
+		Accuracy.BatchedTranslationError, Accuracy.BatchedRotationError, Accuracy.BatchedScaleError, Accuracy.ParallelMismatchedJoints);
+
+	Json += FString::Printf(TEXT("\t\"encoding\": {\"max_position_error\": %g, \"max_rotation_error_deg\": %g, \"max_curve_error\": %g,\n"), Settings.MaxPositionError, Settings.MaxRotationError, Settings.MaxCurveError);
+	for (int32 SubjectType = 0; SubjectType < NumSubjectTypes; ++SubjectType)
+	{
+		Json += FString::Printf(TEXT("\t\t\"%s\": %s%s\n"), SubjectTypeNames[SubjectType], *EncodingStats[SubjectType].ToJson(), SubjectType + 1 < NumSubjectTypes ? TEXT(",") : TEXT(""));
+	}
+	Json += TransportWriter.IsOpen() ? TEXT("\t},\n") : TEXT("\t}\n");
+
+	// The provider's cost is its publish stage, only meaningful when publishing to a connected editor
+	if (TransportWriter.IsOpen())
+	{
+		TransportReader->Stop();
+		const LiveLinkSharedMemory::FReader& Reader = TransportReader->GetReader();
+		const double TransportSeconds = FMath::Max(TransportCycles * FPlatformTime::GetSecondsPerCycle64(), 1e-9);
+		const double ProviderNanosecondsPerFrame = StageCycles[Publish] * NanosecondsPerCycle / NumFrames;
+		const bool bProviderConnected = Settings.bPublish && LiveLinkProvider.IsValid() && LiveLinkProvider->HasConnection();
+
+		Json += TEXT("\t\"transport\": {\n");
+		Json += FString::Printf(TEXT("\t\t\"shared_memory\": {\"ns_per_frame\": %.1f, \"mb_per_second\": %.1f, \"frames_per_second\": %.0f, \"frames_read\": %llu, \"lost\": %llu, \"torn\": %llu, \"oversized\": %llu, \"latency_us_p50\": %.1f, \"latency_us_p99\": %.1f, \"latency_us_max\": %.1f},\n"),
+			TransportCycles * NanosecondsPerCycle / NumFrames, TransportWriter.GetBytesWritten() / TransportSeconds / (1024.0 * 1024.0), TransportWriter.GetFramesWritten() / TransportSeconds,
+			Reader.GetFramesRead(), Reader.GetRecordsLost(), Reader.GetRecordsTorn(), TransportWriter.GetRecordsOversized(),
+			TransportReader->GetLatencyPercentile(0.5f), TransportReader->GetLatencyPercentile(0.99f), TransportReader->GetLatencyPercentile(1.0f));
+		Json += FString::Printf(TEXT("\t\t\"provider\": {\"ns_per_frame\": %.1f, \"published\": %s, \"connected\": %s}\n"),
+			ProviderNanosecondsPerFrame, Settings.bPublish ? TEXT("true") : TEXT("false"), bProviderConnected ? TEXT("true") : TEXT("false"));
+		Json += TEXT("\t}\n");
+
+		TransportReader.Reset();
+		TransportWriter.Close();
+	}
+	Json += TEXT("}\n");
+
+	return Json;
+}
+
+struct FLiveLinkStreamedJointHeirarchySubject : IStreamedEntity
+{
+	FLiveLinkStreamedJointHeirarchySubject(FName InSubjectName, MDagPath InRootPath)
+		: SubjectName(InSubjectName)
+		, RootDagPath(InRootPath)
+		, FrameFilter(new FLiveLinkSubjectFrameFilter(InSubjectName))
+	{
+		RemovalWatcher.Watch(RootDagPath.node(), SubjectName);
+	}
+
+	virtual bool ShouldDisplayInUI() const { return true; }
+	virtual FName GetSubjectName() const { return SubjectName; }
+	virtual const FLiveLinkSubjectFrameFilter& GetFrameFilter() const { return *FrameFilter; }
+	virtual const FLiveLinkStaticDataState& GetStaticDataState() const { return StaticDataState; }
+
+	virtual MString GetDisplayText() const
+	{
+		MString DisplayText = MString("Character: ") + MString(*SubjectName.ToString()) + " ( " + RootDagPath.fullPathName() + " )";
+		if (LodJointCounts.Num() > 0)
+		{
+			// The active level is marked with a *
+			const FName ActiveLevel = SubjectLodRegistry.GetActiveLevel(SubjectName);
+			FString Lods;
+			for (const TPair<FName, int32>& LodJointCount : LodJointCounts)
+			{
+				Lods += FString::Printf(TEXT("%s%s%s %d"), Lods.IsEmpty() ? TEXT("") : TEXT(", "), *LodJointCount.Key.ToString(), LodJointCount.Key == ActiveLevel ? TEXT("*") : TEXT(""), LodJointCount.Value);
+			}
+			DisplayText += MString(" [") + MString(*Lods) + " of " + NumJointsUnderRoot + " joints]";
+		}
+		return DisplayText;
+	}
+
+	virtual void GetLodJointCounts(TArray<TPair<FName, int32>>& OutCounts, int32& OutNumJoints) const
+	{
+		OutCounts = LodJointCounts;
+		OutNumJoints = NumJointsUnderRoot;
+	}
+
+	virtual bool IsAffectedByDagChange(const MDagPath& Child, const MDagPath& Parent) const
+	{
+		return SubtreeIndex.IsAffectedBy(Child, Parent);
+	}
+
+	virtual bool ValidateSubject() const
+	{
+		// Deletion is caught by the removal callbacks, the path check catches the root being reparented
+		const bool bIsValid = !RemovalWatcher.IsRemoved() && RootDagPath.isValid();
+		if (DebugVerbosity >= 2)
+		{
+			FPlatformMisc::LowLevelOutputDebugStringf(TEXT("Validating %s Path:%s Valid:%s\n"), *SubjectName.ToString(), RootDagPath.fullPathName().asWChar(), bIsValid ? TEXT("true") : TEXT("false"));
+		}
+		return bIsValid;
+	}
+
+	virtual void RebuildSubjectData()
+	{
+		JointsToStream.Reset();
+		FoldedJoints.Reset();
+		DirtyWatcher.Reset();
+		SubtreeIndex.Build(RootDagPath);
+		CurvePlugCache.Initialize(RootDagPath.node(), SubjectName);
+
+		MStatus status;
+		MItDag JointIterator;
+		JointIterator.reset(RootDagPath, MItDag::kDepthFirst, MFn::kJoint);
+
+		//Build Hierarchy
+		TArray<int32> ParentIndexStack;
+		ParentIndexStack.SetNum(100, false);
+
+		// Every joint under the root, the active LOD level's mask decides which of them are captured and streamed
+		struct FJointUnderRoot
+		{
+			FName JointName;
+			MDagPath JointPath;
+			int32 ParentIndex;
+			int32 Depth;
+			bool bIsInfluence;
+		};
+		TArray<FJointUnderRoot> Joints;
+
+		int32 Index = 0;
+
+		for (; !JointIterator.isDone(); JointIterator.next())
+		{
+			uint32 Depth = JointIterator.depth();
+			if (Depth >= (uint32)ParentIndexStack.Num())
+			{
+				ParentIndexStack.SetNum(Depth + 1);
+			}
+			ParentIndexStack[Depth] = Index++;
+
+			int32 ParentIndex = Depth == 0 ? -1 : ParentIndexStack[Depth - 1];
+
+			MDagPath JointPath;
+			status = JointIterator.getPath(JointPath);
+			MFnIkJoint JointObject(JointPath);
+
+			//MGlobal::displayInfo(MString("Iter: ") + JointPath.fullPathName() + JointIterator.depth());
+
+			FJointUnderRoot Joint;
+			Joint.JointName = FName(StripMayaNamespace(JointObject.name()).asChar());
+			Joint.JointPath = JointPath;
+			Joint.ParentIndex = ParentIndex;
+			Joint.Depth = Depth;
+			Joint.bIsInfluence = false;
+			Joints.Add(Joint);
+		}
+
+		const TMap<FName, FLiveLinkJointMask>* Levels = SubjectLodRegistry.FindLevels(SubjectName);
+		const FLiveLinkJointMask* ActiveMask = SubjectLodRegistry.FindActiveMask(SubjectName);
+
+		if (Levels != nullptr)
+		{
+			bool bNeedsInfluences = false;
+			for (const TPair<FName, FLiveLinkJointMask>& Level : *Levels)
+			{
+				bNeedsInfluences |= Level.Value.bInfluencesOnly;
+			}
+
+			if (bNeedsInfluences)
+			{
+				TSet<uint32> Influences;
+				GatherSkinInfluences(Influences);
+				for (FJointUnderRoot& Joint : Joints)
+				{
+					Joint.bIsInfluence = Influences.Contains(MObjectHandle(Joint.JointPath.node()).hashCode());
+				}
+			}
+		}
+
+		TArray<FString> JointNameStrings;
+		for (const FJointUnderRoot& Joint : Joints)
+		{
+			JointNameStrings.Add(Joint.JointName.ToString());
+		}
+
+		LodJointCounts.Reset();
+		NumJointsUnderRoot = Joints.Num();
+		if (Levels != nullptr)
+		{
+			for (const TPair<FName, FLiveLinkJointMask>& Level : *Levels)
+			{
+				int32 NumKept = 0;
+				for (int32 Idx = 0; Idx < Joints.Num(); ++Idx)
+				{
+					NumKept += Level.Value.KeepsJoint(JointNameStrings[Idx], Joints[Idx].Depth, Joints[Idx].bIsInfluence) ? 1 : 0;
+				}
+				LodJointCounts.Add(TPair<FName, int32>(Level.Key, NumKept));
+			}
+		}
+
+		TArray<bool> Kept;
+		Kept.SetNum(Joints.Num());
+		for (int32 Idx = 0; Idx < Joints.Num(); ++Idx)
+		{
+			Kept[Idx] = ActiveMask == nullptr || ActiveMask->KeepsJoint(JointNameStrings[Idx], Joints[Idx].Depth, Joints[Idx].bIsInfluence);
+		}
+
+		// Only kept joints are captured per frame, dropped joints are only read for the kept joints below them
+		TArray<int32> StreamedIndices;
+		StreamedIndices.Init(INDEX_NONE, Joints.Num());
+
+		TArray<FName> JointNames;
+		TArray<int32> JointParents;
+
+		for (int32 Idx = 0; Idx < Joints.Num(); ++Idx)
+		{
+			if (!Kept[Idx])
+			{
+				continue;
+			}
+
+			const FJointUnderRoot& Joint = Joints[Idx];
+			int32 Ancestor = Joint.ParentIndex;
+			TArray<int32> DroppedChain;
+			while (Ancestor != -1 && !Kept[Ancestor])
+			{
+				DroppedChain.Insert(Ancestor, 0);
+				Ancestor = Joints[Ancestor].ParentIndex;
+			}
+
+			const int32 StreamedParent = (Ancestor == -1) ? -1 : StreamedIndices[Ancestor];
+			StreamedIndices[Idx] = JointsToStream.Num();
+			JointsToStream.Add(FStreamHierarchy(Joint.JointName, Joint.JointPath, StreamedParent));
+			DirtyWatcher.Watch(Joint.JointPath.node());
+			JointNames.Add(Joint.JointName);
+			JointParents.Add(StreamedParent);
+
+			if (DroppedChain.Num() > 0)
+			{
+				FFoldedJoint& Folded = FoldedJoints[FoldedJoints.AddDefaulted()];
+				Folded.JointIndex = StreamedIndices[Idx];
+				for (int32 DroppedIdx : DroppedChain)
+				{
+					const FJointUnderRoot& Dropped = Joints[DroppedIdx];
+					Folded.DroppedChain.Add(FStreamHierarchy(Dropped.JointName, Dropped.JointPath, INDEX_NONE));
+					DirtyWatcher.Watch(Dropped.JointPath.node());
+				}
+			}
+		}
+
+		TSharedPtr<const TArray<FName>, ESPMode::ThreadSafe> CurveNames;
+		if (JointsToStream.Num() > 0)
+		{
+			CurveNames = CurvePlugCache.GetCurveNames(JointsToStream[0].JointObject);
+		}
+
+		StreamSubjectStaticData(SubjectName, *FrameFilter, StaticDataState, JointNames, JointParents, CurveNames.Get());
+	}
+
+	virtual bool CaptureFrame(FLiveLinkSubjectCapture& OutCapture)
+	{
+		if (JointsToStream.Num() == 0 || RemovalWatcher.IsRemoved())
+		{
+			return false;
+		}
+
+		OutCapture.Source = FLiveLinkSubjectCapture::ESource::JointChannels;
+		OutCapture.SubjectName = SubjectName;
+		OutCapture.FrameFilter = FrameFilter;
+		OutCapture.bCorrectForYUp = bCorrectForYUp;
+
+		TArray<LiveLinkJointMath::FJointChannels>& JointChannels = OutCapture.JointChannels;
+		JointChannels.SetNumUninitialized(JointsToStream.Num(), false);
+
+		for (int32 Idx = 0; Idx < JointsToStream.Num(); ++Idx)
+		{
+			const FStreamHierarchy& H = JointsToStream[Idx];
+
+			const LiveLinkJointMath::FJointChannels* ParentChannels = (H.ParentIndex == -1) ? nullptr : &JointChannels[H.ParentIndex];
+			CaptureJointChannels(H.JointObject, ParentChannels, JointChannels[Idx]);
+		}
+
+		OutCapture.FoldedJointIndices.Reset();
+		OutCapture.FoldedJointMatrices.Reset();
+		for (const FFoldedJoint& Folded : FoldedJoints)
+		{
+			const FStreamHierarchy& H = JointsToStream[Folded.JointIndex];
+
+			// Each joint's parent scale comes from the joint right above it, dropped or not
+			LiveLinkJointMath::FJointChannels ChainChannels[2];
+			const LiveLinkJointMath::FJointChannels* ParentChannels = (H.ParentIndex == -1) ? nullptr : &JointChannels[H.ParentIndex];
+			MMatrix LocalMatrix;
+			for (int32 ChainIdx = 0; ChainIdx < Folded.DroppedChain.Num(); ++ChainIdx)
+			{
+				LiveLinkJointMath::FJointChannels& DroppedChannels = ChainChannels[ChainIdx & 1];
+				CaptureJointChannels(Folded.DroppedChain[ChainIdx].JointObject, ParentChannels, DroppedChannels);
+				LocalMatrix = (ChainIdx == 0) ? BuildMayaJointMatrix(DroppedChannels) : BuildMayaJointMatrix(DroppedChannels) * LocalMatrix;
+				ParentChannels = &DroppedChannels;
+			}
+
+			LiveLinkJointMath::FJointChannels OwnChannels = JointChannels[Folded.JointIndex];
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				OwnChannels.ParentScale[Axis] = ParentChannels->Scale[Axis];
+			}
+
+			OutCapture.FoldedJointIndices.Add(Folded.JointIndex);
+			OutCapture.FoldedJointMatrices.Add(BuildMayaJointMatrix(OwnChannels) * LocalMatrix);
+		}
+
+		CurvePlugCache.UpdatePropertyCurves(JointsToStream[0].JointObject, OutCapture.CurveNames, OutCapture.CurveValues);
+		return true;
+	}
+
+private:
+	FName SubjectName;
+	MDagPath RootDagPath;
+	TSharedPtr<FLiveLinkSubjectFrameFilter, ESPMode::ThreadSafe> FrameFilter;
+	FLiveLinkNodeDirtyWatcher DirtyWatcher;
+	FLiveLinkDagSubtreeIndex SubtreeIndex;
+	MayaSyncedUserDefinedAttributes::FCurvePlugCache CurvePlugCache;
+	FLiveLinkStaticDataState StaticDataState;
+	FLiveLinkNodeRemovalWatcher RemovalWatcher;
+
+	// Streamed joints, parents are indices into this array
+	TArray<FStreamHierarchy> JointsToStream;
+
+	/** A streamed joint whose Maya parent the active LOD level drops, with the dropped joints above it top down */
+	struct FFoldedJoint
+	{
+		int32 JointIndex;
+		TArray<FStreamHierarchy> DroppedChain;
+	};
+	TArray<FFoldedJoint> FoldedJoints;
+
+	TArray<TPair<FName, int32>> LodJointCounts;
+	int32 NumJointsUnderRoot = 0;
+};
+
+struct FLiveLinkBaseCameraStreamedSubject : public IStreamedEntity
+{
+public:
+	FLiveLinkBaseCameraStreamedSubject(FName InSubjectName) : SubjectName(InSubjectName), FrameFilter(new FLiveLinkSubjectFrameFilter(InSubjectName)) {}
+
+	virtual bool ValidateSubject() const { return true; }
+	virtual FName GetSubjectName() const { return SubjectName; }
+	virtual const FLiveLinkSubjectFrameFilter& GetFrameFilter() const { return *FrameFilter; }
+	virtual const FLiveLinkStaticDataState& GetStaticDataState() const { return StaticDataState; }
+
+	virtual void RebuildSubjectData()
+	{
+		StreamSubjectStaticData(SubjectName, *FrameFilter, StaticDataState, ActiveCameraBoneNames, ActiveCameraBoneParents, LensCurveNames.Get());
+	}
+
+	/** Reads the cached camera, lens values go out as curves and unchanged lenses are left to the frame filter */
+	bool CaptureCamera(FLiveLinkSubjectCapture& OutCapture)
+	{
+		if (!ResolveCamera())
+		{
+			return false;
+		}
+
+		OutCapture.Source = FLiveLinkSubjectCapture::ESource::Camera;
+		OutCapture.SubjectName = SubjectName;
+		OutCapture.FrameFilter = FrameFilter;
+
+		MMatrix& CameraTransformMatrix = OutCapture.Transform;
+		CameraTransformMatrix.setToIdentity();
+		SetMatrixRow(CameraTransformMatrix[0], CameraFn.rightDirection(MSpace::kWorld));
+		SetMatrixRow(CameraTransformMatrix[1], CameraFn.viewDirection(MSpace::kWorld));
+		SetMatrixRow(CameraTransformMatrix[2], CameraFn.upDirection(MSpace::kWorld));
+		SetMatrixRow(CameraTransformMatrix[3], CameraFn.eyePoint(MSpace::kWorld));
+
+		// Film aperture is in inches, Unreal's cine camera works in mm like the focal length
+		const float InchesToMillimeters = 25.4f;
+		OutCapture.CurveNames = LensCurveNames;
+		OutCapture.CurveValues.SetNum(ELensCurve::Count, false);
+		OutCapture.CurveValues[ELensCurve::FocalLength] = (float)CameraFn.focalLength();
+		OutCapture.CurveValues[ELensCurve::FilmApertureWidth] = (float)CameraFn.horizontalFilmAperture() * InchesToMillimeters;
+		OutCapture.CurveValues[ELensCurve::FilmApertureHeight] = (float)CameraFn.verticalFilmAperture() * InchesToMillimeters;
+		OutCapture.CurveValues[ELensCurve::FocusDistance] = (float)CameraFn.focusDistance();
+		OutCapture.CurveValues[ELensCurve::FStop] = (float)CameraFn.fStop();
+		OutCapture.CurveValues[ELensCurve::NearClipPlane] = (float)CameraFn.nearClippingPlane();
+		OutCapture.CurveValues[ELensCurve::FarClipPlane] = (float)CameraFn.farClippingPlane();
+		return true;
+	}
+
+protected:
+	/** Caches the function set and watches the camera, it stays in use until the camera node goes away */
+	void SetCamera(const MDagPath& InCameraPath)
+	{
+		CameraPath = InCameraPath;
+		CameraHandle = MObjectHandle(CameraPath.node());
+		DirtyWatcher.Reset();
+
+		if (CameraPath.isValid() && CameraFn.setObject(CameraPath) == MS::kSuccess)
+		{
+			DirtyWatcher.Watch(CameraPath.node());
+			DirtyWatcher.Watch(CameraPath.transform());
+		}
+		else
+		{
+			CameraHandle = MObjectHandle();
+		}
+	}
+
+	bool IsCameraAlive() const
+	{
+		return CameraHandle.isValid() && CameraHandle.isAlive();
+	}
+
+	bool HasValidCamera() const
+	{
+		return IsCameraAlive() && CameraPath.isValid();
+	}
+
+	/** Reparenting the camera or one of its parents invalidates the path but not the node, so the path is found again from the node */
+	bool ResolveCamera()
+	{
+		if (!IsCameraAlive())
+		{
+			return false;
+		}
+
+		if (!CameraPath.isValid())
+		{
+			MDagPath ResolvedPath;
+			if (MDagPath::getAPathTo(CameraHandle.object(), ResolvedPath) != MS::kSuccess)
+			{
+				CameraHandle = MObjectHandle();
+				return false;
+			}
+			SetCamera(ResolvedPath);
+		}
+
+		return HasValidCamera();
+	}
+
+	enum ELensCurve
+	{
+		FocalLength,
+		FilmApertureWidth,
+		FilmApertureHeight,
+		FocusDistance,
+		FStop,
+		NearClipPlane,
+		FarClipPlane,
+		Count,
+	};
+
+	FName  SubjectName;
+	TSharedPtr<FLiveLinkSubjectFrameFilter, ESPMode::ThreadSafe> FrameFilter;
+	FLiveLinkNodeDirtyWatcher DirtyWatcher;
+	FLiveLinkStaticDataState StaticDataState;
+
+	MDagPath CameraPath;
+	MObjectHandle CameraHandle;
+	MFnCamera CameraFn;
+
+	static TArray<FName> ActiveCameraBoneNames;
+	static TArray<int32> ActiveCameraBoneParents;
+	static TSharedPtr<const TArray<FName>, ESPMode::ThreadSafe> LensCurveNames;
+};
+
+TArray<FName> FLiveLinkBaseCameraStreamedSubject::ActiveCameraBoneNames = { FName("root") };
+TArray<int32> FLiveLinkBaseCameraStreamedSubject::ActiveCameraBoneParents = { -1 };
+TSharedPtr<const TArray<FName>, ESPMode::ThreadSafe> FLiveLinkBaseCameraStreamedSubject::LensCurveNames = MakeShareable(new TArray<FName>({
+	FName("FocalLength"), FName("FilmApertureWidth"), FName("FilmApertureHeight"), FName("FocusDistance"), FName("FStop"), FName("NearClipPlane"), FName("FarClipPlane") }));
+
+struct FLiveLinkStreamedActiveCamera : public FLiveLinkBaseCameraStreamedSubject
+{
+public:
+	FLiveLinkStreamedActiveCamera() : FLiveLinkBaseCameraStreamedSubject(ActiveCameraName) {}
+
+	virtual MString GetDisplayText() const { return MString(); }
+
+	// The active camera is tracked through panel callbacks and its static data never changes
+	virtual bool IsAffectedByDagChange(const MDagPath& Child, const MDagPath& Parent) const { return false; }
+
+	virtual bool CaptureFrame(FLiveLinkSubjectCapture& OutCapture)
+	{
+		if (bActiveCameraDirty || !ResolveCamera())
+		{
+			bActiveCameraDirty = false;
+
+			MStatus Status;
+			M3dView ActiveView = M3dView::active3dView(&Status);
+			MDagPath CameraDag;
+			if (Status == MStatus::kSuccess && ActiveView.getCamera(CameraDag) == MStatus::kSuccess && !(HasValidCamera() && CameraDag == CameraPath))
+			{
+				SetCamera(CameraDag);
+			}
+		}
+
+		return CaptureCamera(OutCapture);
+	}
+
+private:
+	static FName ActiveCameraName;
+};
+
+struct FLiveLinkStreamedCameraSubject : FLiveLinkBaseCameraStreamedSubject
+{
+public:
+	FLiveLinkStreamedCameraSubject(FName InSubjectName, MDagPath InDagPath) : FLiveLinkBaseCameraStreamedSubject(InSubjectName)
+	{
+		SetCamera(InDagPath);
+		RemovalWatcher.Watch(CameraPath.node(), SubjectName);
+
+		MDagPath TransformPath(CameraPath);
+		TransformPath.pop();
+		SubtreeIndex.Build(TransformPath);
+	}
+
+	virtual bool ValidateSubject() const
+	{
+		return !RemovalWatcher.IsRemoved() && IsCameraAlive();
+	}
+
+	virtual bool IsAffectedByDagChange(const MDagPath& Child, const MDagPath& Parent) const
+	{
+		return SubtreeIndex.IsAffectedBy(Child, Parent);
+	}
+
+	virtual bool ShouldDisplayInUI() const { return true; }
+	virtual MString GetDisplayText() const { return MString("Camera: ") + *SubjectName.ToString() + " ( " + CameraPath.fullPathName() + " )"; }
+
+	virtual bool CaptureFrame(FLiveLinkSubjectCapture& OutCapture)
+	{
+		return !RemovalWatcher.IsRemoved() && CaptureCamera(OutCapture);
+	}
+
+private:
+	FLiveLinkDagSubtreeIndex SubtreeIndex;
+	FLiveLinkNodeRemovalWatcher RemovalWatcher;
+};
+
+FName FLiveLinkStreamedActiveCamera::ActiveCameraName("EditorActiveCamera");
+
+struct FLiveLinkStreamedPropSubject : IStreamedEntity
+{
+public:
+	FLiveLinkStreamedPropSubject(FName InSubjectName, MDagPath InRootPath)
+		: SubjectName(InSubjectName)
+		, RootDagPath(InRootPath)
+		, FrameFilter(new FLiveLinkSubjectFrameFilter(InSubjectName))
+	{
+		DirtyWatcher.Watch(RootDagPath.node());
+		RemovalWatcher.Watch(RootDagPath.node(), SubjectName);
+		SubtreeIndex.Build(RootDagPath);
+	}
+
+	virtual bool ShouldDisplayInUI() const { return true; }
+	virtual MString GetDisplayText() const { return MString("Prop: ") + MString(*SubjectName.ToString()) + " ( " + RootDagPath.fullPathName() + " )"; }
+
+	virtual bool ValidateSubject() const { return !RemovalWatcher.IsRemoved() && RootDagPath.isValid(); }
+	virtual FName GetSubjectName() const { return SubjectName; }
+	virtual const FLiveLinkSubjectFrameFilter& GetFrameFilter() const { return *FrameFilter; }
+	virtual const FLiveLinkStaticDataState& GetStaticDataState() const { return StaticDataState; }
+
+	virtual bool IsAffectedByDagChange(const MDagPath& Child, const MDagPath& Parent) const
+	{
+		return SubtreeIndex.IsAffectedBy(Child, Parent);
+	}
+
+	virtual void RebuildSubjectData()
+	{
+		StreamSubjectStaticData(SubjectName, *FrameFilter, StaticDataState, PropBoneNames, PropBoneParents);
+	}
+
+	virtual bool CaptureFrame(FLiveLinkSubjectCapture& OutCapture)
+	{
+		if (RemovalWatcher.IsRemoved())
+		{
+			return false;
+		}
+
+		MFnTransform TransformNode(RootDagPath);
+
+		OutCapture.Source = FLiveLinkSubjectCapture::ESource::Transform;
+		OutCapture.SubjectName = SubjectName;
+		OutCapture.FrameFilter = FrameFilter;
+		OutCapture.Transform = TransformNode.transformation().asMatrix();
+		OutCapture.CurveNames.Reset();
+		return true;
+	}
+
+private:
+	FName SubjectName;
+	MDagPath RootDagPath;
+	TSharedPtr<FLiveLinkSubjectFrameFilter, ESPMode::ThreadSafe> FrameFilter;
+	FLiveLinkNodeDirtyWatcher DirtyWatcher;
+	FLiveLinkDagSubtreeIndex SubtreeIndex;
+	FLiveLinkStaticDataState StaticDataState;
+	FLiveLinkNodeRemovalWatcher RemovalWatcher;
+
+	static TArray<FName> PropBoneNames;
+	static TArray<int32> PropBoneParents;
+
+};
+
+TArray<FName> FLiveLinkStreamedPropSubject::PropBoneNames = { FName("root") };
+TArray<int32> FLiveLinkStreamedPropSubject::PropBoneParents = { -1 };
+
+/**
+* A transform hierarchy streamed as one subject, one bone per transform under the root, the way characters stream
+* their joints. Parts can be limited to visible or animated transforms; a filtered out transform's children attach
+* to the closest kept ancestor and stream their transform relative to it. Visibility and keying changes rebuild the
+* subject so the parts follow the filter.
+*/
+struct FLiveLinkStreamedPropHierarchySubject : IStreamedEntity
+{
+public:
+	enum EFilter : uint8
+	{
+		None = 0,
+		VisibleOnly = 1 << 0,
+		AnimatedOnly = 1 << 1,
+	};
+
+	FLiveLinkStreamedPropHierarchySubject(FName InSubjectName, MDagPath InRootPath, uint8 InFilter)
+		: SubjectName(InSubjectName)
+		, RootDagPath(InRootPath)
+		, Filter(InFilter)
+		, FrameFilter(new FLiveLinkSubjectFrameFilter(InSubjectName))
+		, FilterWatcher(InSubjectName, (InFilter & VisibleOnly) != 0, (InFilter & AnimatedOnly) != 0)
+	{
+		RemovalWatcher.Watch(RootDagPath.node(), SubjectName);
+	}
+
+	virtual bool ShouldDisplayInUI() const { return true; }
+	virtual MString GetDisplayText() const { return MString("Prop Hierarchy: ") + MString(*SubjectName.ToString()) + " ( " + RootDagPath.fullPathName() + " ) " + Parts.Num() + " parts"; }
+	virtual FName GetSubjectName() const { return SubjectName; }
+	virtual const FLiveLinkSubjectFrameFilter& GetFrameFilter() const { return *FrameFilter; }
+	virtual const FLiveLinkStaticDataState& GetStaticDataState() const { return StaticDataState; }
+
+	virtual bool ValidateSubject() const
+	{
+		return !RemovalWatcher.IsRemoved() && RootDagPath.isValid();
+	}
+
+	virtual bool IsAffectedByDagChange(const MDagPath& Child, const MDagPath& Parent) const
+	{
+		return SubtreeIndex.IsAffectedBy(Child, Parent);
+	}
+
+	virtual void RebuildSubjectData()
+	{
+		Parts.Reset();
+		DirtyWatcher.Reset();
+		FilterWatcher.Reset();
+		SubtreeIndex.Build(RootDagPath);
+
+		TArray<FName> PartNames;
+		TArray<int32> PartParents;
+		TSet<FName> UsedNames;
+
+		// Index of the closest kept transform at each depth
+		TArray<int32> KeptIndexStack;
+
+		MItDag DagIterator;
+		DagIterator.reset(RootDagPath, MItDag::kDepthFirst, MFn::kTransform);
+		for (; !DagIterator.isDone(); DagIterator.next())
+		{
+			MDagPath PartPath;
+			DagIterator.getPath(PartPath);
+
+			// Filtered out transforms are watched too, so they join the subject once they pass the filter
+			const bool bIsRoot = Parts.Num() == 0;
+			if (!bIsRoot)
+			{
+				FilterWatcher.Watch(PartPath.node());
+			}
+
+			if (!bIsRoot && (Filter & VisibleOnly) && !PartPath.isVisible())
+			{
+				DagIterator.prune();
+				continue;
+			}
+
+			const uint32 Depth = DagIterator.depth();
+			KeptIndexStack.SetNum(Depth + 1, false);
+			const int32 ParentKeptIndex = (Depth == 0) ? INDEX_NONE : KeptIndexStack[Depth - 1];
+
+			if (!bIsRoot && (Filter & AnimatedOnly) && !MAnimUtil::isAnimated(PartPath))
+			{
+				KeptIndexStack[Depth] = ParentKeptIndex;
+				continue;
+			}
+
+			const bool bParentIsDagParent = bIsRoot || Parts[ParentKeptIndex].Depth + 1 == Depth;
+			KeptIndexStack[Depth] = Parts.Add(FPropPart(PartPath, ParentKeptIndex, Depth, bParentIsDagParent));
+
+			// Short names aren't unique in Maya, repeats get a number
+			FName PartName(StripMayaNamespace(Parts.Last().TransformNode.name()).asChar());
+			while (UsedNames.Contains(PartName))
+			{
+				PartName.SetNumber(PartName.GetNumber() + 1);
+			}
+			UsedNames.Add(PartName);
+
+			PartNames.Add(PartName);
+			PartParents.Add(ParentKeptIndex);
+			DirtyWatcher.Watch(PartPath.node());
+		}
+
+		StreamSubjectStaticData(SubjectName, *FrameFilter, StaticDataState, PartNames, PartParents);
+	}
+
+	virtual bool CaptureFrame(FLiveLinkSubjectCapture& OutCapture)
+	{
+		if (Parts.Num() == 0 || RemovalWatcher.IsRemoved())
+		{
+			return false;
+		}
+
+		OutCapture.Source = FLiveLinkSubjectCapture::ESource::TransformHierarchy;
+		OutCapture.SubjectName = SubjectName;
+		OutCapture.FrameFilter = FrameFilter;
+		OutCapture.CurveNames.Reset();
+
+		TArray<MMatrix>& Transforms = OutCapture.Transforms;
+		Transforms.SetNumUninitialized(Parts.Num(), false);
+		for (int32 Idx = 0; Idx < Parts.Num(); ++Idx)
+		{
+			const FPropPart& Part = Parts[Idx];
+			if (Part.bParentIsDagParent)
+			{
+				Transforms[Idx] = Part.TransformNode.transformation().asMatrix();
+			}
+			else
+			{
+				Transforms[Idx] = Part.Path.inclusiveMatrix() * Parts[Part.ParentIndex].Path.inclusiveMatrixInverse();
+			}
+		}
+		return true;
+	}
+
+private:
+	struct FPropPart
+	{
+		MDagPath Path;
+		MFnTransform TransformNode;
+		int32 ParentIndex;
+		uint32 Depth;
+
+		// Otherwise transforms in between were filtered out and the local transform has to be computed
+		bool bParentIsDagParent;
+
+		FPropPart(const FPropPart& Other)
+			: Path(Other.Path)
+			, TransformNode(Other.Path)
+			, ParentIndex(Other.ParentIndex)
+			, Depth(Other.Depth)
+			, bParentIsDagParent(Other.bParentIsDagParent)
+		{}
+
+		FPropPart(const MDagPath& InPath, int32 InParentIndex, uint32 InDepth, bool bInParentIsDagParent)
+			: Path(InPath)
+			, TransformNode(InPath)
+			, ParentIndex(InParentIndex)
+			, Depth(InDepth)
+			, bParentIsDagParent(bInParentIsDagParent)
+		{}
+	};
+
+	FName SubjectName;
+	MDagPath RootDagPath;
+	uint8 Filter;
+	TSharedPtr<FLiveLinkSubjectFrameFilter, ESPMode::ThreadSafe> FrameFilter;
+	FLiveLinkNodeDirtyWatcher DirtyWatcher;
+	FLiveLinkNodeFilterWatcher FilterWatcher;
+	FLiveLinkDagSubtreeIndex SubtreeIndex;
+	FLiveLinkStaticDataState StaticDataState;
+	FLiveLinkNodeRemovalWatcher RemovalWatcher;
+
+	TArray<FPropPart> Parts;
+};
+
+/**
+* Owns the streamed subjects. Each subject is registered under its unique subject name and gets a handle that stays
+* valid until it is removed; handles are never reused. Lookups by name or handle are hashed and removal swaps the
+* last subject into the freed slot, so the stream order is not the order subjects were added in.
+*/
+class FLiveLinkStreamedSubjectManager
+{
+private:
+	struct FRegisteredSubject
+	{
+		int32 Handle;
+		TSharedPtr<IStreamedEntity> Entity;
+
+		// Refreshed whenever the subject is rebuilt, e.g. after its DAG path was renamed
+		MString DisplayText;
+	};
+
+	TArray<FRegisteredSubject> Subjects;
+	TMap<FName, int32> SubjectIndexByName;
+	TMap<int32, int32> SubjectIndexByHandle;
+	int32 NextHandle = 1;
+
+	uint64 DagChangesReceived = 0;
+	uint64 SubjectsRebuilt = 0;
+	uint64 RebuildsAvoided = 0;
+	uint64 RebuildsCoalesced = 0;
+	uint64 QueueDrains = 0;
+	uint64 UIRefreshes = 0;
+
+	// Handles of subjects waiting for a rebuild, drained from an idle callback that only exists while this isn't empty
+	TSet<int32> PendingRebuilds;
+	MCallbackId IdleCallbackId;
+	bool bHasIdleCallback = false;
+
+	static void OnIdle(void* ClientData)
+	{
+		static_cast<FLiveLinkStreamedSubjectManager*>(ClientData)->DrainRebuildQueue();
+	}
+
+	void ScheduleDrain()
+	{
+		if (PendingRebuilds.Num() > 0 && !bHasIdleCallback)
+		{
+			MStatus Status;
+			IdleCallbackId = MEventMessage::addEventCallback("idle", OnIdle, this, &Status);
+			bHasIdleCallback = (Status == MS::kSuccess);
+		}
+	}
+
+	void ValidateSubjects()
+	{
+		LiveLinkStats::FScope Scope(LiveLinkStats::EStat::ValidateSubjects);
+
+		for (int32 Index = Subjects.Num() - 1; Index >= 0; --Index)
+		{
+			if (!Subjects[Index].Entity->ValidateSubject())
+			{
+				RemoveSubjectAt(Index);
+			}
+		}
+		RefreshUI();
+	}
+
+	void RemoveSubjectAt(int32 Index)
+	{
+		EndpointHub.ForgetSubject(Subjects[Index].Entity->GetSubjectName());
+		SubjectIndexByName.Remove(Subjects[Index].Entity->GetSubjectName());
+		SubjectIndexByHandle.Remove(Subjects[Index].Handle);
+
+		Subjects.RemoveAtSwap(Index);
+		if (Index < Subjects.Num())
+		{
+			SubjectIndexByName.Add(Subjects[Index].Entity->GetSubjectName(), Index);
+			SubjectIndexByHandle.Add(Subjects[Index].Handle, Index);
+		}
+	}
+
+public:
+
+	FLiveLinkStreamedSubjectManager()
+	{
+		Reset();
+	}
+
+	~FLiveLinkStreamedSubjectManager()
+	{
+		CancelPendingRebuilds();
+	}
+
+	void GetSubjectEntries(TArray<MString>& Entries) const
+	{
+		for (const FRegisteredSubject& Subject : Subjects)
+		{
+			if (Subject.Entity->ShouldDisplayInUI())
+			{
+				Entries.Add(Subject.DisplayText);
+			}
+		}
+	}
+
+	/** Names and handles of the subjects GetSubjectEntries lists, in the same order */
+	void GetSubjectNamesAndHandles(TArray<FName>& OutNames, TArray<int32>& OutHandles) const
+	{
+		for (const FRegisteredSubject& Subject : Subjects)
+		{
+			if (Subject.Entity->ShouldDisplayInUI())
+			{
+				OutNames.Add(Subject.Entity->GetSubjectName());
+				OutHandles.Add(Subject.Handle);
+			}
+		}
+	}
+
+	void GetFrameFilterCounters(TArray<MString>& Entries) const
+	{
+		for (const FRegisteredSubject& Subject : Subjects)
+		{
+			const FLiveLinkSubjectFrameFilter& FrameFilter = Subject.Entity->GetFrameFilter();
+			Entries.Add(MString(*FString::Printf(TEXT("%s sent: %llu suppressed: %llu"), *Subject.Entity->GetSubjectName().ToString(), FrameFilter.GetFramesSent(), FrameFilter.GetFramesSuppressed())));
+		}
+	}
+
+	int32 FindSubjectHandle(FName SubjectName) const
+	{
+		const int32* Index = SubjectIndexByName.Find(SubjectName);
+		return Index ? Subjects[*Index].Handle : INDEX_NONE;
+	}
+
+	const IStreamedEntity* FindSubject(FName SubjectName) const
+	{
+		const int32* Index = SubjectIndexByName.Find(SubjectName);
+		return Index ? Subjects[*Index].Entity.Get() : nullptr;
+	}
+
+	/** Returns the new subject's handle, or INDEX_NONE if a subject with the same name already exists */
+	template<class SubjectType, typename... ArgsType>
+	int32 AddSubjectOfType(ArgsType&&... Args)
+	{
+		TSharedPtr<SubjectType> Entity = MakeShareable(new SubjectType(Args...));
+		const FName SubjectName = Entity->GetSubjectName();
+		if (SubjectIndexByName.Contains(SubjectName))
+		{
+			return INDEX_NONE;
+		}
+
+		const int32 Index = Subjects.AddDefaulted();
+		FRegisteredSubject& Subject = Subjects[Index];
+		Subject.Handle = NextHandle++;
+		Subject.Entity = Entity;
+		SubjectIndexByName.Add(SubjectName, Index);
+		SubjectIndexByHandle.Add(Subject.Handle, Index);
+
+		RebuildSubject(Subject);
+
+		int32 FrameNumber = MAnimControl::currentTime().value();
+		FLiveLinkStreamSnapshot& Snapshot = StreamPipeline.BeginSnapshot(FPlatformTime::Seconds(), FrameNumber);
+		CaptureSubject(*Entity, Snapshot);
+		StreamPipeline.SubmitSnapshot();
+
+		MarkSceneDirty();
+		return Subject.Handle;
+	}
+
+	int32 AddJointHeirarchySubject(FName SubjectName, MDagPath RootPath)
+	{
+		return AddSubjectOfType<FLiveLinkStreamedJointHeirarchySubject>(SubjectName, RootPath);
+	}
+
+	int32 AddCameraSubject(FName SubjectName, MDagPath RootPath)
+	{
+		return AddSubjectOfType<FLiveLinkStreamedCameraSubject>(SubjectName, RootPath);
+	}
+
+	int32 AddPropSubject(FName SubjectName, MDagPath RootPath)
+	{
+		return AddSubjectOfType<FLiveLinkStreamedPropSubject>(SubjectName, RootPath);
+	}
+
+	int32 AddPropHierarchySubject(FName SubjectName, MDagPath RootPath, uint8 Filter)
+	{
+		return AddSubjectOfType<FLiveLinkStreamedPropHierarchySubject>(SubjectName, RootPath, Filter);
+	}
+
+	/**
+	* Picks the subject type from the node at Path, returns INDEX_NONE for unsupported nodes and duplicate names.
+	* Transforms become prop hierarchies when bPropHierarchy is set, using the FLiveLinkStreamedPropHierarchySubject filter flags.
+	*/
+	int32 AddSubjectForPath(FName SubjectName, const MDagPath& Path, bool bPropHierarchy = false, uint8 PropHierarchyFilter = 0)
+	{
+		const MObject Node = Path.node();
+		if (Node.hasFn(MFn::kJoint))
+		{
+			return AddJointHeirarchySubject(SubjectName, Path);
+		}
+		else if (Node.hasFn(MFn::kCamera))
+		{
+			return AddCameraSubject(SubjectName, Path);
+		}
+		else if (Node.hasFn(MFn::kTransform))
+		{
+			return bPropHierarchy ? AddPropHierarchySubject(SubjectName, Path, PropHierarchyFilter) : AddPropSubject(SubjectName, Path);
+		}
+		return INDEX_NONE;
+	}
+
+	bool RemoveSubjectByName(FName SubjectName)
+	{
+		const int32* Index = SubjectIndexByName.Find(SubjectName);
+		if (!Index || !Subjects[*Index].Entity->ShouldDisplayInUI())
+		{
+			return false;
+		}
+
+		RemoveSubjectAt(*Index);
+		MarkSceneDirty();
+		return true;
+	}
+
+	bool RemoveSubjectByHandle(int32 Handle)
+	{
+		const int32* Index = SubjectIndexByHandle.Find(Handle);
+		if (!Index || !Subjects[*Index].Entity->ShouldDisplayInUI())
+		{
+			return false;
+		}
+
+		RemoveSubjectAt(*Index);
+		MarkSceneDirty();
+		return true;
+	}
+
+	/** Accepts a subject name, or the display text older scripts pass in */
+	bool RemoveSubject(const MString& SubjectToRemove)
+	{
+		if (RemoveSubjectByName(FName(SubjectToRemove.asChar())))
+		{
+			return true;
+		}
+
+		for (int32 Index = 0; Index < Subjects.Num(); ++Index)
+		{
+			if (Subjects[Index].Entity->ShouldDisplayInUI() && Subjects[Index].DisplayText == SubjectToRemove)
+			{
+				RemoveSubjectAt(Index);
+				MarkSceneDirty();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Reset()
+	{
+		PendingRebuilds.Reset();
+		for (const FRegisteredSubject& Subject : Subjects)
+		{
+			EndpointHub.ForgetSubject(Subject.Entity->GetSubjectName());
+		}
+		Subjects.Reset();
+		SubjectIndexByName.Reset();
+		SubjectIndexByHandle.Reset();
+		AddSubjectOfType<FLiveLinkStreamedActiveCamera>();
+	}
+
+	void RebuildSubjects()
+	{
+		ValidateSubjects();
+		for (FRegisteredSubject& Subject : Subjects)
+		{
+			RebuildSubject(Subject);
+		}
+		MarkSceneDirty();
+	}
+
+	/** Writes the static data every subject last sent into the take, without sending anything to the provider */
+	void RecordStaticData(FLiveLinkTakeRecorder& Recorder) const
+	{
+		for (const FRegisteredSubject& Subject : Subjects)
+		{
+			const FLiveLinkStaticDataState& State = Subject.Entity->GetStaticDataState();
+			if (State.HasSent())
+			{
+				Recorder.RecordSubject(Subject.Entity->GetSubjectName(), State.BoneNames, State.BoneParents);
+			}
+		}
+	}
+
+	/**
+	* Queues the subjects whose DAG subtree contains the changed child or parent. Imports and rigging scripts send
+	* thousands of DAG messages, so the rebuilds are deduplicated and run once at the next idle or stream pass.
+	*/
+	void QueueRebuildsAffectedBy(const MDagPath& Child, const MDagPath& Parent)
+	{
+		++DagChangesReceived;
+
+		int32 NumAffected = 0;
+		for (const FRegisteredSubject& Subject : Subjects)
+		{
+			if (!Subject.Entity->IsAffectedByDagChange(Child, Parent))
+			{
+				continue;
+			}
+
+			++NumAffected;
+			bool bAlreadyQueued = false;
+			PendingRebuilds.Add(Subject.Handle, &bAlreadyQueued);
+			RebuildsCoalesced += bAlreadyQueued ? 1 : 0;
+		}
+		RebuildsAvoided += Subjects.Num() - NumAffected;
+
+		ScheduleDrain();
+	}
+
+	/** Queues a single subject, e.g. when its root node is being deleted */
+	void QueueRebuild(FName SubjectName)
+	{
+		if (const int32* Index = SubjectIndexByName.Find(SubjectName))
+		{
+			PendingRebuilds.Add(Subjects[*Index].Handle);
+			ScheduleDrain();
+		}
+	}
+
+	void CancelPendingRebuilds()
+	{
+		if (bHasIdleCallback)
+		{
+			MMessage::removeCallback(IdleCallbackId);
+			bHasIdleCallback = false;
+		}
+		PendingRebuilds.Reset();
+	}
+
+	/** Validates and rebuilds the queued subjects, then refreshes the UI once */
+	void DrainRebuildQueue()
+	{
+		if (bHasIdleCallback)
+		{
+			MMessage::removeCallback(IdleCallbackId);
+			bHasIdleCallback = false;
+		}
+
+		if (PendingRebuilds.Num() == 0)
+		{
+			return;
+		}
+
+		++QueueDrains;
+		for (const int32 Handle : PendingRebuilds)
+		{
+			const int32* Index = SubjectIndexByHandle.Find(Handle);
+			if (!Index)
+			{
+				continue;
+			}
+
+			++SubjectsRebuilt;
+			if (Subjects[*Index].Entity->ValidateSubject())
+			{
+				RebuildSubject(Subjects[*Index]);
+			}
+			else
+			{
+				RemoveSubjectAt(*Index);
+			}
+		}
+		PendingRebuilds.Reset();
+
+		MarkSceneDirty();
+		RefreshUI();
+		++UIRefreshes;
+	}
+
+	uint64 GetDagChangesReceived() const { return DagChangesReceived; }
+	uint64 GetSubjectsRebuilt() const { return SubjectsRebuilt; }
+	uint64 GetRebuildsAvoided() const { return RebuildsAvoided; }
+	uint64 GetRebuildsCoalesced() const { return RebuildsCoalesced; }
+	uint64 GetQueueDrains() const { return QueueDrains; }
+	uint64 GetUIRefreshes() const { return UIRefreshes; }
+
+	void ResetRebuildCounters()
+	{
+		DagChangesReceived = 0;
+		SubjectsRebuilt = 0;
+		RebuildsAvoided = 0;
+		RebuildsCoalesced = 0;
+		QueueDrains = 0;
+		UIRefreshes = 0;
+	}
+
+	void StreamSubjects()
+	{
+		double StreamTime = FPlatformTime::Seconds();
+		int32 FrameNumber = MAnimControl::currentTime().value();
+
+		StreamSubjects(StreamTime, FrameNumber);
+	}
+
+	void StreamSubjects(double StreamTime, int32 FrameNumber, bool bAllowDrop = true, bool bForceKeyframe = false)
+	{
+		// Streaming before idle still sees the current hierarchy
+		DrainRebuildQueue();
+
+		LiveLinkStats::FScope Scope(LiveLinkStats::EStat::StreamSubjects);
+		LiveLinkAllocations::FStreamPathScope StreamPath;
+
+		FLiveLinkStreamSnapshot& Snapshot = StreamPipeline.BeginSnapshot(StreamTime, FrameNumber);
+		Snapshot.bForceKeyframe = bForceKeyframe;
+		Snapshot.bAllowDrop = bAllowDrop;
+		for (const FRegisteredSubject& Subject : Subjects)
+		{
+			CaptureSubject(*Subject.Entity, Snapshot);
+		}
+		StreamPipeline.SubmitSnapshot(bAllowDrop);
+	}
+
+private:
+	static void RebuildSubject(FRegisteredSubject& Subject)
+	{
+		LiveLinkStats::FScope Scope(LiveLinkStats::EStat::RebuildSubjectData);
+		Subject.Entity->RebuildSubjectData();
+		Subject.DisplayText = Subject.Entity->GetDisplayText();
+	}
+
+	static void CaptureSubject(IStreamedEntity& Subject, FLiveLinkStreamSnapshot& Snapshot)
+	{
+		LiveLinkStats::FScope Scope(LiveLinkStats::EStat::CaptureFrame);
+
+		if (!Subject.CaptureFrame(Snapshot.AddCapture()))
+		{
+			Snapshot.RemoveLastCapture();
+		}
+	}
+};
+
+void QueueSubjectRevalidation(FName SubjectName)
+{
+	if (LiveLinkStreamManager.IsValid())
+	{
+		LiveLinkStreamManager->QueueRebuild(SubjectName);
+	}
+}
+
+/**
+* Collapses every stream trigger (viewport post render, force update, option changes) that happens for the same
+* evaluated scene state into a single StreamSubjects pass. The scene state is keyed on Maya time plus SceneDirtyGeneration.
+*/
+class FLiveLinkStreamScheduler
+{
+public:
+	FLiveLinkStreamScheduler()
+	{
+		Reset();
+	}
+
+	void RequestStream()
+	{
+		if (bSuspended || bReplaying)
+		{
+			return;
+		}
+
+		++Triggers;
+
+		const MTime CurrentTime = MAnimControl::currentTime();
+		if (bHasStreamed && CurrentTime == LastStreamedTime && SceneDirtyGeneration == LastStreamedGeneration)
+		{
+			++CollapsedTriggers;
+			return;
+		}
+
+		LastStreamedTime = CurrentTime;
+		LastStreamedGeneration = SceneDirtyGeneration;
+		bHasStreamed = true;
+		++StreamPasses;
+
+		LiveLinkStreamManager->StreamSubjects();
+	}
+
+	void Reset()
+	{
+		bHasStreamed = false;
+		LastStreamedGeneration = 0;
+		Triggers = 0;
+		StreamPasses = 0;
+		CollapsedTriggers = 0;
+	}
+
+	uint64 GetTriggers() const { return Triggers; }
+	uint64 GetStreamPasses() const { return StreamPasses; }
+	uint64 GetCollapsedTriggers() const { return CollapsedTriggers; }
+
+	// Used while something else drives streaming, e.g. baking a range, so time change callbacks don't stream too
+	void SetSuspended(bool bInSuspended) { bSuspended = bInSuspended; }
+	bool IsSuspended() const { return bSuspended; }
+
+	// Set by a take replay's thread for as long as it streams instead of the scene
+	void SetReplaying(bool bInReplaying) { bReplaying = bInReplaying; }
+
+private:
+	bool bSuspended = false;
+	std::atomic<bool> bReplaying { false };
+
+	MTime LastStreamedTime;
+	uint64 LastStreamedGeneration;
+	bool bHasStreamed;
+
+	uint64 Triggers;
+	uint64 StreamPasses;
+	uint64 CollapsedTriggers;
+};
+
+FLiveLinkStreamScheduler StreamScheduler;
+
+/**
+* Streams at a fixed target rate from its own Maya timer instead of following viewport redraws. The rate actually
+* used adapts to the cost of a stream pass on the main thread: when passes take more than BudgetFraction of the time
+* between them the rate drops to what the budget allows, and it ramps back up to the target once passes get cheaper.
+* Without a connection it idles at DisconnectedRate.
+*/
+class FLiveLinkStreamClock
+{
+public:
+	FLiveLinkStreamClock()
+		: TargetRate(0.0)
+		, EffectiveRate(0.0)
+		, MinRate(5.0)
+		, DisconnectedRate(1.0)
+		, BudgetFraction(0.25)
+		, TimerCallbackId(0)
+		, bHasTimer(false)
+		, NextStreamTime(0.0)
+		, AveragePassSeconds(0.0)
+		, WindowStartTime(0.0)
+		, WindowStartPasses(0)
+		, AchievedRate(0.0)
+	{}
+
+	/** 0 goes back to streaming on viewport redraws */
+	void SetTargetRate(double InTargetRate)
+	{
+		Stop();
+
+		TargetRate = FMath::Max(InTargetRate, 0.0);
+		EffectiveRate = TargetRate;
+		AveragePassSeconds = 0.0;
+		NextStreamTime = 0.0;
+
+		if (TargetRate > 0.0)
+		{
+			MStatus Status;
+			TimerCallbackId = MTimerMessage::addTimerCallback(1.f / (float)TargetRate, (MMessage::MElapsedTimeFunction)OnTimer, this, &Status);
+			bHasTimer = (Status == MS::kSuccess);
+		}
+	}
+
+	void SetMinRate(double InMinRate) { MinRate = FMath::Max(InMinRate, 0.1); }
+	void SetBudgetFraction(double InBudgetFraction) { BudgetFraction = FMath::Clamp(InBudgetFraction, 0.01, 1.0); }
+
+	void Stop()
+	{
+		if (bHasTimer)
+		{
+			MMessage::removeCallback(TimerCallbackId);
+			bHasTimer = false;
+		}
+	}
+
+	bool IsActive() const { return bHasTimer; }
+	double GetTargetRate() const { return TargetRate; }
+	double GetEffectiveRate() const { return IsActive() ? EffectiveRate : 0.0; }
+	double GetMinRate() const { return MinRate; }
+	double GetBudgetFraction() const { return BudgetFraction; }
+
+	/** Stream passes per second over the last second or so, whatever triggered them */
+	double GetAchievedRate()
+	{
+		UpdateAchievedRate(FPlatformTime::Seconds());
+		return AchievedRate;
+	}
+
+private:
+	static void OnTimer(float ElapsedTime, float LastTime, void* ClientData)
+	{
+		static_cast<FLiveLinkStreamClock*>(ClientData)->Tick();
+	}
+
+	void Tick()
+	{
+		const double Now = FPlatformTime::Seconds();
+		UpdateAchievedRate(Now);
+
+		if (Now < NextStreamTime)
+		{
+			return;
+		}
+
+		StreamScheduler.RequestStream();
+		const double PassSeconds = FPlatformTime::Seconds() - Now;
+
+		AveragePassSeconds = (AveragePassSeconds > 0.0) ? FMath::Lerp(AveragePassSeconds, PassSeconds, 0.2) : PassSeconds;
+		Adapt(LiveLinkProvider.IsValid() && LiveLinkProvider->HasConnection());
+
+		// Half a timer period of slack so timer jitter doesn't skip every other tick at the target rate
+		NextStreamTime = Now + 1.0 / EffectiveRate - 0.5 / TargetRate;
+	}
+
+	void Adapt(bool bConnected)
+	{
+		if (!bConnected)
+		{
+			EffectiveRate = FMath::Min(TargetRate, DisconnectedRate);
+			return;
+		}
+
+		const double SustainableRate = BudgetFraction / FMath::Max(AveragePassSeconds, 1e-6);
+		if (SustainableRate < EffectiveRate)
+		{
+			EffectiveRate = FMath::Max(SustainableRate, FMath::Min(MinRate, TargetRate));
+		}
+		else
+		{
+			EffectiveRate = FMath::Min3(TargetRate, SustainableRate, EffectiveRate * 1.1 + 1.0);
+		}
+	}
+
+	void UpdateAchievedRate(double Now)
+	{
+		const uint64 StreamPasses = StreamScheduler.GetStreamPasses();
+		if (StreamPasses < WindowStartPasses || WindowStartTime == 0.0)
+		{
+			WindowStartTime = Now;
+			WindowStartPasses = StreamPasses;
+		}
+		else if (Now - WindowStartTime >= 1.0)
+		{
+			AchievedRate = (StreamPasses - WindowStartPasses) / (Now - WindowStartTime);
+			WindowStartTime = Now;
+			WindowStartPasses = StreamPasses;
+		}
+	}
+
+	double TargetRate;
+	double EffectiveRate;
+	double MinRate;
+	double DisconnectedRate;
+	double BudgetFraction;
+
+	MCallbackId TimerCallbackId;
+	bool bHasTimer;
+
+	double NextStreamTime;
+	double AveragePassSeconds;
+
+	double WindowStartTime;
+	uint64 WindowStartPasses;
+	double AchievedRate;
+};
+
+FLiveLinkStreamClock StreamClock;
+
+const MString LiveLinkSubjectsCommandName("LiveLinkSubjects");
+
+class LiveLinkSubjectsCommand : public MPxCommand
+{
+public:
+	static void		cleanup() {}
+	static void*	creator() { return new LiveLinkSubjectsCommand(); }
+
+	MStatus			doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addFlag("-n", "-names");
+		Syntax.addFlag("-h", "-handles");
+
+		MArgDatabase argData(Syntax, args);
+
+		if (argData.isFlagSet("-n") || argData.isFlagSet("-h"))
+		{
+			TArray<FName> SubjectNames;
+			TArray<int32> SubjectHandles;
+			LiveLinkStreamManager->GetSubjectNamesAndHandles(SubjectNames, SubjectHandles);
+
+			for (int32 Idx = 0; Idx < SubjectNames.Num(); ++Idx)
+			{
+				if (argData.isFlagSet("-n"))
+				{
+					appendToResult(MString(*SubjectNames[Idx].ToString()));
+				}
+				else
+				{
+					appendToResult(SubjectHandles[Idx]);
+				}
+			}
+			return MS::kSuccess;
+		}
+
+		TArray<MString> SubjectEntries;
+		LiveLinkStreamManager->GetSubjectEntries(SubjectEntries);
+
+		for (const MString& Entry : SubjectEntries)
+		{
+			appendToResult(Entry);
+		}
+
+		return MS::kSuccess;
+	}
+};
+
+/** -propHierarchy, -visibleOnly and -animatedOnly, shared by the add subject commands */
+void AddPropHierarchyFlags(MSyntax& Syntax)
+{
+	Syntax.addFlag("-ph", "-propHierarchy");
+	Syntax.addFlag("-vo", "-visibleOnly");
+	Syntax.addFlag("-ao", "-animatedOnly");
+}
+
+uint8 GetPropHierarchyFilter(const MArgDatabase& ArgData)
+{
+	uint8 Filter = FLiveLinkStreamedPropHierarchySubject::None;
+	Filter |= ArgData.isFlagSet("-vo") ? FLiveLinkStreamedPropHierarchySubject::VisibleOnly : 0;
+	Filter |= ArgData.isFlagSet("-ao") ? FLiveLinkStreamedPropHierarchySubject::AnimatedOnly : 0;
+	return Filter;
+}
+
+const MString LiveLinkAddSubjectCommandName("LiveLinkAddSubject");
+
+class LiveLinkAddSubjectCommand : public MPxCommand
+{
+public:
+	static void		cleanup() {}
+	static void*	creator() { return new LiveLinkAddSubjectCommand(); }
+
+	MStatus			doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addArg(MSyntax::kString);
+		AddPropHierarchyFlags(Syntax);
+
+		MArgDatabase argData(Syntax, args);
+
+		MString Name;
+		argData.getCommandArgument(0, Name);
+
+		FName SubjectFName(Name.asChar());
+
+		MSelectionList selected;
+		MGlobal::getActiveSelectionList(selected);
+
+		if (LiveLinkStreamManager->FindSubjectHandle(SubjectFName) != INDEX_NONE)
+		{
+			MGlobal::displayError(MString("LiveLinkAddSubject: a subject named ") + Name + " already exists");
+			return MS::kInvalidParameter;
+		}
+
+		// The first selected node that can be streamed becomes the subject
+		for (unsigned int i = 0; i < selected.length(); ++i)
+		{
+			MDagPath Path;
+			if (selected.getDagPath(i, Path) != MS::kSuccess)
+			{
+				continue;
+			}
+
+			const int32 Handle = LiveLinkStreamManager->AddSubjectForPath(SubjectFName, Path, argData.isFlagSet("-ph"), GetPropHierarchyFilter(argData));
+			if (Handle != INDEX_NONE)
+			{
+				MGlobal::displayInfo(MString("LiveLinkAddSubjectCommand ") + Name);
+				setResult(Handle);
+				return MS::kSuccess;
+			}
+		}
+
+		MGlobal::displayWarning(MString("LiveLinkAddSubject: nothing selected that can be streamed as ") + Name);
+		setResult(INDEX_NONE);
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkRemoveSubjectCommandName("LiveLinkRemoveSubject");
+
+class LiveLinkRemoveSubjectCommand : public MPxCommand
+{
+public:
+	static void		cleanup() {}
+	static void*	creator() { return new LiveLinkRemoveSubjectCommand(); }
+
+	MStatus			doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addArg(MSyntax::kString);
+
+		MArgDatabase argData(Syntax, args);
+
+		MString SubjectToRemove;
+		argData.getCommandArgument(0, SubjectToRemove);
+
+		if (!LiveLinkStreamManager->RemoveSubject(SubjectToRemove))
+		{
+			MGlobal::displayWarning(MString("LiveLinkRemoveSubject: no subject ") + SubjectToRemove);
+		}
+
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkAddSubjectsCommandName("LiveLinkAddSubjects");
+
+/** Adds one subject per -name/-path pair, or per -name and selected node in order when no paths are given */
+class LiveLinkAddSubjectsCommand : public MPxCommand
+{
+public:
+	static void		cleanup() {}
+	static void*	creator() { return new LiveLinkAddSubjectsCommand(); }
+
+	MStatus			doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addFlag("-n", "-name", MSyntax::kString);
+		Syntax.addFlag("-p", "-path", MSyntax::kString);
+		Syntax.makeFlagMultiUse("-n");
+		Syntax.makeFlagMultiUse("-p");
+		AddPropHierarchyFlags(Syntax);
+
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkAddSubjects: invalid arguments");
+
+		const unsigned int NumNames = argData.numberOfFlagUses("-n");
+		const unsigned int NumPaths = argData.numberOfFlagUses("-p");
+		if (NumPaths > 0 && NumPaths != NumNames)
+		{
+			MGlobal::displayError("LiveLinkAddSubjects: -path must be given once per -name");
+			return MS::kInvalidParameter;
+		}
+
+		MSelectionList Nodes;
+		if (NumPaths > 0)
+		{
+			for (unsigned int Idx = 0; Idx < NumPaths; ++Idx)
+			{
+				MArgList FlagArgs;
+				MString PathName;
+				argData.getFlagArgumentList("-p", Idx, FlagArgs);
+				FlagArgs.get(0, PathName);
+				if (Nodes.add(PathName) != MS::kSuccess)
+				{
+					MGlobal::displayError(MString("LiveLinkAddSubjects: no node ") + PathName);
+					return MS::kInvalidParameter;
+				}
+			}
+		}
+		else
+		{
+			MGlobal::getActiveSelectionList(Nodes);
+		}
+
+		// Handles in -name order, -1 where the name was taken or the node can't be streamed
+		int32 NumAdded = 0;
+		for (unsigned int Idx = 0; Idx < NumNames; ++Idx)
+		{
+			MArgList FlagArgs;
+			MString Name;
+			argData.getFlagArgumentList("-n", Idx, FlagArgs);
+			FlagArgs.get(0, Name);
+
+			int32 Handle = INDEX_NONE;
+			MDagPath Path;
+			if (Idx < Nodes.length() && Nodes.getDagPath(Idx, Path) == MS::kSuccess)
+			{
+				Handle = LiveLinkStreamManager->AddSubjectForPath(FName(Name.asChar()), Path, argData.isFlagSet("-ph"), GetPropHierarchyFilter(argData));
+			}
+
+			if (Handle == INDEX_NONE)
+			{
+				MGlobal::displayWarning(MString("LiveLinkAddSubjects: unable to add ") + Name);
+			}
+			else
+			{
+				++NumAdded;
+			}
+			appendToResult(Handle);
+		}
+
+		if (NumAdded > 0)
+		{
+			RefreshUI();
+		}
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkRemoveSubjectsCommandName("LiveLinkRemoveSubjects");
+
+class LiveLinkRemoveSubjectsCommand : public MPxCommand
+{
+public:
+	static void		cleanup() {}
+	static void*	creator() { return new LiveLinkRemoveSubjectsCommand(); }
+
+	MStatus			doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addFlag("-n", "-name", MSyntax::kString);
+		Syntax.addFlag("-h", "-handle", MSyntax::kLong);
+		Syntax.makeFlagMultiUse("-n");
+		Syntax.makeFlagMultiUse("-h");
+
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkRemoveSubjects: invalid arguments");
+
+		int32 NumRemoved = 0;
+		for (unsigned int Idx = 0; Idx < argData.numberOfFlagUses("-n"); ++Idx)
+		{
+			MArgList FlagArgs;
+			MString Name;
+			argData.getFlagArgumentList("-n", Idx, FlagArgs);
+			FlagArgs.get(0, Name);
+			NumRemoved += LiveLinkStreamManager->RemoveSubjectByName(FName(Name.asChar())) ? 1 : 0;
+		}
+		for (unsigned int Idx = 0; Idx < argData.numberOfFlagUses("-h"); ++Idx)
+		{
+			MArgList FlagArgs;
+			int Handle = INDEX_NONE;
+			argData.getFlagArgumentList("-h", Idx, FlagArgs);
+			FlagArgs.get(0, Handle);
+			NumRemoved += LiveLinkStreamManager->RemoveSubjectByHandle(Handle) ? 1 : 0;
+		}
+
+		if (NumRemoved > 0)
+		{
+			RefreshUI();
+		}
+		setResult(NumRemoved);
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkConnectionStatusCommandName("LiveLinkConnectionStatus");
+
+class LiveLinkConnectionStatusCommand : public MPxCommand
+{
+public:
+	static void		cleanup() {}
+	static void*	creator() { return new LiveLinkConnectionStatusCommand(); }
+
+	MStatus			doIt(const MArgList& args)
+	{
+		MString ConnectionStatus("No Provider (internal error)");
+		bool bConnection = false;
+
+		if(LiveLinkProvider.IsValid())
+		{
+			if (LiveLinkProvider->HasConnection())
+			{
+				ConnectionStatus = "Connected";
+				bConnection = true;
+			}
+			else
+			{
+				ConnectionStatus = "No Connection";
+			}
+		}
+
+		appendToResult(ConnectionStatus);
+		appendToResult(bConnection);
+
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkSetOptionCorrectForYUpCommandName("LiveLinkSetOptionCorrectForYUp");
+
+class LiveLinkSetOptionCorrectForYUpCommand : public MPxCommand
+{
+public:
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkSetOptionCorrectForYUpCommand(); }
+
+	MStatus	doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addArg(MSyntax::kString);
+
+		MArgDatabase argData(Syntax, args);
+
+		argData.getCommandArgument(0, bCorrectForYUp);
+		MGlobal::displayInfo(MString("bCorrectForYUp: ") + bCorrectForYUp);
+
+		LiveLinkStreamManager->RebuildSubjects();
+		StreamScheduler.RequestStream();
+
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkSetOptionDeltaStreamingCommandName("LiveLinkSetOptionDeltaStreaming");
+
+class LiveLinkSetOptionDeltaStreamingCommand : public MPxCommand
+{
+public:
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkSetOptionDeltaStreamingCommand(); }
+
+	MStatus	doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addFlag("-e", "-enable", MSyntax::kBoolean);
+		Syntax.addFlag("-pt", "-positionTolerance", MSyntax::kDouble);
+		Syntax.addFlag("-rt", "-rotationTolerance", MSyntax::kDouble);
+		Syntax.addFlag("-st", "-scaleTolerance", MSyntax::kDouble);
+		Syntax.addFlag("-ct", "-curveTolerance", MSyntax::kDouble);
+		Syntax.addFlag("-ki", "-keyframeInterval", MSyntax::kDouble);
+		Syntax.addFlag("-c", "-counters");
+
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkSetOptionDeltaStreaming: invalid arguments");
+
+		double Value;
+		if (argData.isFlagSet("-e"))
+		{
+			argData.getFlagArgument("-e", 0, DeltaStreamSettings.bEnabled);
+		}
+		if (argData.isFlagSet("-pt") && argData.getFlagArgument("-pt", 0, Value) == MS::kSuccess)
+		{
+			DeltaStreamSettings.PositionTolerance = (float)Value;
+		}
+		if (argData.isFlagSet("-rt") && argData.getFlagArgument("-rt", 0, Value) == MS::kSuccess)
+		{
+			DeltaStreamSettings.RotationTolerance = (float)Value;
+		}
+		if (argData.isFlagSet("-st") && argData.getFlagArgument("-st", 0, Value) == MS::kSuccess)
+		{
+			DeltaStreamSettings.ScaleTolerance = (float)Value;
+		}
+		if (argData.isFlagSet("-ct") && argData.getFlagArgument("-ct", 0, Value) == MS::kSuccess)
+		{
+			DeltaStreamSettings.CurveTolerance = (float)Value;
+		}
+		if (argData.isFlagSet("-ki") && argData.getFlagArgument("-ki", 0, Value) == MS::kSuccess)
+		{
+			DeltaStreamSettings.KeyframeInterval = Value;
+		}
+
+		if (argData.isFlagSet("-c"))
+		{
+			TArray<MString> Counters;
+			LiveLinkStreamManager->GetFrameFilterCounters(Counters);
+
+			for (const MString& Entry : Counters)
+			{
+				appendToResult(Entry);
+			}
+		}
+		else
+		{
+			MGlobal::displayInfo(MString("DeltaStreaming: ") + DeltaStreamSettings.bEnabled);
+		}
+
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkStreamSchedulerCountersCommandName("LiveLinkStreamSchedulerCounters");
+
+class LiveLinkStreamSchedulerCountersCommand : public MPxCommand
+{
+public:
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkStreamSchedulerCountersCommand(); }
+
+	MStatus	doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addFlag("-r", "-reset");
+
+		MArgDatabase argData(Syntax, args);
+
+		// Triggers received, stream passes executed and triggers collapsed into an earlier pass
+		appendToResult((int)StreamScheduler.GetTriggers());
+		appendToResult((int)StreamScheduler.GetStreamPasses());
+		appendToResult((int)StreamScheduler.GetCollapsedTriggers());
+
+		if (argData.isFlagSet("-r"))
+		{
+			StreamScheduler.Reset();
+		}
+
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkRebuildCountersCommandName("LiveLinkRebuildCounters");
+
+class LiveLinkRebuildCountersCommand : public MPxCommand
+{
+public:
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkRebuildCountersCommand(); }
+
+	MStatus	doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addFlag("-r", "-reset");
+
+		MArgDatabase argData(Syntax, args);
+
+		// DAG changes received, subjects rebuilt and subject rebuilds avoided by scoped invalidation, then static
+		// updates sent and static resends suppressed because the hierarchy was unchanged, then rebuilds coalesced
+		// into an already queued one, rebuild queue drains and UI refreshes
+		appendToResult((int)LiveLinkStreamManager->GetDagChangesReceived());
+		appendToResult((int)LiveLinkStreamManager->GetSubjectsRebuilt());
+		appendToResult((int)LiveLinkStreamManager->GetRebuildsAvoided());
+		appendToResult((int)StaticUpdatesSent);
+		appendToResult((int)StaticUpdatesSuppressed);
+		appendToResult((int)LiveLinkStreamManager->GetRebuildsCoalesced());
+		appendToResult((int)LiveLinkStreamManager->GetQueueDrains());
+		appendToResult((int)LiveLinkStreamManager->GetUIRefreshes());
+
+		if (argData.isFlagSet("-r"))
+		{
+			LiveLinkStreamManager->ResetRebuildCounters();
+			StaticUpdatesSent = 0;
+			StaticUpdatesSuppressed = 0;
+		}
+
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkResyncSubjectsCommandName("LiveLinkResyncSubjects");
+
+/** Sends the static data of every subject again, e.g. after the editor lost its subjects */
+class LiveLinkResyncSubjectsCommand : public MPxCommand
+{
+public:
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkResyncSubjectsCommand(); }
+
+	MStatus	doIt(const MArgList& args)
+	{
+		++StaticDataResyncGeneration;
+		LiveLinkStreamManager->RebuildSubjects();
+		StreamScheduler.RequestStream();
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkSetOptionAsyncStreamingCommandName("LiveLinkSetOptionAsyncStreaming");
+
+class LiveLinkSetOptionAsyncStreamingCommand : public MPxCommand
+{
+public:
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkSetOptionAsyncStreamingCommand(); }
+
+	MStatus	doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addFlag("-e", "-enable", MSyntax::kBoolean);
+		Syntax.addFlag("-d", "-depth", MSyntax::kLong);
+		Syntax.addFlag("-s", "-stats");
+		Syntax.addFlag("-r", "-reset");
+
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkSetOptionAsyncStreaming: invalid arguments");
+
+		bool bAsync = StreamPipeline.IsAsync();
+		int Depth = StreamPipeline.GetDepth();
+		if (argData.isFlagSet("-e"))
+		{
+			argData.getFlagArgument("-e", 0, bAsync);
+		}
+		if (argData.isFlagSet("-d"))
+		{
+			argData.getFlagArgument("-d", 0, Depth);
+		}
+		if (bAsync != StreamPipeline.IsAsync() || Depth != StreamPipeline.GetDepth())
+		{
+			StreamPipeline.SetAsync(bAsync, Depth);
+		}
+
+		if (argData.isFlagSet("-s"))
+		{
+			// Snapshots submitted, published, dropped, current queue depth and max queue depth
+			appendToResult((int)StreamPipeline.GetSnapshotsSubmitted());
+			appendToResult((int)StreamPipeline.GetSnapshotsPublished());
+			appendToResult((int)StreamPipeline.GetSnapshotsDropped());
+			appendToResult((int)StreamPipeline.GetQueueDepth());
+			appendToResult((int)StreamPipeline.GetMaxQueueDepth());
+		}
+		else
+		{
+			MGlobal::displayInfo(MString("AsyncStreaming: ") + StreamPipeline.IsAsync() + " Depth: " + StreamPipeline.GetDepth());
+		}
+
+		if (argData.isFlagSet("-r"))
+		{
+			StreamPipeline.ResetStats();
+		}
+
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkSetOptionParallelEvaluationCommandName("LiveLinkSetOptionParallelEvaluation");
+
+class LiveLinkSetOptionParallelEvaluationCommand : public MPxCommand
+{
+public:
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkSetOptionParallelEvaluationCommand(); }
+
+	MStatus	doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addFlag("-t", "-threads", MSyntax::kLong);
+		Syntax.addFlag("-js", "-jointSplitThreshold", MSyntax::kLong);
+		Syntax.addFlag("-jt", "-jointsPerTask", MSyntax::kLong);
+
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkSetOptionParallelEvaluation: invalid arguments");
+
+		int Value;
+		if (argData.isFlagSet("-t") && argData.getFlagArgument("-t", 0, Value) == MS::kSuccess)
+		{
+			ParallelEvaluationSettings.MaxThreads = FMath::Max(Value, 0);
+		}
+		if (argData.isFlagSet("-js") && argData.getFlagArgument("-js", 0, Value) == MS::kSuccess)
+		{
+			ParallelEvaluationSettings.JointSplitThreshold = FMath::Max(Value, 0);
+		}
+		if (argData.isFlagSet("-jt") && argData.getFlagArgument("-jt", 0, Value) == MS::kSuccess)
+		{
+			ParallelEvaluationSettings.JointsPerTask = FMath::Max(Value, 1);
+		}
+
+		MGlobal::displayInfo(MString("ParallelEvaluation: Threads: ") + ParallelEvaluationSettings.GetNumThreads() + " JointSplitThreshold: " + ParallelEvaluationSettings.JointSplitThreshold + " JointsPerTask: " + ParallelEvaluationSettings.JointsPerTask);
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkStreamRangeCommandName("LiveLinkStreamRange");
+
+/** Puts the time, autokey and viewport refresh back the way a range bake found them, however the bake returns */
+class FLiveLinkStreamRangeSceneGuard
+{
+public:
+	FLiveLinkStreamRangeSceneGuard()
+		: OriginalTime(MAnimControl::currentTime())
+		, bOriginalAutoKey(MAnimControl::autoKeyMode())
+		, bOriginalSuspended(StreamScheduler.IsSuspended())
+	{
+		// Stepping through time must neither set keys nor trigger the regular stream passes
+		MAnimControl::setAutoKeyMode(false);
+		StreamScheduler.SetSuspended(true);
+		MGlobal::executeCommand("refresh -suspend true");
+	}
+
+	~FLiveLinkStreamRangeSceneGuard()
+	{
+		StreamPipeline.Flush();
+		MGlobal::executeCommand("refresh -suspend false");
+		MAnimControl::setCurrentTime(OriginalTime);
+		MAnimControl::setAutoKeyMode(bOriginalAutoKey);
+		StreamScheduler.SetSuspended(bOriginalSuspended);
+	}
+
+	const MTime& GetOriginalTime() const { return OriginalTime; }
+
+private:
+	MTime OriginalTime;
+	bool bOriginalAutoKey;
+	bool bOriginalSuspended;
+};
+
+/**
+* Bakes a frame range to Unreal as fast as possible. Viewport refresh is suspended while the scene is evaluated at
+* each frame, and every frame is stamped with its scene time. Frames are never dropped, with asynchronous streaming
+* enabled capturing the next frame overlaps publishing the previous ones.
+*
+* In delta mode the first frame of the range is always a keyframe, then one every -keyframeInterval frames (default
+* every DeltaStreamSettings.KeyframeInterval seconds of scene time).
+*
+* Returns frames streamed, seconds taken and frames per second.
+*/
+class LiveLinkStreamRangeCommand : public MPxCommand
+{
+public:
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkStreamRangeCommand(); }
+
+	MStatus	doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addFlag("-s", "-start", MSyntax::kDouble);
+		Syntax.addFlag("-e", "-end", MSyntax::kDouble);
+		Syntax.addFlag("-st", "-step", MSyntax::kDouble);
+		Syntax.addFlag("-ki", "-keyframeInterval", MSyntax::kLong);
+
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkStreamRange: invalid arguments");
+
+		double StartFrame = MAnimControl::minTime().value();
+		double EndFrame = MAnimControl::maxTime().value();
+		double Step = 1.0;
+		int KeyframeInterval = 0;
+		if (argData.isFlagSet("-s"))
+		{
+			argData.getFlagArgument("-s", 0, StartFrame);
+		}
+		if (argData.isFlagSet("-e"))
+		{
+			argData.getFlagArgument("-e", 0, EndFrame);
+		}
+		if (argData.isFlagSet("-st"))
+		{
+			argData.getFlagArgument("-st", 0, Step);
+		}
+		if (argData.isFlagSet("-ki"))
+		{
+			argData.getFlagArgument("-ki", 0, KeyframeInterval);
+		}
+
+		if (Step <= 0.0 || EndFrame < StartFrame || KeyframeInterval < 0)
+		{
+			MGlobal::displayError("LiveLinkStreamRange: step must be positive, end must not be before start and the keyframe interval must not be negative");
+			return MS::kInvalidParameter;
+		}
+
+		if (!LiveLinkStreamManager.IsValid())
+		{
+			MGlobal::displayError("LiveLinkStreamRange: Live Link is not initialized");
+			return MS::kFailure;
+		}
+
+		FLiveLinkStreamRangeSceneGuard SceneGuard;
+		const MTime::Unit TimeUnit = SceneGuard.GetOriginalTime().unit();
+
+		const double BakeStartTime = FPlatformTime::Seconds();
+		int32 FramesStreamed = 0;
+
+		const int32 NumSteps = FMath::FloorToInt((EndFrame - StartFrame) / Step + KINDA_SMALL_NUMBER);
+		for (int32 StepIndex = 0; StepIndex <= NumSteps; ++StepIndex)
+		{
+			const MTime FrameTime(StartFrame + StepIndex * Step, TimeUnit);
+			if (MAnimControl::setCurrentTime(FrameTime) != MS::kSuccess)
+			{
+				MGlobal::displayError(MString("LiveLinkStreamRange: unable to evaluate frame ") + FrameTime.value());
+				return MS::kFailure;
+			}
+
+			const bool bForceKeyframe = (StepIndex == 0) || (KeyframeInterval > 0 && StepIndex % KeyframeInterval == 0);
+			LiveLinkStreamManager->StreamSubjects(FrameTime.as(MTime::kSeconds), (int32)FrameTime.value(), false, bForceKeyframe);
+			++FramesStreamed;
+		}
+
+		StreamPipeline.Flush();
+		const double BakeSeconds = FPlatformTime::Seconds() - BakeStartTime;
+
+		const double FramesPerSecond = BakeSeconds > 0.0 ? FramesStreamed / BakeSeconds : 0.0;
+		MGlobal::displayInfo(MString("LiveLinkStreamRange: ") + FramesStreamed + " frames in " + BakeSeconds + "s (" + FramesPerSecond + " fps)");
+
+		appendToResult(FramesStreamed);
+		appendToResult(BakeSeconds);
+		appendToResult(FramesPerSecond);
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkRecordTakeCommandName("LiveLinkRecordTake");
+
+class LiveLinkRecordTakeCommand : public MPxCommand
+{
+public:
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkRecordTakeCommand(); }
+
+	MStatus	doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addFlag("-f", "-file", MSyntax::kString);
+		Syntax.addFlag("-s", "-stop");
+
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkRecordTake: invalid arguments");
+
+		// Frames still queued for the worker belong to the take
+		StreamPipeline.Flush();
+		const int32 FramesRecorded = TakeRecorder.GetFramesRecorded();
+
+		if (argData.isFlagSet("-s"))
+		{
+			TakeRecorder.Stop();
+		}
+		else if (argData.isFlagSet("-f"))
+		{
+			MString Filename;
+			argData.getFlagArgument("-f", 0, Filename);
+			if (!TakeRecorder.Start(FString(Filename.asChar())))
+			{
+				MGlobal::displayError(MString("LiveLinkRecordTake: unable to open ") + Filename);
+				return MS::kFailure;
+			}
+
+			// Static data is only sent on change, so the take starts with what every subject sent last
+			LiveLinkStreamManager->RecordStaticData(TakeRecorder);
+		}
+
+		setResult(FramesRecorded);
+		return MS::kSuccess;
+	}
+};
+
+/**
+* Runs a take replay on its own thread so Maya stays responsive, see FLiveLinkTakeReplay. The scheduler doesn't stream
+* the scene while it runs. Started, polled and cancelled from Maya's main thread.
+*/
+class FLiveLinkTakeReplayJob : public FRunnable
+{
+public:
+	FLiveLinkTakeReplayJob()
+		: Thread(nullptr)
+		, StartFrame(0)
+		, EndFrame(0)
+		, Speed(1.0)
+		, bLocal(false)
+		, bRunning(false)
+		, StartTime(0.0)
+		, EndTime(0.0)
+	{}
+
+	virtual ~FLiveLinkTakeReplayJob()
+	{
+		Cancel();
+	}
+
+	bool IsRunning() const { return bRunning.load(); }
+	int32 GetFramesReplayed() const { return Replay.GetFramesReplayed(); }
+	double GetSeconds() const { return (bRunning ? FPlatformTime::Seconds() : EndTime.load()) - StartTime; }
+
+	/** Takes over an opened reader, fails while another replay is running */
+	bool Start(TUniquePtr<FLiveLinkTakeReader> InReader, int32 InStartFrame, int32 InEndFrame, double InSpeed, bool bInLocal)
+	{
+		if (IsRunning())
+		{
+			return false;
+		}
+		Join();
+
+		Reader = MoveTemp(InReader);
+		StartFrame = InStartFrame;
+		EndFrame = InEndFrame;
+		Speed = InSpeed;
+		bLocal = bInLocal;
+
+		// Frames still queued for the worker go out before the take's
+		StreamPipeline.Flush();
+		StreamScheduler.SetReplaying(true);
+
+		Replay.Reset();
+		StartTime = EndTime = FPlatformTime::Seconds();
+		bRunning = true;
+		Thread = FRunnableThread::Create(this, TEXT("LiveLinkTakeReplay"));
+		return true;
+	}
+
+	/** Stops a running replay and waits for its thread */
+	void Cancel()
+	{
+		Replay.Cancel();
+		Join();
+	}
+
+	virtual uint32 Run() override
+	{
+		// Counted per subject like streamed subjects are, only for as long as the replay runs
+		TMap<FName, TUniquePtr<LiveLinkStats::FSubjectTraffic>> SubjectTraffic;
+		auto GetTraffic = [&SubjectTraffic](FName SubjectName) -> LiveLinkStats::FSubjectTraffic*
+		{
+			TUniquePtr<LiveLinkStats::FSubjectTraffic>& Traffic = SubjectTraffic.FindOrAdd(SubjectName);
+			if (!Traffic.IsValid())
+			{
+				Traffic = MakeUnique<LiveLinkStats::FSubjectTraffic>(SubjectName);
+			}
+			return Traffic.Get();
+		};
+
+		Replay.Run(*Reader, StartFrame, EndFrame, Speed,
+			[this, &GetTraffic](FName SubjectName, const TArray<FName>& BoneNames, const TArray<int32>& BoneParents)
+			{
+				if (!bLocal)
+				{
+					SendSubject(SubjectName, BoneNames, BoneParents, GetTraffic(SubjectName));
+				}
+			},
+			[this, &GetTraffic](FName SubjectName, const TArray<FTransform>& Transforms, const TArray<FLiveLinkCurveElement>& Curves, double ReplayTime)
+			{
+				if (!bLocal)
+				{
+					SendSubjectFrame(SubjectName, Transforms, Curves, ReplayTime, GetTraffic(SubjectName), false);
+				}
+			});
+
+		EndTime = FPlatformTime::Seconds();
+		StreamScheduler.SetReplaying(false);
+		bRunning = false;
+		return 0;
+	}
+
+private:
+	void Join()
+	{
+		if (Thread != nullptr)
+		{
+			Thread->WaitForCompletion();
+			delete Thread;
+			Thread = nullptr;
+		}
+		Reader.Reset();
+	}
+
+	FRunnableThread* Thread;
+	TUniquePtr<FLiveLinkTakeReader> Reader;
+	FLiveLinkTakeReplay Replay;
+
+	int32 StartFrame;
+	int32 EndFrame;
+	double Speed;
+	bool bLocal;
+
+	std::atomic<bool> bRunning;
+	double StartTime;
+	std::atomic<double> EndTime;
+};
+
+FLiveLinkTakeReplayJob TakeReplayJob;
+
+const MString LiveLinkReplayTakeCommandName("LiveLinkReplayTake");
+
+/**
+* Streams a recorded take back to the provider without evaluating the scene, at its recorded pace scaled by -speed
+* or as fast as possible with -speed 0. -local replaces the provider with a stand-in receiver that only decodes the
+* take, for measuring replay itself.
+*
+* The replay runs in the background and the command returns the number of frames it will replay. -query returns
+* whether it is still running, frames replayed so far, seconds taken and frames per second, -cancel stops it and
+* returns the same.
+*/
+class LiveLinkReplayTakeCommand : public MPxCommand
+{
+public:
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkReplayTakeCommand(); }
+
+	MStatus	doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addFlag("-f", "-file", MSyntax::kString);
+		Syntax.addFlag("-sf", "-startFrame", MSyntax::kLong);
+		Syntax.addFlag("-ef", "-endFrame", MSyntax::kLong);
+		Syntax.addFlag("-sp", "-speed", MSyntax::kDouble);
+		Syntax.addFlag("-l", "-local");
+		Syntax.addFlag("-q", "-query");
+		Syntax.addFlag("-c", "-cancel");
+
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkReplayTake: invalid arguments");
+
+		if (argData.isFlagSet("-q") || argData.isFlagSet("-c"))
+		{
+			if (argData.isFlagSet("-c"))
+			{
+				TakeReplayJob.Cancel();
+			}
+
+			const int32 FramesReplayed = TakeReplayJob.GetFramesReplayed();
+			const double ReplaySeconds = TakeReplayJob.GetSeconds();
+			const double FramesPerSecond = ReplaySeconds > 0.0 ? FramesReplayed / ReplaySeconds : 0.0;
+			MGlobal::displayInfo(MString("LiveLinkReplayTake: ") + (TakeReplayJob.IsRunning() ? "running, " : "") + FramesReplayed + " frames in " + ReplaySeconds + "s (" + FramesPerSecond + " fps)");
+
+			appendToResult((int)TakeReplayJob.IsRunning());
+			appendToResult(FramesReplayed);
+			appendToResult(ReplaySeconds);
+			appendToResult(FramesPerSecond);
+			return MS::kSuccess;
+		}
+
+		MString Filename;
+		if (argData.getFlagArgument("-f", 0, Filename) != MS::kSuccess)
+		{
+			MGlobal::displayError("LiveLinkReplayTake: -file is required");
+			return MS::kInvalidParameter;
+		}
+
+		if (TakeReplayJob.IsRunning())
+		{
+			MGlobal::displayError("LiveLinkReplayTake: a replay is already running, cancel it with -cancel first");
+			return MS::kFailure;
+		}
+
+		TUniquePtr<FLiveLinkTakeReader> Reader = MakeUnique<FLiveLinkTakeReader>();
+		FString Error;
+		if (!Reader->Open(FString(Filename.asChar()), Error))
+		{
+			MGlobal::displayError(MString("LiveLinkReplayTake: ") + MString(*Error));
+			return MS::kFailure;
+		}
+
+		int StartFrame = 0;
+		int EndFrame = Reader->GetNumFrames() - 1;
+		double Speed = 1.0;
+		argData.getFlagArgument("-sf", 0, StartFrame);
+		argData.getFlagArgument("-ef", 0, EndFrame);
+		argData.getFlagArgument("-sp", 0, Speed);
+		const bool bLocal = argData.isFlagSet("-l");
+
+		StartFrame = FMath::Max(StartFrame, 0);
+		EndFrame = FMath::Min(EndFrame, Reader->GetNumFrames() - 1);
+		if (StartFrame > EndFrame)
+		{
+			setResult(0);
+			return MS::kSuccess;
+		}
+
+		TakeReplayJob.Start(MoveTemp(Reader), StartFrame, EndFrame, Speed, bLocal);
+		setResult(EndFrame - StartFrame + 1);
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkBenchmarkCommandName("LiveLinkBenchmark");
+
+/**
+* Runs RunStreamingBenchmark and returns its JSON, also written to -output. The synthetic scene never touches the DAG,
+* so the command needs no open scene or viewport and runs the same in a headless session, which is how it is meant to
+* be run for comparisons between builds:
+*
+*	mayapy -c "import maya.standalone; maya.standalone.initialize(); import maya.cmds as cmds;
+*		cmds.loadPlugin('MayaLiveLinkPlugin2015'); cmds.LiveLinkBenchmark(characters=4, joints=5000, output='run.json')"
+*
+* It stays a plugin command rather than a separate program: capture, convert and publish are the plugin's own code
+* paths, and the matrix path and accuracy checks need Maya's libraries either way.
+*/
+class LiveLinkBenchmarkCommand : public MPxCommand
+{
+public:
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkBenchmarkCommand(); }
+
+	MStatus	doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addFlag("-c", "-characters", MSyntax::kLong);
+		Syntax.addFlag("-j", "-joints", MSyntax::kLong);
+		Syntax.addFlag("-fo", "-fanOut", MSyntax::kLong);
+		Syntax.addFlag("-md", "-maxDepth", MSyntax::kLong);
+		Syntax.addFlag("-cam", "-cameras", MSyntax::kLong);
+		Syntax.addFlag("-p", "-props", MSyntax::kLong);
+		Syntax.addFlag("-cv", "-curves", MSyntax::kLong);
+		Syntax.addFlag("-fr", "-frames", MSyntax::kLong);
+		Syntax.addFlag("-sd", "-seed", MSyntax::kLong);
+		Syntax.addFlag("-pub", "-publish");
+		Syntax.addFlag("-tr", "-transport");
+		Syntax.addFlag("-pe", "-positionError", MSyntax::kDouble);
+		Syntax.addFlag("-re", "-rotationError", MSyntax::kDouble);
+		Syntax.addFlag("-ce", "-curveError", MSyntax::kDouble);
+		Syntax.addFlag("-o", "-output", MSyntax::kString);
+
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkBenchmark: invalid arguments");
+
+		FLiveLinkBenchmarkSettings Settings;
+		argData.getFlagArgument("-c", 0, Settings.NumCharacters);
+		argData.getFlagArgument("-j", 0, Settings.JointsPerCharacter);
+		argData.getFlagArgument("-fo", 0, Settings.FanOut);
+		argData.getFlagArgument("-md", 0, Settings.MaxDepth);
+		argData.getFlagArgument("-cam", 0, Settings.NumCameras);
+		argData.getFlagArgument("-p", 0, Settings.NumProps);
+		argData.getFlagArgument("-cv", 0, Settings.NumCurves);
+		argData.getFlagArgument("-fr", 0, Settings.NumFrames);
+		argData.getFlagArgument("-sd", 0, Settings.Seed);
+		Settings.bPublish = argData.isFlagSet("-pub");
+		Settings.bTransport = argData.isFlagSet("-tr");
+
+		double Value;
+		if (argData.isFlagSet("-pe") && argData.getFlagArgument("-pe", 0, Value) == MS::kSuccess)
+		{
+			Settings.MaxPositionError = (float)Value;
+		}
+		if (argData.isFlagSet("-re") && argData.getFlagArgument("-re", 0, Value) == MS::kSuccess)
+		{
+			Settings.MaxRotationError = (float)Value;
+		}
+		if (argData.isFlagSet("-ce") && argData.getFlagArgument("-ce", 0, Value) == MS::kSuccess)
+		{
+			Settings.MaxCurveError = (float)Value;
+		}
+
+		const FString Json = RunStreamingBenchmark(Settings);
+
+		MString OutputFile;
+		if (argData.getFlagArgument("-o", 0, OutputFile) == MS::kSuccess && !FFileHelper::SaveStringToFile(Json, UTF8_TO_TCHAR(OutputFile.asChar())))
+		{
+			MGlobal::displayError(MString("LiveLinkBenchmark: unable to write ") + OutputFile);
+			return MS::kFailure;
+		}
+
+		setResult(MString(*Json));
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkStatsCommandName("LiveLinkStats");
+
+class LiveLinkStatsCommand : public MPxCommand
+{
+public:
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkStatsCommand(); }
+
+	MStatus	doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addFlag("-r", "-reset");
+		Syntax.addFlag("-j", "-json");
+
+		MArgDatabase argData(Syntax, args);
+
+		if (argData.isFlagSet("-j"))
+		{
+			setResult(MString(*LiveLinkStats::ToJson()));
+		}
+		else
+		{
+			TArray<FString> Lines;
+			LiveLinkStats::GetSummary(Lines);
+
+			for (const FString& Line : Lines)
+			{
+				appendToResult(MString(*Line));
+			}
+		}
+
+		if (argData.isFlagSet("-r"))
+		{
+			LiveLinkStats::Reset();
+		}
+
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkSetOptionStreamRateCommandName("LiveLinkSetOptionStreamRate");
+
+class LiveLinkSetOptionStreamRateCommand : public MPxCommand
+{
+public:
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkSetOptionStreamRateCommand(); }
+
+	MStatus	doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addFlag("-r", "-rate", MSyntax::kDouble);
+		Syntax.addFlag("-mr", "-minRate", MSyntax::kDouble);
+		Syntax.addFlag("-b", "-budget", MSyntax::kDouble);
+		Syntax.addFlag("-q", "-query");
+
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkSetOptionStreamRate: invalid arguments");
+
+		double Value;
+		if (argData.isFlagSet("-mr") && argData.getFlagArgument("-mr", 0, Value) == MS::kSuccess)
+		{
+			StreamClock.SetMinRate(Value);
+		}
+		if (argData.isFlagSet("-b") && argData.getFlagArgument("-b", 0, Value) == MS::kSuccess)
+		{
+			StreamClock.SetBudgetFraction(Value);
+		}
+		if (argData.isFlagSet("-r") && argData.getFlagArgument("-r", 0, Value) == MS::kSuccess)
+		{
+			StreamClock.SetTargetRate(Value);
+		}
+
+		if (argData.isFlagSet("-q"))
+		{
+			// Target rate (0 follows viewport redraws), rate currently used and stream passes achieved per second
+			appendToResult(StreamClock.GetTargetRate());
+			appendToResult(StreamClock.GetEffectiveRate());
+			appendToResult(StreamClock.GetAchievedRate());
+		}
+		else
+		{
+			MGlobal::displayInfo(MString("StreamRate: ") + StreamClock.GetTargetRate() + " Hz");
+		}
+
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkAllocationCountersCommandName("LiveLinkAllocationCounters");
+
+class LiveLinkAllocationCountersCommand : public MPxCommand
+{
+public:
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkAllocationCountersCommand(); }
+
+	MStatus	doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addFlag("-r", "-reset");
+
+		MArgDatabase argData(Syntax, args);
+
+		// GMalloc allocations, reallocations, frees and bytes allocated on the stream path, all 0 once streaming is warm.
+		// Doubles since the counters are 64 bit and a long session overflows an int
+		appendToResult((double)LiveLinkAllocations::Allocations.load());
+		appendToResult((double)LiveLinkAllocations::Reallocations.load());
+		appendToResult((double)LiveLinkAllocations::Frees.load());
+		appendToResult((double)LiveLinkAllocations::BytesAllocated.load());
+
+		if (argData.isFlagSet("-r"))
+		{
+			LiveLinkAllocations::Reset();
+		}
+
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkSetSubjectEncodingCommandName("LiveLinkSetSubjectEncoding");
+
+class LiveLinkSetSubjectEncodingCommand : public MPxCommand
+{
+public:
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkSetSubjectEncodingCommand(); }
+
+	MStatus	doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addFlag("-s", "-subject", MSyntax::kString);
+		Syntax.addFlag("-e", "-encoding", MSyntax::kString);
+		Syntax.addFlag("-pe", "-positionError", MSyntax::kDouble);
+		Syntax.addFlag("-re", "-rotationError", MSyntax::kDouble);
+		Syntax.addFlag("-ce", "-curveError", MSyntax::kDouble);
+		Syntax.addFlag("-c", "-clear");
+
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkSetSubjectEncoding: invalid arguments");
+
+		// Without a subject the default for all subjects is changed
+		FName SubjectName = NAME_None;
+		MString SubjectNameValue;
+		if (argData.isFlagSet("-s") && argData.getFlagArgument("-s", 0, SubjectNameValue) == MS::kSuccess)
+		{
+			SubjectName = FName(UTF8_TO_TCHAR(SubjectNameValue.asChar()));
+		}
+
+		if (argData.isFlagSet("-c"))
+		{
+			LiveLinkFrameCodec::Registry.ClearSettings(SubjectName);
+		}
+
+		LiveLinkFrameCodec::FSettings Settings = LiveLinkFrameCodec::Registry.GetSettings(SubjectName);
+
+		MString Encoding;
+		if (argData.isFlagSet("-e") && argData.getFlagArgument("-e", 0, Encoding) == MS::kSuccess)
+		{
+			if (Encoding == "full")
+			{
+				Settings.Encoding = LiveLinkFrameCodec::EEncoding::Full;
+			}
+			else if (Encoding == "compact")
+			{
+				Settings.Encoding = LiveLinkFrameCodec::EEncoding::Compact;
+			}
+			else
+			{
+				MGlobal::displayError(MString("LiveLinkSetSubjectEncoding: unknown encoding ") + Encoding + ", expected full or compact");
+				return MS::kInvalidParameter;
+			}
+		}
+
+		double Value;
+		if (argData.isFlagSet("-pe") && argData.getFlagArgument("-pe", 0, Value) == MS::kSuccess)
+		{
+			Settings.MaxPositionError = (float)FMath::Max(Value, 1e-6);
+		}
+		if (argData.isFlagSet("-re") && argData.getFlagArgument("-re", 0, Value) == MS::kSuccess)
+		{
+			Settings.MaxRotationError = (float)FMath::Max(Value, 1e-6);
+		}
+		// 0 keeps curve values as full floats
+		if (argData.isFlagSet("-ce") && argData.getFlagArgument("-ce", 0, Value) == MS::kSuccess)
+		{
+			Settings.MaxCurveError = (float)FMath::Max(Value, 0.0);
+		}
+
+		if (!argData.isFlagSet("-c") || argData.isFlagSet("-e") || argData.isFlagSet("-pe") || argData.isFlagSet("-re") || argData.isFlagSet("-ce"))
+		{
+			LiveLinkFrameCodec::Registry.SetSettings(SubjectName, Settings);
+		}
+
+		appendToResult(Settings.Encoding == LiveLinkFrameCodec::EEncoding::Compact ? "compact" : "full");
+		appendToResult((double)Settings.MaxPositionError);
+		appendToResult((double)Settings.MaxRotationError);
+		appendToResult((double)Settings.MaxCurveError);
+		return MS::kSuccess;
+	}
+};
+
+const MString LiveLinkEndpointsCommandName("LiveLinkEndpoints");
+
+/**
+* Extra providers that get the same stream as the main one, e.g. for a render node or a recording machine. Every
+* endpoint gets every frame unless -dropFrames lets it send only each subject's latest one when it falls behind.
+*/
+class LiveLinkEndpointsCommand : public MPxCommand
+{
+public:
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkEndpointsCommand(); }
+
+	MStatus	doIt(const MArgList& args)
+	{
+		MSyntax Syntax;
+		Syntax.addFlag("-a", "-add", MSyntax::kString);
+		Syntax.addFlag("-rm", "-remove", MSyntax::kString);
+		Syntax.addFlag("-e", "-endpoint", MSyntax::kString);
+		Syntax.addFlag("-mr", "-maxRate", MSyntax::kDouble);
+		Syntax.addFlag("-df", "-dropFrames", MSyntax::kBoolean);
+		Syntax.addFlag("-ra", "-removeAll");
+		Syntax.addFlag("-r", "-reset");
+
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkEndpoints: invalid arguments");
+
+		double MaxRate = 0.0;
+		const bool bHasMaxRate = argData.isFlagSet("-mr") && argData.getFlagArgument("-mr", 0, MaxRate) == MS::kSuccess;
+		bool bDropFrames = false;
+		const bool bHasDropFrames = argData.isFlagSet("-df") && argData.getFlagArgument("-df", 0, bDropFrames) == MS::kSuccess;
+
+		MString ProviderName;
+		if (argData.isFlagSet("-a") && argData.getFlagArgument("-a", 0, ProviderName) == MS::kSuccess)
+		{
+			if (!EndpointHub.AddEndpoint(UTF8_TO_TCHAR(ProviderName.asChar()), MaxRate, bDropFrames))
+			{
+				MGlobal::displayError(MString("LiveLinkEndpoints: endpoint ") + ProviderName + " already exists");
+				return MS::kInvalidParameter;
+			}
+		}
+		if (argData.isFlagSet("-e") && argData.getFlagArgument("-e", 0, ProviderName) == MS::kSuccess && (bHasMaxRate || bHasDropFrames))
+		{
+			const FString EndpointName = UTF8_TO_TCHAR(ProviderName.asChar());
+			if ((bHasMaxRate && !EndpointHub.SetMaxRate(EndpointName, MaxRate)) || (bHasDropFrames && !EndpointHub.SetDropFrames(EndpointName, bDropFrames)))
+			{
+				MGlobal::displayError(MString("LiveLinkEndpoints: no endpoint ") + ProviderName);
+				return MS::kInvalidParameter;
+			}
+		}
+		if (argData.isFlagSet("-rm") && argData.getFlagArgument("-rm", 0, ProviderName) == MS::kSuccess)
+		{
+			if (!EndpointHub.RemoveEndpoint(UTF8_TO_TCHAR(ProviderName.asChar())))
+			{
+				MGlobal::displayWarning(MString("LiveLinkEndpoints: no removable endpoint ") + ProviderName);
+			}
+		}
+		if (argData.isFlagSet("-ra"))
+		{
+			EndpointHub.RemoveAllEndpoints();
+		}
+
+		TArray<FString> Lines;
+		EndpointHub.GetEndpointStatus(Lines);
+		for (const FString& Line : Lines)
+		{
+			appendToResult(MString(*Line));
+		}
+
+		if (argData.isFlagSet("-r"))
+		{
+			EndpointHub.ResetStats();
+		}
 
-	virtual void OnStream(double StreamTime, int32 FrameNumber)
-	{
-		StreamCamera(CameraPath, StreamTime, FrameNumber);
+		return MS::kSuccess;
 	}
-
-private:
-	MDagPath CameraPath;
 };
 
-FName FLiveLinkStreamedActiveCamera::ActiveCameraName("EditorActiveCamera");
+const MString LiveLinkSetOptionVerbosityCommandName("LiveLinkSetOptionVerbosity");
 
-struct FLiveLinkStreamedPropSubject : IStreamedEntity
+class LiveLinkSetOptionVerbosityCommand : public MPxCommand
 {
 public:
-	FLiveLinkStreamedPropSubject(FName InSubjectName, MDagPath InRootPath)
-		: SubjectName(InSubjectName)
-		, RootDagPath(InRootPath)
-	{}
-
-	virtual bool ShouldDisplayInUI() const { return true; }
-	virtual MString GetDisplayText() const { return MString("Prop: ") + MString(*SubjectName.ToString()) + " ( " + RootDagPath.fullPathName() + " )"; }
-
-	virtual bool ValidateSubject() const {return true;}
-
-	virtual void RebuildSubjectData()
-	{
-		LiveLinkProvider->UpdateSubject(SubjectName, PropBoneNames, PropBoneParents);
-	}
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkSetOptionVerbosityCommand(); }
 
-	virtual void OnStream(double StreamTime, int32 FrameNumber)
+	MStatus	doIt(const MArgList& args)
 	{
-		MFnTransform TransformNode(RootDagPath);
+		MSyntax Syntax;
+		Syntax.addFlag("-l", "-level", MSyntax::kLong);
 
-		MMatrix Transform = TransformNode.transformation().asMatrix();
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkSetOptionVerbosity: invalid arguments");
 
-		TArray<FTransform> UETransforms = { BuildUETransformFromMayaTransform(Transform) };
-		// Convert Maya Camera orientation to Unreal
-		TArray<FLiveLinkCurveElement> Curves;
+		// 0 off, 1 subject lifetime events, 2 validation details
+		int Level;
+		if (argData.isFlagSet("-l") && argData.getFlagArgument("-l", 0, Level) == MS::kSuccess)
+		{
+			DebugVerbosity = FMath::Clamp(Level, 0, 2);
+		}
 
-		LiveLinkProvider->UpdateSubjectFrame(SubjectName, UETransforms, Curves, StreamTime);
+		setResult(DebugVerbosity);
+		return MS::kSuccess;
 	}
-
-private:
-	FName SubjectName;
-	MDagPath RootDagPath;
-
-	static TArray<FName> PropBoneNames;
-	static TArray<int32> PropBoneParents;
-
 };
 
-TArray<FName> FLiveLinkStreamedPropSubject::PropBoneNames = { FName("root") };
-TArray<int32> FLiveLinkStreamedPropSubject::PropBoneParents = { -1 };
+const MString LiveLinkAddCurveSourcesCommandName("LiveLinkAddCurveSources");
 
-class FLiveLinkStreamedSubjectManager
+/** Streams the attributes of each -node matching -attribute as curves of a character subject */
+class LiveLinkAddCurveSourcesCommand : public MPxCommand
 {
-private:
-	TArray<TSharedPtr<IStreamedEntity>> Subjects;
-
-	void ValidateSubjects()
-	{
-		Subjects.RemoveAll([](const TSharedPtr<IStreamedEntity>& Item)
-		{
-			return !Item->ValidateSubject();
-		});
-		RefreshUI();
-	}
-
 public:
+	static void		cleanup() {}
+	static void*	creator() { return new LiveLinkAddCurveSourcesCommand(); }
 
-	FLiveLinkStreamedSubjectManager()
+	MStatus			doIt(const MArgList& args)
 	{
-		Reset();
-	}
+		MSyntax Syntax;
+		Syntax.addFlag("-s", "-subject", MSyntax::kString);
+		Syntax.addFlag("-n", "-node", MSyntax::kString);
+		Syntax.addFlag("-a", "-attribute", MSyntax::kString);
+		Syntax.addFlag("-px", "-prefix", MSyntax::kString);
+		Syntax.makeFlagMultiUse("-n");
 
-	void GetSubjectEntries(TArray<MString>& Entries) const
-	{
-		for (const TSharedPtr<IStreamedEntity>& Subject : Subjects)
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkAddCurveSources: invalid arguments");
+
+		MString SubjectName;
+		if (!argData.isFlagSet("-s") || argData.getFlagArgument("-s", 0, SubjectName) != MS::kSuccess || argData.numberOfFlagUses("-n") == 0)
 		{
-			if (Subject->ShouldDisplayInUI())
-			{
-				Entries.Add(Subject->GetDisplayText());
-			}
+			MGlobal::displayError("LiveLinkAddCurveSources: -subject and at least one -node are required");
+			return MS::kInvalidParameter;
 		}
-	}
-
-	template<class SubjectType, typename... ArgsType>
-	TSharedPtr<SubjectType> AddSubjectOfType(ArgsType&&... Args)
-	{
-		TSharedPtr<SubjectType> Subject = MakeShareable(new SubjectType(Args...));
 
-		Subject->RebuildSubjectData();
+		MayaSyncedUserDefinedAttributes::FCurveSourceSpec Spec;
+		Spec.AttributePattern = "*";
+		argData.getFlagArgument("-a", 0, Spec.AttributePattern);
+		argData.getFlagArgument("-px", 0, Spec.Prefix);
 
-		int32 FrameNumber = MAnimControl::currentTime().value();
-		Subject->OnStream(FPlatformTime::Seconds(), FrameNumber);
+		const FName Subject(SubjectName.asChar());
+		for (unsigned int Idx = 0; Idx < argData.numberOfFlagUses("-n"); ++Idx)
+		{
+			MArgList FlagArgs;
+			argData.getFlagArgumentList("-n", Idx, FlagArgs);
+			FlagArgs.get(0, Spec.NodePattern);
+			MayaSyncedUserDefinedAttributes::CurveSourceRegistry.AddSource(Subject, Spec);
+		}
 
-		Subjects.Add(Subject);
-		return Subject;
-	}
+		MarkSceneDirty();
 
-	void AddJointHeirarchySubject(FName SubjectName, MDagPath RootPath)
-	{
-		AddSubjectOfType<FLiveLinkStreamedJointHeirarchySubject>(SubjectName, RootPath);
+		const TArray<MayaSyncedUserDefinedAttributes::FCurveSourceSpec>* Sources = MayaSyncedUserDefinedAttributes::CurveSourceRegistry.FindSources(Subject);
+		setResult(Sources ? Sources->Num() : 0);
+		return MS::kSuccess;
 	}
+};
 
-	void AddCameraSubject(FName SubjectName, MDagPath RootPath)
-	{
-		AddSubjectOfType<FLiveLinkStreamedCameraSubject>(SubjectName, RootPath);
-	}
+const MString LiveLinkRemoveCurveSourcesCommandName("LiveLinkRemoveCurveSources");
 
-	void AddPropSubject(FName SubjectName, MDagPath RootPath)
-	{
-		AddSubjectOfType<FLiveLinkStreamedPropSubject>(SubjectName, RootPath);
-	}
+/** Removes the curve sources of each -node, or all of the subject's sources when no -node is given */
+class LiveLinkRemoveCurveSourcesCommand : public MPxCommand
+{
+public:
+	static void		cleanup() {}
+	static void*	creator() { return new LiveLinkRemoveCurveSourcesCommand(); }
 
-	void RemoveSubject(MString SubjectToRemove)
+	MStatus			doIt(const MArgList& args)
 	{
-		TArray<MString> Entries;
-		GetSubjectEntries(Entries);
-		int32 Index = Entries.IndexOfByKey(SubjectToRemove);
-		Subjects.RemoveAt(Index);
-	}
+		MSyntax Syntax;
+		Syntax.addFlag("-s", "-subject", MSyntax::kString);
+		Syntax.addFlag("-n", "-node", MSyntax::kString);
+		Syntax.makeFlagMultiUse("-n");
 
-	void Reset()
-	{
-		Subjects.Reset();
-		AddSubjectOfType<FLiveLinkStreamedActiveCamera>();
-	}
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkRemoveCurveSources: invalid arguments");
 
-	void RebuildSubjects()
-	{
-		ValidateSubjects();
-		for (const TSharedPtr<IStreamedEntity>& Subject : Subjects)
+		MString SubjectName;
+		if (!argData.isFlagSet("-s") || argData.getFlagArgument("-s", 0, SubjectName) != MS::kSuccess)
 		{
-			Subject->RebuildSubjectData();
+			MGlobal::displayError("LiveLinkRemoveCurveSources: -subject is required");
+			return MS::kInvalidParameter;
 		}
-	}
 
-	void StreamSubjects() const
-	{
-		double StreamTime = FPlatformTime::Seconds();
-		int32 FrameNumber = MAnimControl::currentTime().value();
+		const FName Subject(SubjectName.asChar());
+		int32 NumRemoved = 0;
+		if (argData.numberOfFlagUses("-n") == 0)
+		{
+			NumRemoved = MayaSyncedUserDefinedAttributes::CurveSourceRegistry.RemoveSources(Subject, MString());
+		}
+		for (unsigned int Idx = 0; Idx < argData.numberOfFlagUses("-n"); ++Idx)
+		{
+			MArgList FlagArgs;
+			MString NodePattern;
+			argData.getFlagArgumentList("-n", Idx, FlagArgs);
+			FlagArgs.get(0, NodePattern);
+			if (NodePattern.length() > 0)
+			{
+				NumRemoved += MayaSyncedUserDefinedAttributes::CurveSourceRegistry.RemoveSources(Subject, NodePattern);
+			}
+		}
 
-		for (const TSharedPtr<IStreamedEntity>& Subject : Subjects)
+		if (NumRemoved > 0)
 		{
-			Subject->OnStream(StreamTime, FrameNumber);
+			MarkSceneDirty();
 		}
+		setResult(NumRemoved);
+		return MS::kSuccess;
 	}
 };
 
-const MString LiveLinkSubjectsCommandName("LiveLinkSubjects");
+const MString LiveLinkCurveSourcesCommandName("LiveLinkCurveSources");
 
-class LiveLinkSubjectsCommand : public MPxCommand
+/** Lists a subject's curve sources as node, attribute pattern and prefix triplets */
+class LiveLinkCurveSourcesCommand : public MPxCommand
 {
 public:
 	static void		cleanup() {}
-	static void*	creator() { return new LiveLinkSubjectsCommand(); }
+	static void*	creator() { return new LiveLinkCurveSourcesCommand(); }
 
 	MStatus			doIt(const MArgList& args)
 	{
-		TArray<MString> SubjectEntries;
-		LiveLinkStreamManager->GetSubjectEntries(SubjectEntries);
+		MSyntax Syntax;
+		Syntax.addFlag("-s", "-subject", MSyntax::kString);
 
-		for (const MString& Entry : SubjectEntries)
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkCurveSources: invalid arguments");
+
+		MString SubjectName;
+		if (!argData.isFlagSet("-s") || argData.getFlagArgument("-s", 0, SubjectName) != MS::kSuccess)
 		{
-			appendToResult(Entry);
+			MGlobal::displayError("LiveLinkCurveSources: -subject is required");
+			return MS::kInvalidParameter;
 		}
 
+		if (const TArray<MayaSyncedUserDefinedAttributes::FCurveSourceSpec>* Sources = MayaSyncedUserDefinedAttributes::CurveSourceRegistry.FindSources(FName(SubjectName.asChar())))
+		{
+			for (const MayaSyncedUserDefinedAttributes::FCurveSourceSpec& Spec : *Sources)
+			{
+				appendToResult(Spec.NodePattern);
+				appendToResult(Spec.AttributePattern);
+				appendToResult(Spec.Prefix);
+			}
+		}
 		return MS::kSuccess;
 	}
 };
 
-const MString LiveLinkAddSubjectCommandName("LiveLinkAddSubject");
+const MString LiveLinkSharedMemoryCommandName("LiveLinkSharedMemory");
 
-class LiveLinkAddSubjectCommand : public MPxCommand
+/**
+* Opens or closes the shared memory ring for readers on this machine, or attaches to a ring as a stand-in reader for
+* -read seconds. Returns the writer's or the reader's counters.
+*/
+class LiveLinkSharedMemoryCommand : public MPxCommand
 {
 public:
-	static void		cleanup() {}
-	static void*	creator() { return new LiveLinkAddSubjectCommand(); }
+	static void	 cleanup() {}
+	static void* creator() { return new LiveLinkSharedMemoryCommand(); }
 
-	MStatus			doIt(const MArgList& args)
+	MStatus	doIt(const MArgList& args)
 	{
 		MSyntax Syntax;
-		Syntax.addArg(MSyntax::kString);
-
-		MArgDatabase argData(Syntax, args);
-
-		MString Name;
-		argData.getCommandArgument(0, Name);
+		Syntax.addFlag("-n", "-name", MSyntax::kString);
+		Syntax.addFlag("-o", "-open");
+		Syntax.addFlag("-c", "-close");
+		Syntax.addFlag("-sc", "-slotCount", MSyntax::kLong);
+		Syntax.addFlag("-ss", "-slotSize", MSyntax::kLong);
+		Syntax.addFlag("-rd", "-read", MSyntax::kDouble);
+		Syntax.addFlag("-r", "-reset");
 
-		FName SubjectFName(Name.asChar());
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkSharedMemory: invalid arguments");
 
-		MSelectionList selected;
-		MGlobal::getActiveSelectionList(selected);
+		MString Name("MayaLiveLink");
+		argData.getFlagArgument("-n", 0, Name);
+		const FString RegionName(UTF8_TO_TCHAR(Name.asChar()));
 
-		// Find selected joint
-		for (unsigned int i = 0; i < selected.length(); ++i)
+		double ReadSeconds;
+		if (argData.isFlagSet("-rd") && argData.getFlagArgument("-rd", 0, ReadSeconds) == MS::kSuccess)
 		{
-			MObject obj;
+			return ReadRing(RegionName, ReadSeconds);
+		}
 
-			selected.getDependNode(i, obj);
+		if (argData.isFlagSet("-c"))
+		{
+			LiveLinkSharedMemory::Writer.Close();
+		}
 
-			if (obj.hasFn(MFn::kJoint))
-			{
-				MFnIkJoint JointObject(obj);
-				MDagPath Path;
-				JointObject.getPath(Path);
-				LiveLinkStreamManager->AddJointHeirarchySubject(SubjectFName, Path);
-			}
-			else if (obj.hasFn(MFn::kCamera))
+		if (argData.isFlagSet("-o"))
+		{
+			int SlotCount = 64;
+			int SlotSize = 256 * 1024;
+			argData.getFlagArgument("-sc", 0, SlotCount);
+			argData.getFlagArgument("-ss", 0, SlotSize);
+			if (!LiveLinkSharedMemory::Writer.Open(RegionName, (uint32)FMath::Max(SlotCount, 0), (uint32)FMath::Max(SlotSize, 0)))
 			{
-				MFnCamera CameraObject(obj);
-				MDagPath Path;
-				CameraObject.getPath(Path);
-				LiveLinkStreamManager->AddCameraSubject(SubjectFName, Path);
+				MGlobal::displayError(MString("LiveLinkSharedMemory: unable to create shared memory region ") + Name);
+				return MS::kFailure;
 			}
-			else if(obj.hasFn(MFn::kTransform))
+		}
+
+		// Open, frames written, static updates written, megabytes written, records too large for a slot
+		appendToResult(LiveLinkSharedMemory::Writer.IsOpen() ? 1 : 0);
+		appendToResult((int)LiveLinkSharedMemory::Writer.GetFramesWritten());
+		appendToResult((int)LiveLinkSharedMemory::Writer.GetSubjectsWritten());
+		appendToResult(LiveLinkSharedMemory::Writer.GetBytesWritten() / (1024.0 * 1024.0));
+		appendToResult((int)LiveLinkSharedMemory::Writer.GetRecordsOversized());
+
+		if (argData.isFlagSet("-r"))
+		{
+			LiveLinkSharedMemory::Writer.ResetStats();
+		}
+		return MS::kSuccess;
+	}
+
+private:
+	/** Frames read, static updates read, records lost, records torn, mean latency in microseconds */
+	MStatus ReadRing(const FString& RegionName, double Seconds)
+	{
+		LiveLinkSharedMemory::FReader Reader;
+		if (!Reader.Open(RegionName))
+		{
+			MGlobal::displayError(MString("LiveLinkSharedMemory: no Live Link ring named ") + MString(*RegionName));
+			return MS::kFailure;
+		}
+
+		double LatencySum = 0.0;
+		const double EndTime = FPlatformTime::Seconds() + Seconds;
+		while (FPlatformTime::Seconds() < EndTime)
+		{
+			Reader.Poll([&LatencySum](const LiveLinkSharedMemory::FReader::FFrameView& View)
 			{
-				MFnTransform TransformNode(obj);
-				MDagPath Path;
-				TransformNode.getPath(Path);
-				LiveLinkStreamManager->AddPropSubject(SubjectFName, Path);
-			}
+				const double ReadTime = FPlatformTime::Seconds();
+				if (View.IsIntact())
+				{
+					LatencySum += ReadTime - View.Record.PublishTime;
+				}
+			});
+			FPlatformProcess::Sleep(0.001f);
 		}
 
-		MGlobal::displayInfo(MString("LiveLinkAddSubjectCommand ") + Name);
+		const uint64 FramesRead = Reader.GetFramesRead();
+		appendToResult((int)FramesRead);
+		appendToResult((int)Reader.GetSubjectsRead());
+		appendToResult((int)Reader.GetRecordsLost());
+		appendToResult((int)Reader.GetRecordsTorn());
+		appendToResult(FramesRead > 0 ? LatencySum / FramesRead * 1e6 : 0.0);
 		return MS::kSuccess;
 	}
 };
 
-const MString LiveLinkRemoveSubjectCommandName("LiveLinkRemoveSubject");
+/** Reads every use of a multi use string flag as FString patterns */
+void GetFlagPatterns(const MArgDatabase& argData, const char* Flag, TArray<FString>& OutPatterns)
+{
+	for (unsigned int Idx = 0; Idx < argData.numberOfFlagUses(Flag); ++Idx)
+	{
+		MArgList FlagArgs;
+		MString Pattern;
+		argData.getFlagArgumentList(Flag, Idx, FlagArgs);
+		FlagArgs.get(0, Pattern);
+		OutPatterns.Add(UTF8_TO_TCHAR(Pattern.asChar()));
+	}
+}
 
-class LiveLinkRemoveSubjectCommand : public MPxCommand
+const MString LiveLinkSetSubjectMaskCommandName("LiveLinkSetSubjectMask");
+
+/** Sets or removes the joint and curve mask of one of a character subject's LOD levels */
+class LiveLinkSetSubjectMaskCommand : public MPxCommand
 {
 public:
 	static void		cleanup() {}
-	static void*	creator() { return new LiveLinkRemoveSubjectCommand(); }
+	static void*	creator() { return new LiveLinkSetSubjectMaskCommand(); }
 
 	MStatus			doIt(const MArgList& args)
 	{
 		MSyntax Syntax;
-		Syntax.addArg(MSyntax::kString);
+		Syntax.addFlag("-s", "-subject", MSyntax::kString);
+		Syntax.addFlag("-l", "-level", MSyntax::kString);
+		Syntax.addFlag("-ij", "-includeJoint", MSyntax::kString);
+		Syntax.addFlag("-ej", "-excludeJoint", MSyntax::kString);
+		Syntax.addFlag("-ic", "-includeCurve", MSyntax::kString);
+		Syntax.addFlag("-ec", "-excludeCurve", MSyntax::kString);
+		Syntax.addFlag("-md", "-maxDepth", MSyntax::kLong);
+		Syntax.addFlag("-io", "-influencesOnly");
+		Syntax.addFlag("-rm", "-remove");
+		Syntax.makeFlagMultiUse("-ij");
+		Syntax.makeFlagMultiUse("-ej");
+		Syntax.makeFlagMultiUse("-ic");
+		Syntax.makeFlagMultiUse("-ec");
 
-		MArgDatabase argData(Syntax, args);
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkSetSubjectMask: invalid arguments");
 
-		MString SubjectToRemove;
-		argData.getCommandArgument(0, SubjectToRemove);
+		MString SubjectNameValue;
+		if (!argData.isFlagSet("-s") || argData.getFlagArgument("-s", 0, SubjectNameValue) != MS::kSuccess)
+		{
+			MGlobal::displayError("LiveLinkSetSubjectMask: -subject is required");
+			return MS::kInvalidParameter;
+		}
+		const FName SubjectName(SubjectNameValue.asChar());
+
+		// Without a level -remove drops all of the subject's levels
+		MString LevelValue;
+		const bool bHasLevel = argData.getFlagArgument("-l", 0, LevelValue) == MS::kSuccess && LevelValue.length() > 0;
+		const FName Level = bHasLevel ? FName(LevelValue.asChar()) : FName("default");
 
-		LiveLinkStreamManager->RemoveSubject(SubjectToRemove);
+		if (argData.isFlagSet("-rm"))
+		{
+			if (!SubjectLodRegistry.RemoveLevel(SubjectName, bHasLevel ? Level : NAME_None))
+			{
+				MGlobal::displayWarning(MString("LiveLinkSetSubjectMask: nothing to remove for ") + SubjectNameValue);
+			}
+		}
+		else
+		{
+			FLiveLinkJointMask Mask;
+			GetFlagPatterns(argData, "-ij", Mask.IncludeJoints);
+			GetFlagPatterns(argData, "-ej", Mask.ExcludeJoints);
+			GetFlagPatterns(argData, "-ic", Mask.IncludeCurves);
+			GetFlagPatterns(argData, "-ec", Mask.ExcludeCurves);
+			argData.getFlagArgument("-md", 0, Mask.MaxDepth);
+			Mask.bInfluencesOnly = argData.isFlagSet("-io");
+			SubjectLodRegistry.SetMask(SubjectName, Level, Mask);
+		}
 
+		QueueSubjectRevalidation(SubjectName);
+		setResult(MString(*SubjectLodRegistry.GetActiveLevel(SubjectName).ToString()));
 		return MS::kSuccess;
 	}
 };
 
-const MString LiveLinkConnectionStatusCommandName("LiveLinkConnectionStatus");
+const MString LiveLinkSetSubjectLodCommandName("LiveLinkSetSubjectLod");
 
-class LiveLinkConnectionStatusCommand : public MPxCommand
+/** Picks the LOD level a subject streams, an empty level streams every joint and curve */
+class LiveLinkSetSubjectLodCommand : public MPxCommand
 {
 public:
 	static void		cleanup() {}
-	static void*	creator() { return new LiveLinkConnectionStatusCommand(); }
+	static void*	creator() { return new LiveLinkSetSubjectLodCommand(); }
 
 	MStatus			doIt(const MArgList& args)
 	{
-		MString ConnectionStatus("No Provider (internal error)");
-		bool bConnection = false;
+		MSyntax Syntax;
+		Syntax.addFlag("-s", "-subject", MSyntax::kString);
+		Syntax.addFlag("-l", "-level", MSyntax::kString);
+		Syntax.makeFlagMultiUse("-s");
 
-		if(LiveLinkProvider.IsValid())
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkSetSubjectLod: invalid arguments");
+
+		MString LevelValue;
+		const bool bSetLevel = argData.getFlagArgument("-l", 0, LevelValue) == MS::kSuccess;
+		const FName Level = LevelValue.length() > 0 ? FName(LevelValue.asChar()) : NAME_None;
+
+		// Returns each subject's active level
+		for (unsigned int Idx = 0; Idx < argData.numberOfFlagUses("-s"); ++Idx)
 		{
-			if (LiveLinkProvider->HasConnection())
-			{
-				ConnectionStatus = "Connected";
-				bConnection = true;
-			}
-			else
+			MArgList FlagArgs;
+			MString SubjectNameValue;
+			argData.getFlagArgumentList("-s", Idx, FlagArgs);
+			FlagArgs.get(0, SubjectNameValue);
+			const FName SubjectName(SubjectNameValue.asChar());
+
+			if (bSetLevel && SubjectLodRegistry.GetActiveLevel(SubjectName) != Level)
 			{
-				ConnectionStatus = "No Connection";
+				if (SubjectLodRegistry.SetActiveLevel(SubjectName, Level))
+				{
+					QueueSubjectRevalidation(SubjectName);
+				}
+				else
+				{
+					MGlobal::displayWarning(MString("LiveLinkSetSubjectLod: ") + SubjectNameValue + " has no LOD level " + LevelValue);
+				}
 			}
-		}
-
-		appendToResult(ConnectionStatus);
-		appendToResult(bConnection);
 
+			const FName ActiveLevel = SubjectLodRegistry.GetActiveLevel(SubjectName);
+			appendToResult(ActiveLevel.IsNone() ? MString() : MString(*ActiveLevel.ToString()));
+		}
 		return MS::kSuccess;
 	}
 };
 
-const MString LiveLinkSetOptionCorrectForYUpCommandName("LiveLinkSetOptionCorrectForYUp");
+const MString LiveLinkSubjectLodsCommandName("LiveLinkSubjectLods");
 
-class LiveLinkSetOptionCorrectForYUpCommand : public MPxCommand
+/**
+* Lists a subject's LOD levels as level, joints streamed and active triplets as of the subject's last rebuild. The
+* first triplet is the unmasked subject with an empty level name.
+*/
+class LiveLinkSubjectLodsCommand : public MPxCommand
 {
 public:
-	static void	 cleanup() {}
-	static void* creator() { return new LiveLinkSetOptionCorrectForYUpCommand(); }
+	static void		cleanup() {}
+	static void*	creator() { return new LiveLinkSubjectLodsCommand(); }
 
-	MStatus	doIt(const MArgList& args)
+	MStatus			doIt(const MArgList& args)
 	{
 		MSyntax Syntax;
-		Syntax.addArg(MSyntax::kString);
+		Syntax.addFlag("-s", "-subject", MSyntax::kString);
 
-		MArgDatabase argData(Syntax, args);
+		MStatus Status;
+		MArgDatabase argData(Syntax, args, &Status);
+		MCHECKERROR(Status, "LiveLinkSubjectLods: invalid arguments");
 
-		argData.getCommandArgument(0, bCorrectForYUp);
-		MGlobal::displayInfo(MString("bCorrectForYUp: ") + bCorrectForYUp);
+		MString SubjectNameValue;
+		argData.getFlagArgument("-s", 0, SubjectNameValue);
+		const FName SubjectName(SubjectNameValue.asChar());
 
-		LiveLinkStreamManager->RebuildSubjects();
-		LiveLinkStreamManager->StreamSubjects();
+		const IStreamedEntity* Subject = LiveLinkStreamManager->FindSubject(SubjectName);
+		if (Subject == nullptr)
+		{
+			MGlobal::displayError(MString("LiveLinkSubjectLods: no subject named ") + SubjectNameValue);
+			return MS::kInvalidParameter;
+		}
 
+		TArray<TPair<FName, int32>> LodJointCounts;
+		int32 NumJoints = 0;
+		Subject->GetLodJointCounts(LodJointCounts, NumJoints);
+
+		const FName ActiveLevel = SubjectLodRegistry.GetActiveLevel(SubjectName);
+		appendToResult(MString());
+		appendToResult(NumJoints);
+		appendToResult(ActiveLevel.IsNone() ? 1 : 0);
+		for (const TPair<FName, int32>& LodJointCount : LodJointCounts)
+		{
+			appendToResult(MString(*LodJointCount.Key.ToString()));
+			appendToResult(LodJointCount.Value);
+			appendToResult(LodJointCount.Key == ActiveLevel ? 1 : 0);
+		}
 		return MS::kSuccess;
 	}
 };
 
 void OnForceChange(MTime& time, void* clientData)
 {
-	LiveLinkStreamManager->StreamSubjects();
+	if (!StreamClock.IsActive())
+	{
+		StreamScheduler.RequestStream();
+	}
 }
 
 class FMayaOutputDevice : public FOutputDevice
@@ -895,6 +7424,7 @@ private:
 void OnScenePreOpen(void* client)
 {
 	LiveLinkStreamManager->Reset();
+	StreamScheduler.Reset();
 	RefreshUI();
 }
 
@@ -909,7 +7439,7 @@ void AllDagChangesCallback(
 	MDagPath &parent,
 	void *clientData)
 {
-	LiveLinkStreamManager->RebuildSubjects();
+	LiveLinkStreamManager->QueueRebuildsAffectedBy(child, parent);
 }
 
 void OnConnectionStatusChanged()
@@ -922,9 +7452,19 @@ void OnConnectionStatusChanged()
 TMap<uintptr_t, MCallbackId> PostRenderCallbackIds;
 TMap<uintptr_t, MCallbackId> ViewportDeletedCallbackIds;
 
+TMap<uintptr_t, MCallbackId> CameraChangedCallbackIds;
+
 void OnPostRenderViewport(const MString &str, void* ClientData)
 {
-	LiveLinkStreamManager->StreamSubjects();
+	if (!StreamClock.IsActive())
+	{
+		StreamScheduler.RequestStream();
+	}
+}
+
+void OnViewportCameraChanged(const MString& PanelName, MObject& Camera, void* ClientData)
+{
+	MarkActiveCameraDirty();
 }
 
 void OnViewportClosed(void* ClientData)
@@ -936,6 +7476,13 @@ void OnViewportClosed(void* ClientData)
 
 	MMessage::removeCallback(ViewportDeletedCallbackIds[ViewIndex]);
 	ViewportDeletedCallbackIds.Remove(ViewIndex);
+
+	// The camera changed callback is registered last, so a panel that failed part way through registration has none
+	MCallbackId CameraChangedCallbackId;
+	if (CameraChangedCallbackIds.RemoveAndCopyValue(ViewIndex, CameraChangedCallbackId))
+	{
+		MMessage::removeCallback(CameraChangedCallbackId);
+	}
 }
 
 void ClearViewportCallbacks()
@@ -951,6 +7498,12 @@ void ClearViewportCallbacks()
 		MMessage::removeCallback(Pair.Value);
 	}
 	ViewportDeletedCallbackIds.Reset();
+
+	for (TPair<uintptr_t, MCallbackId>& Pair : CameraChangedCallbackIds)
+	{
+		MMessage::removeCallback(Pair.Value);
+	}
+	CameraChangedCallbackIds.Reset();
 }
 
 MStatus RefreshViewportCallbacks()
@@ -994,6 +7547,17 @@ MStatus RefreshViewportCallbacks()
 					continue;
 				}
 				ViewportDeletedCallbackIds.Add(i, CallbackId);
+
+				CallbackId = MUiMessage::addCameraChangedCallback(EditorPanels[i], OnViewportCameraChanged, NULL, &Status);
+
+				MREPORTERROR(Status, "MUiMessage::addCameraChangedCallback()");
+
+				if (Status != MStatus::kSuccess)
+				{
+					ExitStatus = MStatus::kFailure;
+					continue;
+				}
+				CameraChangedCallbackIds.Add(i, CallbackId);
 			}
 		}
 	}
@@ -1034,6 +7598,8 @@ DLLEXPORT MStatus initializePlugin(MObject MayaPluginObject)
 		GLog->TearDown(); //clean up existing output devices
 		GLog->AddOutputDevice(new FMayaOutputDevice()); //Add Maya output device
 
+		GMalloc = new LiveLinkAllocations::FCountingMalloc(GMalloc); //Count stream path allocations
+
 		bUEInitialized = true; // Dont redo this part if someone unloads and reloads our plugin
 	}
 
@@ -1044,6 +7610,7 @@ DLLEXPORT MStatus initializePlugin(MObject MayaPluginObject)
 		"v1.0");
 
 	LiveLinkProvider = ILiveLinkProvider::CreateLiveLinkProvider(TEXT("Maya Live Link"));
+	EndpointHub.SetPrimaryProvider(LiveLinkProvider, TEXT("Maya Live Link"));
 	ConnectionStatusChangedHandle = LiveLinkProvider->RegisterConnStatusChangedHandle(FLiveLinkProviderConnectionStatusChanged::FDelegate::CreateStatic(&OnConnectionStatusChanged));
 
 	// We do not tick the core engine but we need to tick the ticker to make sure the message bus endpoint in LiveLinkProvider is
@@ -1066,6 +7633,10 @@ DLLEXPORT MStatus initializePlugin(MObject MayaPluginObject)
 	MCallbackId dagChangedCallbackId = MDagMessage::addAllDagChangesCallback(AllDagChangesCallback);
 	myCallbackIds.append(dagChangedCallbackId);
 
+	// Switching the focused panel changes the active camera without dirtying anything
+	MCallbackId panelFocusCallbackId = MEventMessage::addEventCallback("ModelPanelSetFocus", (MMessage::MBasicFunction)MarkActiveCameraDirty);
+	myCallbackIds.append(panelFocusCallbackId);
+
 	// Update function every 5 seconds
 	MCallbackId timerCallback = MTimerMessage::addTimerCallback(5.f, (MMessage::MElapsedTimeFunction)OnInterval);
 	myCallbackIds.append(timerCallback);
@@ -1075,6 +7646,31 @@ DLLEXPORT MStatus initializePlugin(MObject MayaPluginObject)
 	MayaPlugin.registerCommand(LiveLinkRemoveSubjectCommandName, LiveLinkRemoveSubjectCommand::creator);
 	MayaPlugin.registerCommand(LiveLinkConnectionStatusCommandName, LiveLinkConnectionStatusCommand::creator);
 	MayaPlugin.registerCommand(LiveLinkSetOptionCorrectForYUpCommandName, LiveLinkSetOptionCorrectForYUpCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkSetOptionDeltaStreamingCommandName, LiveLinkSetOptionDeltaStreamingCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkStreamSchedulerCountersCommandName, LiveLinkStreamSchedulerCountersCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkRebuildCountersCommandName, LiveLinkRebuildCountersCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkSetOptionAsyncStreamingCommandName, LiveLinkSetOptionAsyncStreamingCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkSetOptionParallelEvaluationCommandName, LiveLinkSetOptionParallelEvaluationCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkStreamRangeCommandName, LiveLinkStreamRangeCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkRecordTakeCommandName, LiveLinkRecordTakeCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkReplayTakeCommandName, LiveLinkReplayTakeCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkBenchmarkCommandName, LiveLinkBenchmarkCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkStatsCommandName, LiveLinkStatsCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkSetOptionStreamRateCommandName, LiveLinkSetOptionStreamRateCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkAllocationCountersCommandName, LiveLinkAllocationCountersCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkSetSubjectEncodingCommandName, LiveLinkSetSubjectEncodingCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkAddSubjectsCommandName, LiveLinkAddSubjectsCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkRemoveSubjectsCommandName, LiveLinkRemoveSubjectsCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkEndpointsCommandName, LiveLinkEndpointsCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkResyncSubjectsCommandName, LiveLinkResyncSubjectsCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkSetOptionVerbosityCommandName, LiveLinkSetOptionVerbosityCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkAddCurveSourcesCommandName, LiveLinkAddCurveSourcesCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkRemoveCurveSourcesCommandName, LiveLinkRemoveCurveSourcesCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkCurveSourcesCommandName, LiveLinkCurveSourcesCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkSharedMemoryCommandName, LiveLinkSharedMemoryCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkSetSubjectMaskCommandName, LiveLinkSetSubjectMaskCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkSetSubjectLodCommandName, LiveLinkSetSubjectLodCommand::creator);
+	MayaPlugin.registerCommand(LiveLinkSubjectLodsCommandName, LiveLinkSubjectLodsCommand::creator);
 
 	// Print to Maya's output window, too!
 	UE_LOG(LogBlankMayaPlugin, Display, TEXT("MayaLiveLinkPlugin initialized"));
@@ -1105,12 +7701,52 @@ DLLEXPORT MStatus uninitializePlugin(MObject MayaPluginObject)
 		// Make sure we remove all the callbacks we added
 		MMessage::removeCallbacks(myCallbackIds);
 	}
+	ClearViewportCallbacks();
+	LiveLinkStreamManager->CancelPendingRebuilds();
 
 	MayaPlugin.deregisterCommand(LiveLinkSubjectsCommandName);
 	MayaPlugin.deregisterCommand(LiveLinkAddSubjectCommandName);
 	MayaPlugin.deregisterCommand(LiveLinkRemoveSubjectCommandName);
 	MayaPlugin.deregisterCommand(LiveLinkConnectionStatusCommandName);
 	MayaPlugin.deregisterCommand(LiveLinkSetOptionCorrectForYUpCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkSetOptionDeltaStreamingCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkStreamSchedulerCountersCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkRebuildCountersCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkSetOptionAsyncStreamingCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkSetOptionParallelEvaluationCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkStreamRangeCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkRecordTakeCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkReplayTakeCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkBenchmarkCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkStatsCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkSetOptionStreamRateCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkAllocationCountersCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkSetSubjectEncodingCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkAddSubjectsCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkRemoveSubjectsCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkEndpointsCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkResyncSubjectsCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkSetOptionVerbosityCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkAddCurveSourcesCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkRemoveCurveSourcesCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkCurveSourcesCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkSharedMemoryCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkSetSubjectMaskCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkSetSubjectLodCommandName);
+	MayaPlugin.deregisterCommand(LiveLinkSubjectLodsCommandName);
+
+	StreamClock.Stop();
+	TakeReplayJob.Cancel();
+
+	// The worker publishes through the provider, stop it first
+	StreamPipeline.SetAsync(false, StreamPipeline.GetDepth());
+
+	// Subjects remove their node callbacks as they go, Maya must not call into the plugin once it is unloaded
+	LiveLinkStreamManager.Reset();
+
+	TakeRecorder.Stop();
+	EndpointHub.RemoveAllEndpoints(true);
+	LiveLinkSharedMemory::Writer.Close();
 
 	if (ConnectionStatusChangedHandle.IsValid())
 	{
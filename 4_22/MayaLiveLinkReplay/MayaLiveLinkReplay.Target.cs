@@ -0,0 +1,20 @@
+﻿// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+using UnrealBuildTool;
+
+[SupportedPlatforms(UnrealPlatformClass.Desktop)]
+public class MayaLiveLinkReplayTarget : TargetRules
+{
+	public MayaLiveLinkReplayTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Program;
+		LinkType = TargetLinkType.Monolithic;
+		LaunchModuleName = "MayaLiveLinkReplay";
+
+		// Console program that streams over the message bus like the plugin does
+		bCompileAgainstEngine = false;
+		bCompileAgainstCoreUObject = true;
+		bBuildDeveloperTools = false;
+		bCompileICU = false;
+		bIsBuildingConsoleApplication = true;
+	}
+}
@@ -0,0 +1,187 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "RequiredProgramMainCPPInclude.h"
+#include "Modules/ModuleManager.h"
+#include "UObject/Object.h"
+#include "Containers/Ticker.h"
+#include "LiveLinkProvider.h"
+
+#include "LiveLinkTake.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogMayaLiveLinkReplay, Log, All);
+
+IMPLEMENT_APPLICATION(MayaLiveLinkReplay, "MayaLiveLinkReplay");
+
+/**
+* Replays a take recorded with LiveLinkRecordTake without Maya, to reproduce a streaming session or load test Unreal.
+*
+*	MayaLiveLinkReplay -take=<file> [-start=<frame>] [-end=<frame>] [-speed=<scale, 0 for as fast as possible>]
+*		[-loops=<count>] [-provider=<name>] [-wait=<seconds to wait for a connection>] [-local]
+*
+* Frames go out through a Live Link provider over the message bus, or with -local to a stand-in receiver that only
+* touches the decoded values, for measuring replay itself. Ctrl-C stops the replay after the current frame.
+*/
+namespace MayaLiveLinkReplay
+{
+	/** Stands in for a provider, reads every value like a receiver applying the frame would */
+	struct FLocalReceiver
+	{
+		uint64 SubjectsReceived = 0;
+		uint64 FramesReceived = 0;
+		uint64 ValuesReceived = 0;
+		double Sum = 0.0;
+
+		void ReceiveSubject(const TArray<FName>& BoneNames, const TArray<int32>& BoneParents)
+		{
+			++SubjectsReceived;
+			for (int32 Parent : BoneParents)
+			{
+				Sum += Parent;
+			}
+		}
+
+		void ReceiveFrame(const TArray<FTransform>& Transforms, const TArray<FLiveLinkCurveElement>& Curves)
+		{
+			++FramesReceived;
+			for (const FTransform& Transform : Transforms)
+			{
+				Sum += Transform.GetRotation().W + Transform.GetTranslation().X + Transform.GetScale3D().X;
+			}
+			for (const FLiveLinkCurveElement& Curve : Curves)
+			{
+				Sum += Curve.CurveValue;
+			}
+			ValuesReceived += Transforms.Num() * LiveLinkTake::FloatsPerTransform + Curves.Num();
+		}
+	};
+
+	/** The message bus endpoint is only up to date when the ticker runs, there's no engine loop to do it */
+	void TickIfDue(double& LastTickTime)
+	{
+		const double TickInterval = 0.1;
+		const double Now = FPlatformTime::Seconds();
+		if (Now - LastTickTime >= TickInterval)
+		{
+			FTicker::GetCoreTicker().Tick((float)(Now - LastTickTime));
+			LastTickTime = Now;
+		}
+	}
+
+	int32 Run()
+	{
+		FString TakeFilename;
+		if (!FParse::Value(FCommandLine::Get(), TEXT("-take="), TakeFilename))
+		{
+			UE_LOG(LogMayaLiveLinkReplay, Error, TEXT("Usage: MayaLiveLinkReplay -take=<file> [-start=<frame>] [-end=<frame>] [-speed=<scale>] [-loops=<count>] [-provider=<name>] [-wait=<seconds>] [-local]"));
+			return 1;
+		}
+
+		FLiveLinkTakeReader Reader;
+		FString Error;
+		if (!Reader.Open(TakeFilename, Error))
+		{
+			UE_LOG(LogMayaLiveLinkReplay, Error, TEXT("%s"), *Error);
+			return 1;
+		}
+
+		int32 StartFrame = 0;
+		int32 EndFrame = Reader.GetNumFrames() - 1;
+		float Speed = 1.f;
+		int32 NumLoops = 1;
+		float ConnectionWait = 0.f;
+		FString ProviderName = TEXT("Maya Live Link Replay");
+		FParse::Value(FCommandLine::Get(), TEXT("-start="), StartFrame);
+		FParse::Value(FCommandLine::Get(), TEXT("-end="), EndFrame);
+		FParse::Value(FCommandLine::Get(), TEXT("-speed="), Speed);
+		FParse::Value(FCommandLine::Get(), TEXT("-loops="), NumLoops);
+		FParse::Value(FCommandLine::Get(), TEXT("-wait="), ConnectionWait);
+		FParse::Value(FCommandLine::Get(), TEXT("-provider="), ProviderName);
+		const bool bLocal = FParse::Param(FCommandLine::Get(), TEXT("local"));
+
+		FLocalReceiver LocalReceiver;
+		TSharedPtr<ILiveLinkProvider> Provider;
+		double LastTickTime = FPlatformTime::Seconds();
+		if (!bLocal)
+		{
+			Provider = ILiveLinkProvider::CreateLiveLinkProvider(ProviderName);
+
+			const double WaitEndTime = FPlatformTime::Seconds() + ConnectionWait;
+			while (!Provider->HasConnection() && FPlatformTime::Seconds() < WaitEndTime && !GIsRequestingExit)
+			{
+				TickIfDue(LastTickTime);
+				FPlatformProcess::Sleep(0.01f);
+			}
+			UE_LOG(LogMayaLiveLinkReplay, Display, TEXT("Provider '%s' %s"), *ProviderName, Provider->HasConnection() ? TEXT("connected") : TEXT("not connected yet"));
+		}
+
+		FLiveLinkTakeReplay Replay;
+		int32 FramesReplayed = 0;
+		const double ReplayStartTime = FPlatformTime::Seconds();
+
+		for (int32 Loop = 0; Loop < NumLoops && !GIsRequestingExit; ++Loop)
+		{
+			Replay.Reset();
+			FramesReplayed += Replay.Run(Reader, StartFrame, EndFrame, Speed,
+				[&](FName SubjectName, const TArray<FName>& BoneNames, const TArray<int32>& BoneParents)
+				{
+					if (bLocal)
+					{
+						LocalReceiver.ReceiveSubject(BoneNames, BoneParents);
+					}
+					else
+					{
+						Provider->UpdateSubject(SubjectName, BoneNames, BoneParents);
+					}
+				},
+				[&](FName SubjectName, const TArray<FTransform>& Transforms, const TArray<FLiveLinkCurveElement>& Curves, double ReplayTime)
+				{
+					if (bLocal)
+					{
+						LocalReceiver.ReceiveFrame(Transforms, Curves);
+					}
+					else
+					{
+						Provider->UpdateSubjectFrame(SubjectName, Transforms, Curves, ReplayTime);
+						TickIfDue(LastTickTime);
+					}
+
+					if (GIsRequestingExit)
+					{
+						Replay.Cancel();
+					}
+				});
+		}
+
+		const double ReplaySeconds = FPlatformTime::Seconds() - ReplayStartTime;
+		const double FramesPerSecond = ReplaySeconds > 0.0 ? FramesReplayed / ReplaySeconds : 0.0;
+		UE_LOG(LogMayaLiveLinkReplay, Display, TEXT("%d frames in %.3fs (%.1f fps)%s"), FramesReplayed, ReplaySeconds, FramesPerSecond, GIsRequestingExit ? TEXT(", cancelled") : TEXT(""));
+		if (bLocal)
+		{
+			UE_LOG(LogMayaLiveLinkReplay, Display, TEXT("Local receiver: %llu static updates, %llu frames, %llu values (checksum %g)"),
+				LocalReceiver.SubjectsReceived, LocalReceiver.FramesReceived, LocalReceiver.ValuesReceived, LocalReceiver.Sum);
+		}
+
+		if (Provider.IsValid())
+		{
+			// Let the last frames and the provider's goodbye go out
+			FTicker::GetCoreTicker().Tick(1.f);
+			Provider.Reset();
+		}
+		return 0;
+	}
+}
+
+INT32_MAIN_INT32_ARGC_TCHAR_ARGV()
+{
+	GEngineLoop.PreInit(ArgC, ArgV, TEXT(" -Messaging"));
+	ProcessNewlyLoadedUObjects();
+	FModuleManager::Get().StartProcessingNewlyLoadedObjects();
+	FModuleManager::Get().LoadModule(TEXT("UdpMessaging"));
+
+	const int32 Result = MayaLiveLinkReplay::Run();
+
+	FEngineLoop::AppPreExit();
+	FModuleManager::Get().UnloadModulesAtShutdown();
+	FEngineLoop::AppExit();
+	return Result;
+}
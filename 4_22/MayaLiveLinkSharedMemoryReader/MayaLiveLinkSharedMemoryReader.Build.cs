@@ -0,0 +1,27 @@
+﻿// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+using System.IO;
+using UnrealBuildTool;
+
+public class MayaLiveLinkSharedMemoryReader : ModuleRules
+{
+	public MayaLiveLinkSharedMemoryReader(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PublicIncludePaths.Add("Runtime/Launch/Public");
+		PrivateIncludePaths.Add("Runtime/Launch/Private");
+
+		// The plugin's Maya-free headers
+		PrivateIncludePaths.Add(Path.Combine(ModuleDirectory, ".."));
+
+		PrivateDependencyModuleNames.AddRange(new string[]
+		{
+			"Core",
+			"CoreUObject",
+			"Projects",
+			"Messaging",
+			"MessagingCommon",
+			"UdpMessaging",
+			"LiveLinkInterface",
+			"LiveLinkMessageBusFramework",
+		});
+	}
+}
@@ -0,0 +1,20 @@
+﻿// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+using UnrealBuildTool;
+
+[SupportedPlatforms(UnrealPlatformClass.Desktop)]
+public class MayaLiveLinkSharedMemoryReaderTarget : TargetRules
+{
+	public MayaLiveLinkSharedMemoryReaderTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Program;
+		LinkType = TargetLinkType.Monolithic;
+		LaunchModuleName = "MayaLiveLinkSharedMemoryReader";
+
+		// Console program that listens on the message bus like the editor's Live Link client does
+		bCompileAgainstEngine = false;
+		bCompileAgainstCoreUObject = true;
+		bBuildDeveloperTools = false;
+		bCompileICU = false;
+		bIsBuildingConsoleApplication = true;
+	}
+}
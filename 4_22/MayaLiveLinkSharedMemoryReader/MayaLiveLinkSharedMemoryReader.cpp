@@ -0,0 +1,260 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "RequiredProgramMainCPPInclude.h"
+#include "Modules/ModuleManager.h"
+#include "UObject/Object.h"
+#include "Containers/Ticker.h"
+#include "Misc/ScopeLock.h"
+#include "MessageEndpoint.h"
+#include "MessageEndpointBuilder.h"
+#include "LiveLinkMessages.h"
+
+#include "LiveLinkSharedMemory.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogMayaLiveLinkSharedMemoryReader, Log, All);
+
+IMPLEMENT_APPLICATION(MayaLiveLinkSharedMemoryReader, "MayaLiveLinkSharedMemoryReader");
+
+/**
+* Attaches to the plugin's shared memory ring from another process, the way a reader in the editor would, and reports
+* its latency and throughput next to the same stream arriving over the message bus through UDP.
+*
+*	MayaLiveLinkSharedMemoryReader [-region=<name>] [-seconds=<duration>] [-provider=<name>] [-noudp]
+*
+* The plugin has to be streaming live with the ring open (LiveLinkSharedMemory -open). Latency is measured from the
+* frame's stream time, which live streaming takes from FPlatformTime::Seconds() at capture and which is comparable
+* between processes on the same machine, so both transports are measured from the same point. The ring's latency from
+* its publish time is reported too, for the transport alone. Ctrl-C stops early and still reports.
+*/
+namespace MayaLiveLinkSharedMemoryReader
+{
+	/** Latencies of one transport, in microseconds */
+	struct FLatencies
+	{
+		// Keeps memory bounded on long runs, later frames still count towards the rate
+		static const int32 MaxSamples = 4 * 1024 * 1024;
+
+		TArray<float> SamplesUs;
+		uint64 NumFrames = 0;
+
+		void Add(double Seconds)
+		{
+			++NumFrames;
+			if (SamplesUs.Num() < MaxSamples)
+			{
+				SamplesUs.Add((float)(Seconds * 1e6));
+			}
+		}
+
+		FString GetSummary(double Duration)
+		{
+			if (SamplesUs.Num() == 0)
+			{
+				return TEXT("no frames");
+			}
+
+			SamplesUs.Sort();
+			auto Percentile = [this](float Fraction)
+			{
+				return SamplesUs[FMath::Clamp((int32)(Fraction * SamplesUs.Num()), 0, SamplesUs.Num() - 1)];
+			};
+			return FString::Printf(TEXT("%llu frames (%.1f fps), latency p50 %.1fus p95 %.1fus p99 %.1fus max %.1fus"),
+				NumFrames, Duration > 0.0 ? NumFrames / Duration : 0.0, Percentile(0.5f), Percentile(0.95f), Percentile(0.99f), SamplesUs.Last());
+		}
+	};
+
+	/**
+	* Connects to the provider like the editor's Live Link message bus source does: pings until the provider answers,
+	* connects to it and keeps the connection alive with heartbeats. Frames arrive on the message bus' thread.
+	*/
+	class FUdpReceiver
+	{
+	public:
+		explicit FUdpReceiver(const FString& InProviderName)
+			: ProviderName(InProviderName)
+			, PollRequest(FGuid::NewGuid())
+			, NextPingTime(0.0)
+			, NextHeartbeatTime(0.0)
+		{
+			MessageEndpoint = FMessageEndpoint::Builder(TEXT("MayaLiveLinkSharedMemoryReader"))
+				.ReceivingOnAnyThread()
+				.Handling<FLiveLinkPongMessage>(this, &FUdpReceiver::HandlePong)
+				.Handling<FLiveLinkSubjectFrameMessage>(this, &FUdpReceiver::HandleFrame);
+		}
+
+		~FUdpReceiver()
+		{
+			FMessageEndpoint::SafeRelease(MessageEndpoint);
+		}
+
+		bool IsValid() const { return MessageEndpoint.IsValid(); }
+
+		bool IsConnected() const
+		{
+			FScopeLock Lock(&CriticalSection);
+			return ProviderAddress.IsValid();
+		}
+
+		/** Pings until connected, then sends heartbeats */
+		void Tick(double Now)
+		{
+			if (!IsConnected())
+			{
+				if (Now >= NextPingTime)
+				{
+					MessageEndpoint->Publish(new FLiveLinkPingMessage(PollRequest));
+					NextPingTime = Now + 1.0;
+				}
+			}
+			else if (Now >= NextHeartbeatTime)
+			{
+				FScopeLock Lock(&CriticalSection);
+				MessageEndpoint->Send(new FLiveLinkHeartbeatMessage(), ProviderAddress);
+				NextHeartbeatTime = Now + 1.0;
+			}
+		}
+
+		/** Stops counting and hands over the latencies */
+		FLatencies TakeLatencies()
+		{
+			FScopeLock Lock(&CriticalSection);
+			return MoveTemp(Latencies);
+		}
+
+	private:
+		void HandlePong(const FLiveLinkPongMessage& Message, const TSharedRef<IMessageContext, ESPMode::ThreadSafe>& Context)
+		{
+			FScopeLock Lock(&CriticalSection);
+			if (Message.PollRequest == PollRequest && Message.ProviderName == ProviderName && !ProviderAddress.IsValid())
+			{
+				ProviderAddress = Context->GetSender();
+				MessageEndpoint->Send(new FLiveLinkConnectMessage(), ProviderAddress);
+				UE_LOG(LogMayaLiveLinkSharedMemoryReader, Display, TEXT("Connected to '%s' on %s"), *Message.ProviderName, *Message.MachineName);
+			}
+		}
+
+		void HandleFrame(const FLiveLinkSubjectFrameMessage& Message, const TSharedRef<IMessageContext, ESPMode::ThreadSafe>& Context)
+		{
+			const double Now = FPlatformTime::Seconds();
+			FScopeLock Lock(&CriticalSection);
+			Latencies.Add(Now - Message.Time);
+		}
+
+		FString ProviderName;
+		FGuid PollRequest;
+		TSharedPtr<FMessageEndpoint, ESPMode::ThreadSafe> MessageEndpoint;
+
+		mutable FCriticalSection CriticalSection;
+		FMessageAddress ProviderAddress;
+		FLatencies Latencies;
+
+		double NextPingTime;
+		double NextHeartbeatTime;
+	};
+
+	int32 Run()
+	{
+		FString RegionName = TEXT("MayaLiveLink");
+		float Seconds = 10.f;
+		FString ProviderName = TEXT("Maya Live Link");
+		FParse::Value(FCommandLine::Get(), TEXT("-region="), RegionName);
+		FParse::Value(FCommandLine::Get(), TEXT("-seconds="), Seconds);
+		FParse::Value(FCommandLine::Get(), TEXT("-provider="), ProviderName);
+		const bool bUdp = !FParse::Param(FCommandLine::Get(), TEXT("noudp"));
+
+		TUniquePtr<FUdpReceiver> UdpReceiver;
+		if (bUdp)
+		{
+			UdpReceiver = MakeUnique<FUdpReceiver>(ProviderName);
+			if (!UdpReceiver->IsValid())
+			{
+				UE_LOG(LogMayaLiveLinkSharedMemoryReader, Warning, TEXT("The message bus isn't available, only reading shared memory"));
+				UdpReceiver.Reset();
+			}
+		}
+
+		LiveLinkSharedMemory::FReader Reader;
+		FLatencies RingLatencies;
+		FLatencies RingPublishLatencies;
+		TArray<FTransform> DecodedTransforms;
+		TArray<FLiveLinkCurveElement> DecodedCurves;
+		float Checksum = 0.0f;
+
+		const double StartTime = FPlatformTime::Seconds();
+		const double EndTime = StartTime + Seconds;
+		double NextOpenTime = 0.0;
+		double LastTickTime = StartTime;
+		for (double Now = StartTime; Now < EndTime && !GIsRequestingExit; Now = FPlatformTime::Seconds())
+		{
+			// The plugin may open the ring after we start
+			if (!Reader.IsOpen() && Now >= NextOpenTime)
+			{
+				if (Reader.Open(RegionName))
+				{
+					UE_LOG(LogMayaLiveLinkSharedMemoryReader, Display, TEXT("Attached to shared memory ring '%s'"), *RegionName);
+				}
+				NextOpenTime = Now + 0.5;
+			}
+
+			Reader.Poll([&](const LiveLinkSharedMemory::FReader::FFrameView& View)
+			{
+				// Decoded like a consumer applying the frame would, so the ring's latency includes getting at the values
+				const double ReadTime = FPlatformTime::Seconds();
+				if (!View.Decode(DecodedTransforms, DecodedCurves))
+				{
+					// Torn or undecodable, the record's times can't be trusted either
+					return;
+				}
+				if (DecodedTransforms.Num() > 0)
+				{
+					Checksum += DecodedTransforms[0].GetTranslation().X;
+				}
+				RingLatencies.Add(ReadTime - View.Record.StreamTime);
+				RingPublishLatencies.Add(ReadTime - View.Record.PublishTime);
+			});
+
+			if (UdpReceiver.IsValid())
+			{
+				UdpReceiver->Tick(Now);
+			}
+			if (Now - LastTickTime >= 0.1)
+			{
+				// The message bus endpoint is only up to date when the ticker runs, there's no engine loop to do it
+				FTicker::GetCoreTicker().Tick((float)(Now - LastTickTime));
+				LastTickTime = Now;
+			}
+
+			// Spin like the in-process benchmark's reader, a reader in the editor would be woken by its own tick instead
+			FPlatformProcess::Sleep(0.f);
+		}
+
+		const double Duration = FPlatformTime::Seconds() - StartTime;
+		UE_LOG(LogMayaLiveLinkSharedMemoryReader, Display, TEXT("Shared memory: %s"), *RingLatencies.GetSummary(Duration));
+		UE_LOG(LogMayaLiveLinkSharedMemoryReader, Display, TEXT("Shared memory from publish: %s"), *RingPublishLatencies.GetSummary(Duration));
+		UE_LOG(LogMayaLiveLinkSharedMemoryReader, Display, TEXT("Shared memory: %llu static updates, %llu records lost, %llu records torn (checksum %g)"),
+			Reader.GetSubjectsRead(), Reader.GetRecordsLost(), Reader.GetRecordsTorn(), Checksum);
+		if (UdpReceiver.IsValid())
+		{
+			const bool bConnected = UdpReceiver->IsConnected();
+			FLatencies UdpLatencies = UdpReceiver->TakeLatencies();
+			UE_LOG(LogMayaLiveLinkSharedMemoryReader, Display, TEXT("UDP: %s%s"), *UdpLatencies.GetSummary(Duration), bConnected ? TEXT("") : *FString::Printf(TEXT(", never connected to '%s'"), *ProviderName));
+		}
+
+		return Reader.GetFramesRead() > 0 ? 0 : 1;
+	}
+}
+
+INT32_MAIN_INT32_ARGC_TCHAR_ARGV()
+{
+	GEngineLoop.PreInit(ArgC, ArgV, TEXT(" -Messaging"));
+	ProcessNewlyLoadedUObjects();
+	FModuleManager::Get().StartProcessingNewlyLoadedObjects();
+	FModuleManager::Get().LoadModule(TEXT("UdpMessaging"));
+
+	const int32 Result = MayaLiveLinkSharedMemoryReader::Run();
+
+	FEngineLoop::AppPreExit();
+	FModuleManager::Get().UnloadModulesAtShutdown();
+	FEngineLoop::AppExit();
+	return Result;
+}
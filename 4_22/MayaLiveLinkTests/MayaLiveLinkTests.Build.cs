@@ -0,0 +1,25 @@
+﻿// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+using System.IO;
+using UnrealBuildTool;
+
+// Gets Maya's devkit the same way the plugin does, the joint math is checked against MTransformationMatrix
+public class MayaLiveLinkTests : MayaLiveLinkPluginBase
+{
+	public MayaLiveLinkTests(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PublicIncludePaths.Add("Runtime/Launch/Public");
+		PrivateIncludePaths.Add("Runtime/Launch/Private");
+
+		// The plugin's Maya-free headers
+		PrivateIncludePaths.Add(Path.Combine(ModuleDirectory, ".."));
+
+		PrivateDependencyModuleNames.AddRange(new string[]
+		{
+			"Core",
+			"CoreUObject",
+			"LiveLinkInterface",
+		});
+	}
+
+	public override string GetMayaVersion() { return "2015"; }
+}
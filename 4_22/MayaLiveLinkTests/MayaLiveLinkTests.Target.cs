@@ -0,0 +1,20 @@
+﻿// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+using UnrealBuildTool;
+
+[SupportedPlatforms(UnrealPlatformClass.Desktop)]
+public class MayaLiveLinkTestsTarget : TargetRules
+{
+	public MayaLiveLinkTestsTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Program;
+		LinkType = TargetLinkType.Monolithic;
+		LaunchModuleName = "MayaLiveLinkTests";
+
+		// Console program, Maya's libraries are only linked for reference values
+		bCompileAgainstEngine = false;
+		bCompileAgainstCoreUObject = true;
+		bBuildDeveloperTools = false;
+		bCompileICU = false;
+		bIsBuildingConsoleApplication = true;
+	}
+}
@@ -0,0 +1,540 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "RequiredProgramMainCPPInclude.h"
+#include "Math/RandomStream.h"
+
+#include "LiveLinkFrameCodec.h"
+#include "LiveLinkJointMath.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogMayaLiveLinkTests, Log, All);
+
+IMPLEMENT_APPLICATION(MayaLiveLinkTests, "MayaLiveLinkTests");
+
+// Maya includes, see MayaLiveLinkPlugin.cpp
+#ifndef BananaFritters
+#define BananaFritters unsigned int
+#endif
+
+#define DWORD BananaFritters
+
+#include <maya/MLibrary.h>
+#include <maya/MMatrix.h>
+#include <maya/MTransformationMatrix.h>
+#include <maya/MVector.h>
+
+#include "LiveLinkMatrixDecomposition.h"
+#undef DWORD
+
+/**
+* Standalone checks of the plugin's Maya-free code, against Maya's own math where there is a Maya equivalent. Every
+* test logs what it measured and returns false on failure, the process exits with the number of failed tests.
+*/
+namespace MayaLiveLinkTests
+{
+	struct FTest
+	{
+		const TCHAR* Name;
+		bool (*Run)();
+	};
+
+	/** Angle between two rotations in degrees, in double since FQuat::AngularDistance can't resolve tiny angles */
+	double RotationErrorDegrees(const FQuat& A, const FQuat& B)
+	{
+		const double Dot = (double)A.X * B.X + (double)A.Y * B.Y + (double)A.Z * B.Z + (double)A.W * B.W;
+		const double CrossX = (double)A.W * B.X - (double)A.X * B.W - (double)A.Y * B.Z + (double)A.Z * B.Y;
+		const double CrossY = (double)A.W * B.Y + (double)A.X * B.Z - (double)A.Y * B.W - (double)A.Z * B.X;
+		const double CrossZ = (double)A.W * B.Z - (double)A.X * B.Y + (double)A.Y * B.X - (double)A.Z * B.W;
+		const double Imaginary = FMath::Sqrt(CrossX * CrossX + CrossY * CrossY + CrossZ * CrossZ);
+		return FMath::RadiansToDegrees(2.0 * std::atan2(Imaginary, FMath::Abs(Dot)));
+	}
+
+	/** A random skeleton frame: a root far from the origin, joints close to it, a few scaled joints and curves */
+	void MakeFrame(FRandomStream& Random, int32 NumTransforms, int32 NumCurves, float RootDistance, float CurveRange, TArray<FTransform>& OutTransforms, TArray<FLiveLinkCurveElement>& OutCurves)
+	{
+		OutTransforms.SetNum(NumTransforms);
+		for (int32 Idx = 0; Idx < NumTransforms; ++Idx)
+		{
+			const FQuat Rotation = FQuat(Random.GetUnitVector(), Random.FRandRange(-PI, PI));
+			const float Distance = (Idx == 0) ? RootDistance : 50.f;
+			const FVector Translation = Random.GetUnitVector() * Random.FRandRange(0.f, Distance);
+			const FVector Scale = (Idx % 7 == 3) ? FVector(Random.FRandRange(0.5f, 2.f), Random.FRandRange(0.5f, 2.f), Random.FRandRange(0.5f, 2.f)) : FVector::OneVector;
+			OutTransforms[Idx].SetComponents(Rotation, Translation, Scale);
+		}
+
+		OutCurves.SetNum(NumCurves);
+		for (int32 Idx = 0; Idx < NumCurves; ++Idx)
+		{
+			OutCurves[Idx].CurveName = FName(TEXT("Curve"), Idx);
+			OutCurves[Idx].CurveValue = Random.FRandRange(-CurveRange, CurveRange);
+		}
+	}
+
+	struct FRoundTripErrors
+	{
+		double Translation = 0.0;
+		double Rotation = 0.0;
+		double Scale = 0.0;
+		double Curve = 0.0;
+		int32 FailedDecodes = 0;
+		int32 Bytes = 0;
+	};
+
+	/** Encodes NumFrames random frames of one subject and decodes them again */
+	FRoundTripErrors MeasureRoundTrip(const LiveLinkFrameCodec::FSettings& Settings, int32 Seed, int32 NumFrames, float RootDistance, float CurveRange)
+	{
+		FRandomStream Random(Seed);
+		LiveLinkFrameCodec::FPositionRange Range;
+		FRoundTripErrors Errors;
+
+		TArray<FTransform> Transforms;
+		TArray<FLiveLinkCurveElement> Curves;
+		TArray<uint8> Buffer;
+		TArray<FTransform> DecodedTransforms;
+		TArray<FLiveLinkCurveElement> DecodedCurves;
+
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			MakeFrame(Random, 64, 16, RootDistance, CurveRange, Transforms, Curves);
+
+			Buffer.Reset();
+			LiveLinkFrameCodec::Encode(Transforms, Curves, Settings, Range, Buffer);
+			Errors.Bytes += Buffer.Num();
+
+			if (!LiveLinkFrameCodec::Decode(Buffer.GetData(), Buffer.Num(), DecodedTransforms, DecodedCurves) ||
+				DecodedTransforms.Num() != Transforms.Num() || DecodedCurves.Num() != Curves.Num())
+			{
+				++Errors.FailedDecodes;
+				continue;
+			}
+
+			for (int32 Idx = 0; Idx < Transforms.Num(); ++Idx)
+			{
+				Errors.Translation = FMath::Max<double>(Errors.Translation, FVector::Dist(Transforms[Idx].GetTranslation(), DecodedTransforms[Idx].GetTranslation()));
+				Errors.Rotation = FMath::Max(Errors.Rotation, RotationErrorDegrees(Transforms[Idx].GetRotation(), DecodedTransforms[Idx].GetRotation()));
+				Errors.Scale = FMath::Max<double>(Errors.Scale, (Transforms[Idx].GetScale3D() - DecodedTransforms[Idx].GetScale3D()).GetAbsMax());
+			}
+			for (int32 Idx = 0; Idx < Curves.Num(); ++Idx)
+			{
+				Errors.Curve = FMath::Max<double>(Errors.Curve, FMath::Abs(Curves[Idx].CurveValue - DecodedCurves[Idx].CurveValue));
+			}
+		}
+		return Errors;
+	}
+
+	/** Every error stays within its configured bound, over a spread of bounds and ranges */
+	bool TestFrameCodecRoundTripError()
+	{
+		struct FCase
+		{
+			float MaxPositionError;
+			float MaxRotationError;
+			float MaxCurveError;
+			float RootDistance;
+			float CurveRange;
+		};
+		const FCase Cases[] =
+		{
+			{ 0.01f, 0.01f, 0.001f, 500.f, 1.f },
+			{ 0.1f, 0.1f, 0.01f, 500.f, 1.f },
+			{ 0.0001f, 0.001f, 0.0001f, 500.f, 1.f },
+			// Needs more than 24 bits per axis, translations fall back to raw floats
+			{ 0.00001f, 0.01f, 0.001f, 100000.f, 1.f },
+			// Half floats can't hold these, curves fall back to full floats
+			{ 0.01f, 0.01f, 0.001f, 500.f, 1000.f },
+			{ 0.01f, 0.01f, 0.f, 500.f, 1.f },
+		};
+
+		bool bPassed = true;
+		for (int32 CaseIdx = 0; CaseIdx < ARRAY_COUNT(Cases); ++CaseIdx)
+		{
+			const FCase& Case = Cases[CaseIdx];
+			LiveLinkFrameCodec::FSettings Settings;
+			Settings.Encoding = LiveLinkFrameCodec::EEncoding::Compact;
+			Settings.MaxPositionError = Case.MaxPositionError;
+			Settings.MaxRotationError = Case.MaxRotationError;
+			Settings.MaxCurveError = Case.MaxCurveError;
+
+			const FRoundTripErrors Errors = MeasureRoundTrip(Settings, 1234 + CaseIdx, 200, Case.RootDistance, Case.CurveRange);
+
+			// Translations and range bounds are floats, allow for their rounding on top of the quantization error
+			const double TranslationBound = Case.MaxPositionError + 4.0 * FLT_EPSILON * Case.RootDistance;
+			const bool bCasePassed = Errors.FailedDecodes == 0
+				&& Errors.Translation <= TranslationBound
+				&& Errors.Rotation <= Case.MaxRotationError
+				&& Errors.Scale <= Settings.ScaleTolerance
+				&& Errors.Curve <= Case.MaxCurveError;
+
+			UE_LOG(LogMayaLiveLinkTests, Display, TEXT("  case %d: translation %g (max %g), rotation %g deg (max %g), scale %g, curve %g (max %g), %.1f bytes per frame, %d failed decodes%s"),
+				CaseIdx, Errors.Translation, TranslationBound, Errors.Rotation, Case.MaxRotationError, Errors.Scale, Errors.Curve, Case.MaxCurveError,
+				Errors.Bytes / 200.0, Errors.FailedDecodes, bCasePassed ? TEXT("") : TEXT(" FAILED"));
+			bPassed &= bCasePassed;
+		}
+		return bPassed;
+	}
+
+	/** Once the subject's range covers a pose, encoding that pose again gives the same bytes */
+	bool TestFrameCodecStableRange()
+	{
+		FRandomStream Random(42);
+		TArray<FTransform> Transforms;
+		TArray<FLiveLinkCurveElement> Curves;
+		MakeFrame(Random, 32, 4, 200.f, 1.f, Transforms, Curves);
+
+		LiveLinkFrameCodec::FSettings Settings;
+		Settings.Encoding = LiveLinkFrameCodec::EEncoding::Compact;
+		LiveLinkFrameCodec::FPositionRange Range;
+
+		TArray<uint8> First;
+		TArray<uint8> Second;
+		LiveLinkFrameCodec::Encode(Transforms, Curves, Settings, Range, First);
+
+		// A pose inside the range must not move it
+		Transforms[1].SetTranslation(Transforms[1].GetTranslation() * 0.5f);
+		TArray<uint8> Scratch;
+		const bool bGrewInside = Range.Include(Transforms);
+		LiveLinkFrameCodec::Encode(Transforms, Curves, Settings, Range, Scratch);
+
+		Transforms[1].SetTranslation(Transforms[1].GetTranslation() * 2.0f);
+		LiveLinkFrameCodec::Encode(Transforms, Curves, Settings, Range, Second);
+
+		const bool bPassed = !bGrewInside && First == Second;
+		UE_LOG(LogMayaLiveLinkTests, Display, TEXT("  range grew for an inner pose: %s, repeated pose identical: %s"), bGrewInside ? TEXT("yes") : TEXT("no"), First == Second ? TEXT("yes") : TEXT("no"));
+		return bPassed;
+	}
+
+	/** Truncated and corrupted buffers are rejected instead of read past their end */
+	bool TestFrameCodecRejectsBadInput()
+	{
+		FRandomStream Random(7);
+		TArray<FTransform> Transforms;
+		TArray<FLiveLinkCurveElement> Curves;
+		MakeFrame(Random, 16, 4, 100.f, 1.f, Transforms, Curves);
+
+		LiveLinkFrameCodec::FSettings Settings;
+		Settings.Encoding = LiveLinkFrameCodec::EEncoding::Compact;
+		LiveLinkFrameCodec::FPositionRange Range;
+		TArray<uint8> Buffer;
+		LiveLinkFrameCodec::Encode(Transforms, Curves, Settings, Range, Buffer);
+
+		TArray<FTransform> DecodedTransforms;
+		TArray<FLiveLinkCurveElement> DecodedCurves;
+		int32 NumAccepted = 0;
+		for (int32 Size = 0; Size < Buffer.Num(); ++Size)
+		{
+			NumAccepted += LiveLinkFrameCodec::Decode(Buffer.GetData(), Size, DecodedTransforms, DecodedCurves) ? 1 : 0;
+		}
+
+		TArray<uint8> Corrupted = Buffer;
+		Corrupted[sizeof(uint16) * 2 + 1] = 30;
+		const bool bAcceptedCorrupted = LiveLinkFrameCodec::Decode(Corrupted.GetData(), Corrupted.Num(), DecodedTransforms, DecodedCurves);
+
+		UE_LOG(LogMayaLiveLinkTests, Display, TEXT("  truncated buffers accepted: %d of %d, invalid bit count accepted: %s"), NumAccepted, Buffer.Num(), bAcceptedCorrupted ? TEXT("yes") : TEXT("no"));
+		return NumAccepted == 0 && !bAcceptedCorrupted;
+	}
+
+	/** Frames whose counts don't fit the uint16 header are refused instead of truncated */
+	bool TestFrameCodecRejectsOversizedFrames()
+	{
+		TArray<FTransform> Transforms;
+		Transforms.Init(FTransform::Identity, MAX_uint16 + 1);
+		TArray<FLiveLinkCurveElement> Curves;
+
+		LiveLinkFrameCodec::FSettings Settings;
+		Settings.Encoding = LiveLinkFrameCodec::EEncoding::Compact;
+		LiveLinkFrameCodec::FPositionRange Range;
+		TArray<uint8> Buffer;
+		const bool bEncoded = LiveLinkFrameCodec::Encode(Transforms, Curves, Settings, Range, Buffer);
+		const bool bUntouched = Buffer.Num() == 0 && !Range.bValid;
+
+		Transforms.SetNum(MAX_uint16);
+		const bool bEncodedLimit = LiveLinkFrameCodec::Encode(Transforms, Curves, Settings, Range, Buffer);
+
+		UE_LOG(LogMayaLiveLinkTests, Display, TEXT("  %d transforms encoded: %s, %d transforms encoded: %s"), MAX_uint16 + 1, bEncoded ? TEXT("yes") : TEXT("no"), MAX_uint16, bEncodedLimit ? TEXT("yes") : TEXT("no"));
+		return !bEncoded && bUntouched && bEncodedLimit;
+	}
+
+	// Only initialized for the tests that compare against Maya, the others run without a Maya install
+	bool bMayaInitialized = false;
+
+	bool InitializeMaya()
+	{
+		if (!bMayaInitialized)
+		{
+			bMayaInitialized = MLibrary::initialize("MayaLiveLinkTests") == MS::kSuccess;
+			if (!bMayaInitialized)
+			{
+				UE_LOG(LogMayaLiveLinkTests, Error, TEXT("  unable to initialize the Maya library"));
+			}
+		}
+		return bMayaInitialized;
+	}
+
+	/** A joint's channels, with a share of the negative and non-uniform parent scales the fused kernel has to reject */
+	void MakeJointChannels(FRandomStream& Random, LiveLinkJointMath::ERotationOrder RotationOrder, LiveLinkJointMath::FJointChannels& OutChannels)
+	{
+		auto RandomOrder = [&Random]()
+		{
+			return (LiveLinkJointMath::ERotationOrder)Random.RandRange(0, 5);
+		};
+
+		const bool bUnitScale = Random.FRand() < 0.5f;
+		const bool bNegativeScale = Random.FRand() < 0.05f;
+		const bool bUniformParentScale = Random.FRand() < 0.9f;
+		const double UniformParentScale = Random.FRand() < 0.5f ? 1.0 : Random.FRandRange(0.25f, 4.f);
+
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			OutChannels.Scale[Axis] = bUnitScale ? 1.0 : Random.FRandRange(0.25f, 4.f);
+			OutChannels.ScaleOrientation[Axis] = Random.FRand() < 0.5f ? 0.0 : Random.FRandRange(-PI, PI);
+			OutChannels.Rotation[Axis] = Random.FRandRange(-2.f * PI, 2.f * PI);
+			OutChannels.JointOrientation[Axis] = Random.FRandRange(-PI, PI);
+			OutChannels.Translation[Axis] = Random.FRandRange(-100.f, 100.f);
+			OutChannels.ParentScale[Axis] = bUniformParentScale ? UniformParentScale : Random.FRandRange(0.25f, 4.f);
+		}
+		if (bNegativeScale)
+		{
+			OutChannels.Scale[Random.RandRange(0, 2)] *= -1.0;
+		}
+
+		OutChannels.ScaleOrientationOrder = RandomOrder();
+		OutChannels.RotationOrder = RotationOrder;
+		OutChannels.JointOrientationOrder = RandomOrder();
+	}
+
+	/**
+	* The fused kernel matches the plugin's matrix path (BuildMayaJointMatrix decomposed by MTransformationMatrix) to
+	* float precision for every rotation order, and rejects exactly the joints it can't represent: non-positive scale
+	* and non-uniform parent scale.
+	*/
+	bool TestJointMathMatchesMaya()
+	{
+		if (!InitializeMaya())
+		{
+			return false;
+		}
+
+		const int32 JointsPerOrder = 20000;
+		const double Tolerance = 1e-5;
+
+		FRandomStream Random(2015);
+		bool bPassed = true;
+		for (int32 OrderIdx = 0; OrderIdx < 6; ++OrderIdx)
+		{
+			const LiveLinkJointMath::ERotationOrder RotationOrder = (LiveLinkJointMath::ERotationOrder)OrderIdx;
+
+			int32 NumAccepted = 0;
+			int32 NumWronglyAccepted = 0;
+			int32 NumWronglyRejected = 0;
+			double MaxRotationError = 0.0;
+			double MaxTranslationError = 0.0;
+			double MaxScaleError = 0.0;
+
+			for (int32 JointIdx = 0; JointIdx < JointsPerOrder; ++JointIdx)
+			{
+				LiveLinkJointMath::FJointChannels Channels;
+				MakeJointChannels(Random, RotationOrder, Channels);
+
+				const bool bRepresentable = Channels.Scale[0] > 0.0 && Channels.Scale[1] > 0.0 && Channels.Scale[2] > 0.0 &&
+					Channels.ParentScale[1] == Channels.ParentScale[0] && Channels.ParentScale[2] == Channels.ParentScale[0];
+
+				FTransform Transform;
+				const bool bAccepted = LiveLinkJointMath::BuildUETransform(Channels, Transform);
+				NumWronglyAccepted += (bAccepted && !bRepresentable) ? 1 : 0;
+				NumWronglyRejected += (!bAccepted && bRepresentable) ? 1 : 0;
+				if (!bAccepted || !bRepresentable)
+				{
+					continue;
+				}
+				++NumAccepted;
+
+				const FTransform MatrixPath = BuildUETransformFromMayaTransform(BuildMayaJointMatrix(Channels));
+				const FQuat Rotation = MatrixPath.GetRotation();
+				const FVector Translation = MatrixPath.GetTranslation();
+				const FVector Scale = MatrixPath.GetScale3D();
+
+				// q and -q are the same rotation
+				const FQuat Quat = Transform.GetRotation();
+				const double Sign = (Quat | Rotation) < 0.f ? -1.0 : 1.0;
+				const FVector KernelTranslation = Transform.GetTranslation();
+				const FVector KernelScale = Transform.GetScale3D();
+				for (int32 Idx = 0; Idx < 4; ++Idx)
+				{
+					MaxRotationError = FMath::Max(MaxRotationError, FMath::Abs(Sign * (&Quat.X)[Idx] - (&Rotation.X)[Idx]));
+				}
+				for (int32 Axis = 0; Axis < 3; ++Axis)
+				{
+					MaxTranslationError = FMath::Max<double>(MaxTranslationError, FMath::Abs(KernelTranslation[Axis] - Translation[Axis]) / FMath::Max(1.f, FMath::Abs(Translation[Axis])));
+					MaxScaleError = FMath::Max<double>(MaxScaleError, FMath::Abs(KernelScale[Axis] - Scale[Axis]) / FMath::Abs(Scale[Axis]));
+				}
+			}
+
+			const bool bOrderPassed = NumWronglyAccepted == 0 && NumWronglyRejected == 0 &&
+				MaxRotationError <= Tolerance && MaxTranslationError <= Tolerance && MaxScaleError <= Tolerance;
+			UE_LOG(LogMayaLiveLinkTests, Display, TEXT("  order %d: %d joints compared, max quaternion error %g, relative translation %g, relative scale %g, wrongly accepted %d, wrongly rejected %d%s"),
+				OrderIdx, NumAccepted, MaxRotationError, MaxTranslationError, MaxScaleError, NumWronglyAccepted, NumWronglyRejected, bOrderPassed ? TEXT("") : TEXT(" FAILED"));
+			bPassed &= bOrderPassed;
+		}
+		return bPassed;
+	}
+
+	/** Random Maya matrices, some with non-uniform scale or shear and a few mirrored ones that take the scalar fallback */
+	void MakeMatrices(FRandomStream& Random, int32 NumMatrices, TArray<MMatrix>& OutMatrices, int32& OutNumMirrored)
+	{
+		OutMatrices.SetNum(NumMatrices);
+		OutNumMirrored = 0;
+		for (MMatrix& Matrix : OutMatrices)
+		{
+			MTransformationMatrix Transform;
+
+			const double Rotation[3] = { Random.FRandRange(-PI, PI), Random.FRandRange(-PI, PI), Random.FRandRange(-PI, PI) };
+			Transform.setRotation(Rotation, (MTransformationMatrix::RotationOrder)(MTransformationMatrix::kXYZ + Random.RandRange(0, 5)));
+
+			const bool bUniformScale = Random.FRand() < 0.7f;
+			const double UniformScale = Random.FRandRange(0.25f, 4.f);
+			double Scale[3];
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				Scale[Axis] = bUniformScale ? UniformScale : Random.FRandRange(0.25f, 4.f);
+			}
+			if (Random.FRand() < 0.02f)
+			{
+				Scale[Random.RandRange(0, 2)] *= -1.0;
+				++OutNumMirrored;
+			}
+			Transform.setScale(Scale, MSpace::kTransform);
+
+			if (Random.FRand() < 0.1f)
+			{
+				const double Shear[3] = { Random.FRandRange(-0.5f, 0.5f), Random.FRandRange(-0.5f, 0.5f), Random.FRandRange(-0.5f, 0.5f) };
+				Transform.setShear(Shear, MSpace::kTransform);
+			}
+
+			Transform.setTranslation(MVector(Random.FRandRange(-500.f, 500.f), Random.FRandRange(-500.f, 500.f), Random.FRandRange(-500.f, 500.f)), MSpace::kTransform);
+			Matrix = Transform.asMatrix();
+		}
+	}
+
+	/** Best of a few runs, in seconds */
+	double TimeBestOf(int32 NumRuns, TFunctionRef<void()> Run)
+	{
+		double BestSeconds = DBL_MAX;
+		for (int32 RunIdx = 0; RunIdx < NumRuns; ++RunIdx)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			Run();
+			BestSeconds = FMath::Min(BestSeconds, FPlatformTime::Seconds() - StartTime);
+		}
+		return BestSeconds;
+	}
+
+	/**
+	* Throughput of the batched decomposition (DecomposeBatch plus the scalar fallback for mirrored lanes) against the
+	* scalar MTransformationMatrix path, and the batched path's worst error against it. -matrices=N runs a single size.
+	*/
+	bool TestDecomposeBatchBenchmark()
+	{
+		if (!InitializeMaya())
+		{
+			return false;
+		}
+
+		TArray<int32> Sizes = { 10000, 30000, 100000 };
+		int32 NumMatricesOverride = 0;
+		if (FParse::Value(FCommandLine::Get(), TEXT("-matrices="), NumMatricesOverride) && NumMatricesOverride > 0)
+		{
+			Sizes = { NumMatricesOverride };
+		}
+
+		// Float lanes against a double reference
+		const double MaxRotationErrorDegrees = 0.001;
+		const double MaxRelativeError = 1e-4;
+		const int32 NumRuns = 5;
+
+		FRandomStream Random(4);
+		bool bPassed = true;
+		for (int32 NumMatrices : Sizes)
+		{
+			TArray<MMatrix> Matrices;
+			int32 NumMirrored;
+			MakeMatrices(Random, NumMatrices, Matrices, NumMirrored);
+
+			TArray<FTransform> Scalar;
+			TArray<FTransform> Batched;
+			Scalar.SetNum(NumMatrices);
+			Batched.SetNum(NumMatrices);
+
+			const double ScalarSeconds = TimeBestOf(NumRuns, [&]()
+			{
+				for (int32 Idx = 0; Idx < NumMatrices; ++Idx)
+				{
+					Scalar[Idx] = BuildUETransformFromMayaTransform(Matrices[Idx]);
+				}
+			});
+			const double BatchedSeconds = TimeBestOf(NumRuns, [&]()
+			{
+				BuildUETransformsFromMayaTransforms(Matrices.GetData(), Batched.GetData(), NumMatrices);
+			});
+
+			double RotationError = 0.0;
+			double TranslationError = 0.0;
+			double ScaleError = 0.0;
+			for (int32 Idx = 0; Idx < NumMatrices; ++Idx)
+			{
+				const FVector Translation = Scalar[Idx].GetTranslation();
+				const FVector Scale = Scalar[Idx].GetScale3D();
+				RotationError = FMath::Max(RotationError, RotationErrorDegrees(Batched[Idx].GetRotation(), Scalar[Idx].GetRotation()));
+				TranslationError = FMath::Max<double>(TranslationError, FVector::Dist(Batched[Idx].GetTranslation(), Translation) / FMath::Max(1.f, Translation.GetAbsMax()));
+				ScaleError = FMath::Max<double>(ScaleError, (Batched[Idx].GetScale3D() - Scale).GetAbsMax() / Scale.GetAbsMax());
+			}
+
+			const bool bSizePassed = RotationError <= MaxRotationErrorDegrees && TranslationError <= MaxRelativeError && ScaleError <= MaxRelativeError;
+			UE_LOG(LogMayaLiveLinkTests, Display, TEXT("  %d matrices (%d mirrored): scalar %.2fM/s, batched %.2fM/s (%.1fx), max error rotation %g deg, relative translation %g, relative scale %g%s"),
+				NumMatrices, NumMirrored, NumMatrices / ScalarSeconds / 1e6, NumMatrices / BatchedSeconds / 1e6, ScalarSeconds / BatchedSeconds,
+				RotationError, TranslationError, ScaleError, bSizePassed ? TEXT("") : TEXT(" FAILED"));
+			bPassed &= bSizePassed;
+		}
+		return bPassed;
+	}
+
+	const FTest Tests[] =
+	{
+		{ TEXT("JointMathMatchesMaya"), &TestJointMathMatchesMaya },
+		{ TEXT("DecomposeBatchBenchmark"), &TestDecomposeBatchBenchmark },
+		{ TEXT("FrameCodecRoundTripError"), &TestFrameCodecRoundTripError },
+		{ TEXT("FrameCodecStableRange"), &TestFrameCodecStableRange },
+		{ TEXT("FrameCodecRejectsBadInput"), &TestFrameCodecRejectsBadInput },
+		{ TEXT("FrameCodecRejectsOversizedFrames"), &TestFrameCodecRejectsOversizedFrames },
+	};
+}
+
+INT32_MAIN_INT32_ARGC_TCHAR_ARGV()
+{
+	GEngineLoop.PreInit(ArgC, ArgV);
+
+	// -test=Name runs only the tests whose name contains Name
+	FString Filter;
+	FParse::Value(FCommandLine::Get(), TEXT("-test="), Filter);
+
+	int32 NumFailed = 0;
+	for (const MayaLiveLinkTests::FTest& Test : MayaLiveLinkTests::Tests)
+	{
+		if (!Filter.IsEmpty() && !FString(Test.Name).Contains(Filter))
+		{
+			continue;
+		}
+
+		UE_LOG(LogMayaLiveLinkTests, Display, TEXT("%s"), Test.Name);
+		const bool bPassed = Test.Run();
+		UE_LOG(LogMayaLiveLinkTests, Display, TEXT("%s %s"), Test.Name, bPassed ? TEXT("passed") : TEXT("FAILED"));
+		NumFailed += bPassed ? 0 : 1;
+	}
+
+	if (MayaLiveLinkTests::bMayaInitialized)
+	{
+		MLibrary::cleanup(NumFailed, false);
+	}
+
+	FEngineLoop::AppPreExit();
+	FEngineLoop::AppExit();
+	return NumFailed;
+}
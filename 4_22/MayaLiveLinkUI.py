@@ -10,8 +10,7 @@ import maya.cmds as cmds
 def PopulateSubjects():
 	Subjects = cmds.LiveLinkSubjects()
 	if Subjects is not None:
-		for Subject in cmds.LiveLinkSubjects():
-			cmds.textScrollList("ActiveSubjects", edit = True, append = Subject)
+		cmds.textScrollList("ActiveSubjects", edit = True, append = Subjects)
 
 #Refresh subjects list
 def RefreshSubjects():
@@ -19,6 +18,15 @@ def RefreshSubjects():
 		cmds.textScrollList("ActiveSubjects", edit=True, removeAll=True)
 		PopulateSubjects()
 
+#Refresh the achieved stream rate shown next to the rate setting
+def RefreshStreamRateStatus():
+	TargetRate, EffectiveRate, AchievedRate = cmds.LiveLinkSetOptionStreamRate(query=True)
+	if TargetRate > 0:
+		Status = "streaming at %.1f Hz (adaptive %.1f Hz)" % (AchievedRate, EffectiveRate)
+	else:
+		Status = "streaming at %.1f Hz" % AchievedRate
+	cmds.text("StreamRateStatus", edit=True, label=Status)
+
 #Connection UI Colours
 ConnectionActiveColour = [0.71, 0.9, 0.1]
 ConnectionInactiveColour = [1.0, 0.4, 0.4]
@@ -49,7 +57,7 @@ def GetLiveLinkCommandsFromModule(ModuleItems):
 class MayaLiveLinkUI(LiveLinkCommand):
 	WindowName = "MayaLiveLinkUI"
 	Title = "Maya Live Link UI"
-	WindowSize = (500, 400)
+	WindowSize = (500, 600)
 
 	def __init__(self):
 		LiveLinkCommand.__init__(self)
@@ -78,10 +86,35 @@ class MayaLiveLinkUI(LiveLinkCommand):
 		cmds.button( label='Add Subject', parent = "AddSelectedAsSubject", command=self.AddSubject)
 		cmds.button( label='Remove Subject', parent = "AddSelectedAsSubject", command=self.RemoveSubject)
 
+		cmds.rowLayout("PropHierarchySettings", numberOfColumns=3, parent="mainColumn")
+		cmds.checkBox( "PropHierarchy", label='Add transforms as prop hierarchy', parent="PropHierarchySettings")
+		cmds.checkBox( "PropHierarchyVisibleOnly", label='Visible only', parent="PropHierarchySettings")
+		cmds.checkBox( "PropHierarchyAnimatedOnly", label='Animated only', parent="PropHierarchySettings")
+
+		cmds.rowLayout("SubjectLodSettings", numberOfColumns=3, adjustableColumn=2, parent="mainColumn")
+		cmds.text(label="LOD level (empty = all joints):")
+		cmds.textField( "SubjectLodLevel", text = "", parent = "SubjectLodSettings")
+		cmds.button( label='Set LOD', parent = "SubjectLodSettings", command=self.SetSubjectLod)
+
 		cmds.rowLayout("StreamSettings", numberOfColumns=1, parent="mainColumn")
 		cmds.checkBox( "ToggleCorrectForYUp", label='Correct subject stream for Scene Y-Up', changeCommand=self.ToggleCorrectForYUp, parent="StreamSettings")
 
+		cmds.rowLayout("DeltaStreamSettings", numberOfColumns=1, parent="mainColumn")
+		cmds.checkBox( "ToggleDeltaStreaming", label='Only stream frames that changed', changeCommand=self.ToggleDeltaStreaming, parent="DeltaStreamSettings")
+
+		cmds.rowLayout("StreamRateSettings", numberOfColumns=3, adjustableColumn=3, parent="mainColumn")
+		cmds.text(label="Stream rate (Hz, 0 = viewport redraw):")
+		cmds.intField("StreamRateField", minValue=0, maxValue=240, width=60, changeCommand=self.SetStreamRate, parent="StreamRateSettings")
+		cmds.text("StreamRateStatus", label="", align="left", parent="StreamRateSettings")
+
+		cmds.rowLayout("StatsHeader", numberOfColumns=3, adjustableColumn=1, parent="mainColumn")
+		cmds.text(label="Stream Stats", align="left")
+		cmds.button( label='Refresh Stats', parent = "StatsHeader", command=self.RefreshStats)
+		cmds.button( label='Reset Stats', parent = "StatsHeader", command=self.ResetStats)
+		cmds.scrollField("StreamStats", editable=False, wordWrap=False, height=120, parent="mainColumn")
+
 		self.LoadOptionValues()
+		self.RefreshStats()
 
 		cmds.showWindow( self.WindowName )
 
@@ -90,20 +123,55 @@ class MayaLiveLinkUI(LiveLinkCommand):
 		cmds.checkBox("ToggleCorrectForYUp", e=True, value=correctfory_value)
 		cmds.LiveLinkSetOptionCorrectForYUp(correctfory_value)
 
+		TargetRate, EffectiveRate, AchievedRate = cmds.LiveLinkSetOptionStreamRate(query=True)
+		cmds.intField("StreamRateField", e=True, value=int(TargetRate))
+		RefreshStreamRateStatus()
+
 	def ToggleCorrectForYUp(self, *args):
 		value = cmds.checkBox("ToggleCorrectForYUp", q=True, value=True)
 		cmds.LiveLinkSetOptionCorrectForYUp(value)
 
+	def SetStreamRate(self, *args):
+		value = cmds.intField("StreamRateField", q=True, value=True)
+		cmds.LiveLinkSetOptionStreamRate(rate=value)
+		RefreshStreamRateStatus()
+
+	def ToggleDeltaStreaming(self, *args):
+		value = cmds.checkBox("ToggleDeltaStreaming", q=True, value=True)
+		cmds.LiveLinkSetOptionDeltaStreaming(enable=value)
+
+	def RefreshStats(self, *args):
+		Stats = cmds.LiveLinkStats()
+		cmds.scrollField("StreamStats", edit=True, text="\n".join(Stats) if Stats is not None else "")
+
+	def ResetStats(self, *args):
+		cmds.LiveLinkStats(reset=True)
+		self.RefreshStats()
+
 	def AddSubject(self, *args):
 		Name = cmds.textField("NewSubjectName", query = True, text = True)
-		cmds.LiveLinkAddSubject(Name)
+		PropHierarchy = cmds.checkBox("PropHierarchy", q=True, value=True)
+		VisibleOnly = cmds.checkBox("PropHierarchyVisibleOnly", q=True, value=True)
+		AnimatedOnly = cmds.checkBox("PropHierarchyAnimatedOnly", q=True, value=True)
+		cmds.LiveLinkAddSubject(Name, propHierarchy=PropHierarchy, visibleOnly=VisibleOnly, animatedOnly=AnimatedOnly)
 		RefreshSubjects()
 
 	def RemoveSubject(self, *args):
-		for ItemToRemove in cmds.textScrollList("ActiveSubjects", q=1, si=1):
-			cmds.LiveLinkRemoveSubject(ItemToRemove)
+		SelectedIndices = cmds.textScrollList("ActiveSubjects", q=1, sii=1)
+		if SelectedIndices:
+			# List entries are in the same order as the subject names
+			SubjectNames = cmds.LiveLinkSubjects(names=True)
+			cmds.LiveLinkRemoveSubjects(name=[SubjectNames[Index - 1] for Index in SelectedIndices])
 		RefreshSubjects()
 
+	def SetSubjectLod(self, *args):
+		SelectedIndices = cmds.textScrollList("ActiveSubjects", q=1, sii=1)
+		if SelectedIndices:
+			# The list shows each character's joint count per LOD level, the active level is marked with a *
+			Level = cmds.textField("SubjectLodLevel", query = True, text = True)
+			SubjectNames = cmds.LiveLinkSubjects(names=True)
+			cmds.LiveLinkSetSubjectLod(subject=[SubjectNames[Index - 1] for Index in SelectedIndices], level=Level)
+
 # Command to Refresh the subject UI
 class MayaLiveLinkRefreshUI(LiveLinkCommand):
 	def __init__(self):
@@ -124,6 +192,7 @@ class MayaLiveLinkRefreshConnectionUI(LiveLinkCommand):
 			#Get current connection status
 			ConnectionText, ConnectedState = cmds.LiveLinkConnectionStatus()
 			cmds.text("ConnectionStatusUI", edit=True, label=ConnectionText, backgroundColor=ConnectionColourMap[ConnectedState])
+			RefreshStreamRateStatus()
 
 class MayaLiveLinkGetActiveCamera(LiveLinkCommand):
 	def __init__(self):